@@ -148,7 +148,16 @@ extern void __cpu_copy_user_highpage(struct page *to, struct page *from,
 #define copy_user_highpage(to,from,vaddr,vma)	\
 	__cpu_copy_user_highpage(to, from, vaddr, vma)
 
+#ifdef CONFIG_ARM_NEON_STRING
+extern void clear_page(void *page);
+extern void clear_page_neon(void *page);
+extern void __clear_page_neon(void *page);
+extern void __copy_page_arm(void *to, const void *from);
+extern void copy_page_neon(void *to, const void *from);
+extern void __copy_page_neon(void *to, const void *from);
+#else
 #define clear_page(page)	memset((void *)(page), 0, PAGE_SIZE)
+#endif
 extern void copy_page(void *to, const void *from);
 
 typedef unsigned long pteval_t;
@@ -26,6 +26,22 @@ extern void * memset(void *, int, __kernel_size_t);
 
 extern void __memzero(void *ptr, __kernel_size_t n);
 
+#ifdef CONFIG_ARM_NEON_STRING
+/*
+ * memcpy, memset and __memzero hand large requests to the NEON
+ * versions once boot calibration found them faster, see
+ * arch/arm/lib/string-neon.c.  The __*_neon routines must be called
+ * between kernel_neon_begin() and kernel_neon_end().
+ */
+extern void *__memcpy_arm(void *, const void *, __kernel_size_t);
+extern void *__memset_arm(void *, int, __kernel_size_t);
+extern void __memzero_arm(void *ptr, __kernel_size_t n);
+extern void *memcpy_neon(void *, const void *, __kernel_size_t);
+extern void *memset_neon(void *, int, __kernel_size_t);
+extern void __memcpy_neon(void *, const void *, __kernel_size_t);
+extern void __memset_neon(void *, int, __kernel_size_t);
+#endif
+
 #define memset(p,v,n)							\
 	({								\
 	 	void *__p = (p); size_t __n = n;			\
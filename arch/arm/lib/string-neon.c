@@ -0,0 +1,294 @@
+/*
+ *  linux/arch/arm/lib/string-neon.c
+ *
+ *  NEON memcpy, memset, copy_page and clear_page
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  The ARM routines remain the default.  Once VFP is up each NEON
+ *  routine is timed against its ARM counterpart, and memcpy, memset,
+ *  copy_page and clear_page hand over to it from the smallest size at
+ *  which it was found faster.  Saving the VFP state of the current
+ *  thread is only possible from process context, anything else stays
+ *  on the ARM code.
+ */
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/hardirq.h>
+#include <linux/irqflags.h>
+#include <linux/ktime.h>
+#include <linux/gfp.h>
+#include <linux/mm.h>
+
+#include <asm/neon.h>
+#include <asm/page.h>
+#include <asm/sizes.h>
+
+/*
+ * Smallest request handed to NEON, checked on entry to the ARM routines.
+ * ~0 until calibration, or for good if NEON was not found faster.
+ */
+unsigned long memcpy_neon_min __read_mostly = ~0UL;
+unsigned long memset_neon_min __read_mostly = ~0UL;
+unsigned long copy_page_neon_min __read_mostly = ~0UL;
+unsigned long clear_page_neon_min __read_mostly = ~0UL;
+
+/*
+ * Bytes done per kernel_neon_begin(), bounds the time spent with
+ * preemption disabled.
+ */
+#define NEON_CHUNK	SZ_64K
+
+/* Never below this, kernel_neon_begin() may have 32 registers to save */
+#define NEON_MIN	256
+
+static bool neon_string_disabled __initdata;
+
+static int __init noneon_string_setup(char *str)
+{
+	neon_string_disabled = true;
+	return 1;
+}
+__setup("noneon_string", noneon_string_setup);
+
+/*
+ * Not from interrupt context, nor with interrupts disabled: suspend and
+ * secondary cpu bring-up run that way before VFP access is restored.
+ */
+static inline bool neon_string_usable(void)
+{
+	return !in_interrupt() && !irqs_disabled();
+}
+
+static inline size_t neon_chunk(size_t n)
+{
+	/* keep the tail at least NEON_CHUNK long */
+	return n < 2 * NEON_CHUNK ? n : NEON_CHUNK;
+}
+
+void *memcpy_neon(void *dest, const void *src, size_t n)
+{
+	void *d = dest;
+	size_t len;
+
+	if (!neon_string_usable())
+		return __memcpy_arm(dest, src, n);
+
+	do {
+		len = neon_chunk(n);
+		kernel_neon_begin();
+		__memcpy_neon(d, src, len);
+		kernel_neon_end();
+		d += len;
+		src += len;
+		n -= len;
+	} while (n);
+
+	return dest;
+}
+EXPORT_SYMBOL_GPL(memcpy_neon);
+
+void *memset_neon(void *s, int c, size_t n)
+{
+	void *p = s;
+	size_t len;
+
+	if (!neon_string_usable()) {
+		__memset_arm(s, c, n);
+		return s;
+	}
+
+	do {
+		len = neon_chunk(n);
+		kernel_neon_begin();
+		__memset_neon(p, c, len);
+		kernel_neon_end();
+		p += len;
+		n -= len;
+	} while (n);
+
+	return s;
+}
+EXPORT_SYMBOL_GPL(memset_neon);
+
+void copy_page_neon(void *to, const void *from)
+{
+	if (!neon_string_usable()) {
+		__copy_page_arm(to, from);
+		return;
+	}
+
+	kernel_neon_begin();
+	__copy_page_neon(to, from);
+	kernel_neon_end();
+}
+EXPORT_SYMBOL_GPL(copy_page_neon);
+
+void clear_page_neon(void *page)
+{
+	if (!neon_string_usable()) {
+		__memzero_arm(page, PAGE_SIZE);
+		return;
+	}
+
+	kernel_neon_begin();
+	__clear_page_neon(page);
+	kernel_neon_end();
+}
+EXPORT_SYMBOL_GPL(clear_page_neon);
+
+void clear_page(void *page)
+{
+	if (PAGE_SIZE >= clear_page_neon_min)
+		clear_page_neon(page);
+	else
+		__memzero_arm(page, PAGE_SIZE);
+}
+EXPORT_SYMBOL(clear_page);
+
+EXPORT_SYMBOL_GPL(__memcpy_arm);
+EXPORT_SYMBOL_GPL(__memset_arm);
+EXPORT_SYMBOL_GPL(__memzero_arm);
+EXPORT_SYMBOL_GPL(__copy_page_arm);
+
+/*
+ * Calibration runs on cache-hot buffers of up to 64KB, which measures
+ * the routines rather than the DRAM, and takes the best of a few passes
+ * to leave out interrupts.
+ */
+#define CALIB_MAX	SZ_64K
+#define CALIB_BYTES	SZ_128K
+#define CALIB_PASSES	3
+
+static const size_t calib_sizes[] __initconst = {
+	NEON_MIN, SZ_1K, SZ_4K, SZ_16K, SZ_64K,
+};
+
+enum neon_string_op {
+	OP_MEMCPY,
+	OP_MEMSET,
+	OP_COPY_PAGE,
+	OP_CLEAR_PAGE,
+};
+
+static void __init neon_string_run(enum neon_string_op op, bool neon,
+				   void *dst, void *src, size_t size)
+{
+	switch (op) {
+	case OP_MEMCPY:
+		if (neon)
+			memcpy_neon(dst, src, size);
+		else
+			__memcpy_arm(dst, src, size);
+		break;
+	case OP_MEMSET:
+		if (neon)
+			memset_neon(dst, 0x5a, size);
+		else
+			__memset_arm(dst, 0x5a, size);
+		break;
+	case OP_COPY_PAGE:
+		if (neon)
+			copy_page_neon(dst, src);
+		else
+			__copy_page_arm(dst, src);
+		break;
+	case OP_CLEAR_PAGE:
+		if (neon)
+			clear_page_neon(dst);
+		else
+			__memzero_arm(dst, PAGE_SIZE);
+		break;
+	}
+}
+
+static s64 __init neon_string_time(enum neon_string_op op, bool neon,
+				   void *dst, void *src, size_t size)
+{
+	unsigned int i, pass, loops = CALIB_BYTES / size;
+	s64 ns, best = LLONG_MAX;
+	ktime_t start;
+
+	for (pass = 0; pass < CALIB_PASSES; pass++) {
+		start = ktime_get();
+		for (i = 0; i < loops; i++)
+			neon_string_run(op, neon, dst, src, size);
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		if (ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+static bool __init neon_string_faster(enum neon_string_op op,
+				      void *dst, void *src, size_t size)
+{
+	return neon_string_time(op, true, dst, src, size) <
+	       neon_string_time(op, false, dst, src, size);
+}
+
+/*
+ * The smallest calibration size from which on NEON is faster at every
+ * larger size too, ~0 if it is not faster at the largest
+ */
+static unsigned long __init neon_string_min(enum neon_string_op op,
+					    void *dst, void *src)
+{
+	unsigned long min = ~0UL;
+	int i;
+
+	for (i = ARRAY_SIZE(calib_sizes) - 1; i >= 0; i--) {
+		if (!neon_string_faster(op, dst, src, calib_sizes[i]))
+			break;
+		min = calib_sizes[i];
+	}
+
+	return min;
+}
+
+static void __init neon_string_report(const char *name, unsigned long min)
+{
+	if (min == ~0UL)
+		pr_info("NEON string: %s stays on ARM\n", name);
+	else
+		pr_info("NEON string: %s uses NEON from %lu bytes\n", name, min);
+}
+
+static int __init neon_string_init(void)
+{
+	int order = get_order(CALIB_MAX);
+	void *src, *dst;
+
+	if (neon_string_disabled || !cpu_has_neon())
+		return 0;
+
+	src = (void *)__get_free_pages(GFP_KERNEL, order);
+	dst = (void *)__get_free_pages(GFP_KERNEL, order);
+	if (!src || !dst)
+		goto out;
+
+	memset(src, 0xa5, CALIB_MAX);
+
+	if (neon_string_faster(OP_COPY_PAGE, dst, src, PAGE_SIZE))
+		copy_page_neon_min = PAGE_SIZE;
+	if (neon_string_faster(OP_CLEAR_PAGE, dst, src, PAGE_SIZE))
+		clear_page_neon_min = PAGE_SIZE;
+	memcpy_neon_min = neon_string_min(OP_MEMCPY, dst, src);
+	memset_neon_min = neon_string_min(OP_MEMSET, dst, src);
+
+	neon_string_report("memcpy", memcpy_neon_min);
+	neon_string_report("memset", memset_neon_min);
+	neon_string_report("copy_page", copy_page_neon_min);
+	neon_string_report("clear_page", clear_page_neon_min);
+out:
+	free_pages((unsigned long)dst, order);
+	free_pages((unsigned long)src, order);
+	return 0;
+}
+/* after vfp_init() has set HWCAP_NEON */
+late_initcall_sync(neon_string_init);
@@ -17,11 +17,28 @@
 #include <linux/sched.h>
 #include <linux/hardirq.h> /* for in_atomic() */
 #include <linux/gfp.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
 #include <asm/current.h>
 #include <asm/page.h>
 
+/*
+ * Copies of at least this many bytes go through the kernel memcpy on
+ * pinned pages.  With a write-allocate data cache only large copies
+ * gain enough to pay for the page table walk and mmap_sem.
+ */
+#ifdef CONFIG_CPU_FEROCEON
+#define UACCESS_MEMCPY_MIN	64
+#else
+#define UACCESS_MEMCPY_MIN	1024
+#endif
+
+unsigned long uaccess_memcpy_min __read_mostly = UACCESS_MEMCPY_MIN;
+module_param_named(min_size, uaccess_memcpy_min, ulong, 0644);
+MODULE_PARM_DESC(min_size, "Smallest user copy done with memcpy");
+
 static int
-pin_page_for_write(const void __user *_addr, pte_t **ptep, spinlock_t **ptlp)
+pin_page(const void __user *_addr, int write, pte_t **ptep, spinlock_t **ptlp)
 {
 	unsigned long addr = (unsigned long)_addr;
 	pgd_t *pgd;
@@ -43,8 +60,8 @@ pin_page_for_write(const void __user *_addr, pte_t **ptep, spinlock_t **ptlp)
 		return 0;
 
 	pte = pte_offset_map_lock(current->mm, pmd, addr, &ptl);
-	if (unlikely(!pte_present(*pte) || !pte_young(*pte) ||
-	    !pte_write(*pte) || !pte_dirty(*pte))) {
+	if (unlikely(!pte_present_user(*pte) || !pte_young(*pte) ||
+	    (write && (!pte_write(*pte) || !pte_dirty(*pte))))) {
 		pte_unmap_unlock(pte, ptl);
 		return 0;
 	}
@@ -55,6 +72,9 @@ pin_page_for_write(const void __user *_addr, pte_t **ptep, spinlock_t **ptlp)
 	return 1;
 }
 
+#define pin_page_for_write(addr, ptep, ptlp)	pin_page(addr, 1, ptep, ptlp)
+#define pin_page_for_read(addr, ptep, ptlp)	pin_page(addr, 0, ptep, ptlp)
+
 static unsigned long noinline
 __copy_to_user_memcpy(void __user *to, const void *from, unsigned long n)
 {
@@ -112,10 +132,70 @@ __copy_to_user(void __user *to, const void *from, unsigned long n)
 	 * With frame pointer disabled, tail call optimization kicks in
 	 * as well making this test almost invisible.
 	 */
-	if (n < 64)
+	if (n < uaccess_memcpy_min)
 		return __copy_to_user_std(to, from, n);
 	return __copy_to_user_memcpy(to, from, n);
 }
+
+static unsigned long noinline
+__copy_from_user_memcpy(void *to, const void __user *from, unsigned long n)
+{
+	int atomic;
+
+	if (unlikely(segment_eq(get_fs(), KERNEL_DS))) {
+		memcpy(to, (const void *)from, n);
+		return 0;
+	}
+
+	/* the mmap semaphore is taken only if not in an atomic context */
+	atomic = in_atomic();
+
+	if (!atomic)
+		down_read(&current->mm->mmap_sem);
+	while (n) {
+		pte_t *pte;
+		spinlock_t *ptl;
+		int tocopy;
+		char c;
+
+		while (!pin_page_for_read(from, &pte, &ptl)) {
+			if (!atomic)
+				up_read(&current->mm->mmap_sem);
+			if (__get_user(c, (const char __user *)from))
+				goto out;
+			if (!atomic)
+				down_read(&current->mm->mmap_sem);
+		}
+
+		tocopy = (~(unsigned long)from & ~PAGE_MASK) + 1;
+		if (tocopy > n)
+			tocopy = n;
+
+		memcpy(to, (const void *)from, tocopy);
+		to += tocopy;
+		from += tocopy;
+		n -= tocopy;
+
+		pte_unmap_unlock(pte, ptl);
+	}
+	if (!atomic)
+		up_read(&current->mm->mmap_sem);
+
+out:
+	/* as the assembly version does, clear what could not be copied */
+	if (n)
+		memset(to, 0, n);
+	return n;
+}
+
+unsigned long
+__copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+	/* See rational for this in __copy_to_user() above. */
+	if (n < uaccess_memcpy_min)
+		return __copy_from_user_std(to, from, n);
+	return __copy_from_user_memcpy(to, from, n);
+}
 	
 static unsigned long noinline
 __clear_user_memset(void __user *addr, unsigned long n)
@@ -157,7 +237,7 @@ out:
 unsigned long __clear_user(void __user *addr, unsigned long n)
 {
 	/* See rational for this in __copy_to_user() above. */
-	if (n < 64)
+	if (n < uaccess_memcpy_min)
 		return __clear_user_std(addr, n);
 	return __clear_user_memset(addr, n);
 }
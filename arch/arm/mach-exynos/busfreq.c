@@ -64,6 +64,7 @@ const char *const cpufreq_lock_name[DVFS_LOCK_ID_END] = {
 	[DVFS_LOCK_ID_CAM] = "CAM",
 	[DVFS_LOCK_ID_PM] = "PM",
 	[DVFS_LOCK_ID_USER] = "USER",
+	[DVFS_LOCK_ID_BOOST] = "BOOST",
 };
 
 static DEFINE_MUTEX(set_bus_freq_lock);
@@ -0,0 +1,196 @@
+/* linux/arch/arm/mach-exynos/cpufreq-boost.c
+ *
+ * EXYNOS - Bus and CPU hotplug boost following the interactive governor
+ *
+ * The interactive governor raises cpufreq on input, boostpulse and
+ * hispeed events. The busfreq monitor and the hotplug policy would otherwise
+ * follow only after their own sampling periods, so the boost is
+ * forwarded here and the bus level and the number of online cores are
+ * raised at once for the duration of the boost.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/platform_device.h>
+#include <linux/workqueue.h>
+#include <linux/cpufreq_interactive.h>
+
+#include <trace/events/cpufreq_interactive.h>
+
+#include <mach/cpufreq.h>
+#ifdef CONFIG_BUSFREQ_OPP
+#include <mach/dev.h>
+#endif
+
+/* Cores brought online by a boost, 0 leaves hotplug alone */
+static unsigned int boost_cpus = 2;
+module_param(boost_cpus, uint, 0644);
+MODULE_PARM_DESC(boost_cpus, "Minimum online CPUs while boosted");
+
+#ifdef CONFIG_BUSFREQ_OPP
+/* MIF/INT pair, same encoding as the busfreq OPP table */
+static unsigned int boost_bus_freq = 400200;
+module_param(boost_bus_freq, uint, 0644);
+MODULE_PARM_DESC(boost_bus_freq, "Bus OPP frequency while boosted, 0 to disable");
+#elif defined(CONFIG_BUSFREQ)
+static bool boost_bus = true;
+module_param(boost_bus, bool, 0644);
+MODULE_PARM_DESC(boost_bus, "Lock busfreq to the highest level while boosted");
+#endif
+
+static struct workqueue_struct *boost_wq;
+static struct work_struct boost_work;
+static struct delayed_work unboost_work;
+static DEFINE_MUTEX(boost_lock);
+
+static struct platform_device *boost_pdev;
+#ifdef CONFIG_BUSFREQ_OPP
+static struct device *bus_dev;
+#endif
+
+/*
+ * Set from an atomic notifier on any CPU, so kept to one word each.  The
+ * start stamp is the low bits of the microsecond clock, the ramp times
+ * taken from it stay right across a wrap.
+ */
+static unsigned long boost_start_us;
+static unsigned long boost_duration_us;
+static bool bus_boosted;
+
+static void boost_trace_ramp(const char *stage)
+{
+	trace_cpufreq_interactive_boost_ramp(stage,
+		(unsigned long)ktime_to_us(ktime_get()) -
+		ACCESS_ONCE(boost_start_us));
+}
+
+static void exynos_boost_bus(void)
+{
+#ifdef CONFIG_BUSFREQ_OPP
+	if (!boost_bus_freq || IS_ERR_OR_NULL(bus_dev))
+		return;
+
+	if (!dev_lock(bus_dev, &boost_pdev->dev, boost_bus_freq))
+		bus_boosted = true;
+#elif defined(CONFIG_BUSFREQ)
+	if (!boost_bus || bus_boosted)
+		return;
+
+	if (!exynos4_busfreq_lock(DVFS_LOCK_ID_BOOST, BUS_L0))
+		bus_boosted = true;
+#endif
+	if (bus_boosted)
+		boost_trace_ramp("bus");
+}
+
+static void exynos_unboost_bus(void)
+{
+	if (!bus_boosted)
+		return;
+
+#ifdef CONFIG_BUSFREQ_OPP
+	dev_unlock(bus_dev, &boost_pdev->dev);
+#elif defined(CONFIG_BUSFREQ)
+	exynos4_busfreq_lock_free(DVFS_LOCK_ID_BOOST);
+#endif
+	bus_boosted = false;
+}
+
+static void exynos_boost_cores(void)
+{
+	unsigned int cpu, target;
+	bool changed = false;
+
+	target = min(boost_cpus, exynos_cpu_hotplug_max());
+
+	for_each_present_cpu(cpu) {
+		if (num_online_cpus() >= target)
+			break;
+		if (cpu_online(cpu))
+			continue;
+		if (!cpu_up(cpu))
+			changed = true;
+	}
+
+	if (changed)
+		boost_trace_ramp("cores");
+}
+
+static void exynos_boost_work(struct work_struct *work)
+{
+	mutex_lock(&boost_lock);
+
+	exynos_boost_bus();
+	exynos_boost_cores();
+
+	/* a later boost pushes the release further out */
+	cancel_delayed_work(&unboost_work);
+	queue_delayed_work(boost_wq, &unboost_work,
+			   usecs_to_jiffies(ACCESS_ONCE(boost_duration_us)));
+
+	mutex_unlock(&boost_lock);
+}
+
+/*
+ * Extra cores are not taken down here, the hotplug policy removes them
+ * once load and frequency drop again.
+ */
+static void exynos_unboost_work(struct work_struct *work)
+{
+	mutex_lock(&boost_lock);
+	exynos_unboost_bus();
+	mutex_unlock(&boost_lock);
+}
+
+static int exynos_boost_notifier(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	struct cpufreq_interactive_boost *boost = data;
+
+	if (event != INTERACTIVE_BOOST_START)
+		return NOTIFY_DONE;
+
+	ACCESS_ONCE(boost_start_us) = (unsigned long)boost->start_us;
+	ACCESS_ONCE(boost_duration_us) = boost->duration_us;
+	queue_work(boost_wq, &boost_work);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block exynos_boost_nb = {
+	.notifier_call = exynos_boost_notifier,
+};
+
+static int __init exynos_cpufreq_boost_init(void)
+{
+	boost_wq = alloc_workqueue("exynos_boost", WQ_HIGHPRI, 1);
+	if (!boost_wq)
+		return -ENOMEM;
+
+	INIT_WORK(&boost_work, exynos_boost_work);
+	INIT_DELAYED_WORK(&unboost_work, exynos_unboost_work);
+
+	boost_pdev = platform_device_register_simple("exynos-boost", -1,
+						     NULL, 0);
+	if (IS_ERR(boost_pdev)) {
+		destroy_workqueue(boost_wq);
+		return PTR_ERR(boost_pdev);
+	}
+
+#ifdef CONFIG_BUSFREQ_OPP
+	bus_dev = dev_get("exynos-busfreq");
+	if (IS_ERR(bus_dev))
+		pr_info("%s: no busfreq device, bus boost disabled\n", __func__);
+#endif
+
+	return cpufreq_interactive_register_boost_notifier(&exynos_boost_nb);
+}
+late_initcall(exynos_cpufreq_boost_init);
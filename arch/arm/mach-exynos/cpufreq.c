@@ -22,6 +22,7 @@
 #include <linux/reboot.h>
 #include <linux/pm_qos_params.h>
 #include <linux/sysfs_helpers.h>
+#include <linux/cpu.h>
 
 #include <mach/map.h>
 #include <mach/regs-clock.h>
@@ -455,6 +456,78 @@ void exynos_cpufreq_upper_limit_free(unsigned int nId)
 	mutex_unlock(&set_cpu_freq_lock);
 }
 
+static DEFINE_MUTEX(hotplug_limit_lock);
+static unsigned int g_hotplug_limit_val[DVFS_LOCK_ID_END];
+static unsigned int g_hotplug_max_cpus = NR_CPUS;
+
+/*
+ * exynos_cpu_hotplug_limit - bound the number of online CPUs.
+ *
+ * The lowest request among all IDs wins. CPUs above the bound are taken
+ * offline right away, and the hotplug policies will not bring them back
+ * until the request is freed. A max_cpus of 0 frees the request.
+ */
+int exynos_cpu_hotplug_limit(unsigned int nId, unsigned int max_cpus)
+{
+	unsigned int i, limit = NR_CPUS;
+	int cpu, ret = 0;
+
+	if (nId >= DVFS_LOCK_ID_END)
+		return -EINVAL;
+
+	mutex_lock(&hotplug_limit_lock);
+	g_hotplug_limit_val[nId] = max_cpus;
+	for (i = 0; i < DVFS_LOCK_ID_END; i++) {
+		if (g_hotplug_limit_val[i] && g_hotplug_limit_val[i] < limit)
+			limit = g_hotplug_limit_val[i];
+	}
+	g_hotplug_max_cpus = limit;
+
+	for (cpu = nr_cpu_ids - 1; cpu > 0; cpu--) {
+		if (num_online_cpus() <= limit)
+			break;
+		if (cpu_online(cpu)) {
+			ret = cpu_down(cpu);
+			if (ret)
+				break;
+		}
+	}
+	mutex_unlock(&hotplug_limit_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(exynos_cpu_hotplug_limit);
+
+void exynos_cpu_hotplug_limit_free(unsigned int nId)
+{
+	exynos_cpu_hotplug_limit(nId, 0);
+}
+EXPORT_SYMBOL_GPL(exynos_cpu_hotplug_limit_free);
+
+unsigned int exynos_cpu_hotplug_max(void)
+{
+	return ACCESS_ONCE(g_hotplug_max_cpus);
+}
+EXPORT_SYMBOL_GPL(exynos_cpu_hotplug_max);
+
+/*
+ * exynos_cpu_hotplug_up - bring a CPU online within the hotplug limit.
+ *
+ * For the hotplug policies, which run from the cpufreq transition
+ * notifier. hotplug_limit_lock is held across cpu_down(), whose cpufreq
+ * callbacks take the policy locks, so it is not taken here and a limit
+ * lowered meanwhile may be exceeded by one CPU until it is next applied.
+ * Returns -EBUSY at the limit.
+ */
+int exynos_cpu_hotplug_up(unsigned int cpu)
+{
+	if (num_online_cpus() >= exynos_cpu_hotplug_max())
+		return -EBUSY;
+
+	return cpu_up(cpu);
+}
+EXPORT_SYMBOL_GPL(exynos_cpu_hotplug_up);
+
 /* This API serve highest priority level locking */
 int exynos_cpufreq_level_fix(unsigned int freq)
 {
@@ -19,6 +19,8 @@
 #include <linux/suspend.h>
 #include <linux/io.h>
 
+#include <mach/cpufreq.h>
+
 #include <plat/cpu.h>
 
 static unsigned int total_num_target_freq;
@@ -41,17 +43,17 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 		if (soc_is_exynos4412()) {
 			if (cpu_online(3) == 0) {
 				if (consecutv_highestlevel_cnt >= 5) {
-					cpu_up(3);
+					exynos_cpu_hotplug_up(3);
 					consecutv_highestlevel_cnt = 0;
 				}
 			} else if (cpu_online(2) == 0) {
 				if (consecutv_highestlevel_cnt >= 5) {
-					cpu_up(2);
+					exynos_cpu_hotplug_up(2);
 					consecutv_highestlevel_cnt = 0;
 				}
 			} else if (cpu_online(1) == 0) {
 				if (consecutv_highestlevel_cnt >= 5) {
-					cpu_up(1);
+					exynos_cpu_hotplug_up(1);
 					consecutv_highestlevel_cnt = 0;
 				}
 			}
@@ -59,7 +61,7 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 		} else {
 			if (cpu_online(1) == 0) {
 				if (consecutv_highestlevel_cnt >= 5) {
-					cpu_up(1);
+					exynos_cpu_hotplug_up(1);
 					consecutv_highestlevel_cnt = 0;
 				}
 			}
@@ -19,6 +19,8 @@
 #include <linux/suspend.h>
 #include <linux/io.h>
 
+#include <mach/cpufreq.h>
+
 #include <plat/cpu.h>
 
 static unsigned int total_num_target_freq;
@@ -89,7 +91,7 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 			if ((ctn_nr_running_over2 >= 4) &&
 			   (ctn_freq_in_trg_cnt >= 5)) {
 				/* over 400ms for nr_running(), over 500ms for frequency, tunnable */
-				cpu_up(3);
+				exynos_cpu_hotplug_up(3);
 				ctn_freq_in_trg_cnt = 0;
 			}
 		} else if ((cpu_online(2) == 0) && (nr_running() >= 3) &&
@@ -97,7 +99,7 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 			if ((ctn_nr_running_over3 >= 4) &&
 			   (ctn_freq_in_trg_cnt >= 5)) {
 				/* over 400ms for nr_running(), over 500ms for frequency, tunnable */
-				cpu_up(2);
+				exynos_cpu_hotplug_up(2);
 				ctn_freq_in_trg_cnt = 0;
 			}
 		} else if ((cpu_online(1) == 0) && (nr_running() >= 4) &&
@@ -105,7 +107,7 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 			if ((ctn_nr_running_over4 >= 8) &&
 			   (ctn_freq_in_trg_cnt >= 5)) {
 				/* over 800ms for nr_running(), over 500ms for frequency, tunnable */
-				cpu_up(1);
+				exynos_cpu_hotplug_up(1);
 				ctn_freq_in_trg_cnt = 0;
 			}
 		}
@@ -115,7 +117,7 @@ static void exynos4_integrated_dvfs_hotplug(unsigned int freq_old,
 			if ((ctn_nr_running_over2 >= 8) &&
 			   (ctn_freq_in_trg_cnt >= 5)) {
 				/* over 800ms  for nr_running(), over 500ms for frequency, tunnable */
-				cpu_up(1);
+				exynos_cpu_hotplug_up(1);
 				ctn_nr_running_over2 = 0;
 				ctn_freq_in_trg_cnt = 0;
 			}
@@ -45,6 +45,7 @@ enum cpufreq_lock_ID {
 	DVFS_LOCK_ID_LPA,	/* LPA */
 	DVFS_LOCK_ID_DRM,	/* DRM */
 	DVFS_LOCK_ID_G3D,	/* G3D */
+	DVFS_LOCK_ID_BOOST,	/* interactive boost */
 	DVFS_LOCK_ID_END,
 };
 
@@ -64,6 +65,15 @@ int exynos_cpufreq_upper_limit(unsigned int nId,
 			enum cpufreq_level_index cpufreq_level);
 void exynos_cpufreq_upper_limit_free(unsigned int nId);
 
+/*
+ * Upper bound on the number of online CPUs, honoured by the
+ * CPU hotplug policies. It uses the same lock IDs as above.
+ */
+int exynos_cpu_hotplug_limit(unsigned int nId, unsigned int max_cpus);
+void exynos_cpu_hotplug_limit_free(unsigned int nId);
+unsigned int exynos_cpu_hotplug_max(void);
+int exynos_cpu_hotplug_up(unsigned int cpu);
+
 /*
  * This level fix API set highset priority level lock.
  * Please use this carefully, with other lock API
@@ -50,4 +50,10 @@
 #define MCT_L_TCON_INT_START		(1 << 1)
 #define MCT_L_TCON_TIMER_START		(1 << 0)
 
+#define MCT_L_WSTAT_TCNTB		(1 << 0)
+#define MCT_L_WSTAT_ICNTB		(1 << 1)
+#define MCT_L_WSTAT_TCON		(1 << 3)
+#define MCT_L_WSTAT_ALL			(MCT_L_WSTAT_TCNTB | MCT_L_WSTAT_ICNTB | \
+					 MCT_L_WSTAT_TCON)
+
 #endif /* __ASM_ARCH_REGS_MCT_H */
@@ -66,6 +66,33 @@ struct temp_compensate_params {
 };
 #endif
 
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+/*
+ * Gains of the thermal controller, in per-mille of the full cooling
+ * demand per degree (kp), per degree and sample (ki) and per degree of
+ * change between samples (kd). Zero selects the driver default.
+ */
+struct thermal_pid_params {
+	unsigned int target_temp;
+	unsigned int kp;
+	unsigned int ki;
+	unsigned int kd;
+};
+
+#define TMU_PID_DEMAND_MAX	1000
+#define TMU_PID_MAX_LEVELS	21
+
+struct tmu_pid_state {
+	int integral;
+	int last_err;
+	unsigned int demand;
+	unsigned int cpu_level;		/* 0 when not capped */
+	unsigned int max_cpus;		/* 0 when not limited */
+	unsigned int nr_levels;
+	unsigned int levels[TMU_PID_MAX_LEVELS];
+};
+#endif
+
 struct memory_params {
 	unsigned int rclk;
 	unsigned int period_bank_refresh;
@@ -75,6 +102,9 @@ struct tmu_data {
 	struct temperature_params ts;
 	struct cpufreq_params cpulimit;
 	struct memory_params mp;
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	struct thermal_pid_params pid;
+#endif
 	unsigned int efuse_value;
 	unsigned int slope;
 	int mode;
@@ -89,6 +119,7 @@ struct tmu_info {
 	struct device	*dev;
 	struct resource *ioarea;
 	int irq;
+	bool irq_disabled;
 
 	unsigned int te1; /* triminfo_25 */
 	unsigned int te2; /* triminfo_85 */
@@ -107,6 +138,11 @@ struct tmu_info {
 	unsigned int busfreq_tc;
 	unsigned int g3dlevel_tc;
 
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	struct tmu_pid_state pid;
+	struct work_struct pid_hotplug;	/* applies pid.max_cpus */
+#endif
+
 	struct delayed_work polling;
 	struct delayed_work monitor;
 	unsigned int reg_save[TMU_SAVE_NUM];
@@ -115,6 +151,23 @@ struct tmu_info {
 #endif
 };
 
+/*
+ * Thermal notifications, sent from the TMU polling work on every sample
+ * with a struct tmu_notify_data. fan_level is the share of the cooling
+ * demand the controller assigns to an active cooler, 0 ~ TMU_FAN_LEVEL_MAX.
+ */
+#define TMU_NOTIFY_SAMPLE	1
+#define TMU_FAN_LEVEL_MAX	255
+
+struct tmu_notify_data {
+	int temperature;
+	unsigned int fan_level;
+};
+
+struct notifier_block;
+int exynos_tmu_register_notifier(struct notifier_block *nb);
+int exynos_tmu_unregister_notifier(struct notifier_block *nb);
+
 void exynos_tmu_set_platdata(struct tmu_data *pd);
 struct tmu_info *exynos_tmu_get_platdata(void);
 int exynos_tmu_get_irqno(int num);
@@ -27,6 +27,7 @@
 
 #include <asm/mach/time.h>
 #include <asm/hardware/gic.h>
+#include <asm/sched_clock.h>
 
 #define TICK_BASE_CNT 1
 
@@ -39,9 +40,16 @@ static unsigned long clk_cnt_per_tick;
 static unsigned long clk_rate;
 static unsigned int mct_int_type;
 
+/*
+ * tcon mirrors L_TCON so the tick paths need not read it back, and
+ * wstat_pending holds the L_WSTAT bits of writes whose completion has
+ * not been collected yet.
+ */
 struct mct_clock_event_device {
 	struct clock_event_device *evt;
 	void __iomem *base;
+	u32 tcon;
+	u32 wstat_pending;
 	char name[10];
 };
 
@@ -127,7 +135,7 @@ static void exynos4_mct_frc_start(u32 hi, u32 lo)
 	exynos4_mct_write(reg, EXYNOS4_MCT_G_TCON);
 }
 
-static cycle_t notrace exynos4_frc_read(struct clocksource *cs)
+static cycle_t exynos4_frc_read64(void)
 {
 	unsigned int lo, hi;
 	u32 hi2 = __raw_readl(EXYNOS4_MCT_G_CNT_U);
@@ -141,11 +149,21 @@ static cycle_t notrace exynos4_frc_read(struct clocksource *cs)
 	return ((cycle_t)hi << 32) | lo;
 }
 
+/*
+ * The timekeeping core copes with a wrapping counter, so the clocksource
+ * only needs the lower word of the FRC. That saves the hi/lo/hi retry
+ * loop on every clock read.
+ */
+static cycle_t notrace exynos4_frc_read(struct clocksource *cs)
+{
+	return __raw_readl(EXYNOS4_MCT_G_CNT_L);
+}
+
 cycle_t suspended_frc_count;
 
 static void exynos4_frc_suspend(struct clocksource *cs)
 {
-	suspended_frc_count = cs->read(cs);
+	suspended_frc_count = exynos4_frc_read64();
 }
 
 static void exynos4_frc_resume(struct clocksource *cs)
@@ -157,17 +175,35 @@ struct clocksource mct_frc = {
 	.name		= "mct-frc",
 	.rating		= 400,
 	.read		= exynos4_frc_read,
-	.mask		= CLOCKSOURCE_MASK(64),
-	.flags		= CLOCK_SOURCE_IS_CONTINUOUS |
-			  CLOCK_SOURCE_SCHED_CLOCK,
+	.mask		= CLOCKSOURCE_MASK(32),
+	.flags		= CLOCK_SOURCE_IS_CONTINUOUS,
 	.suspend	= exynos4_frc_suspend,
 	.resume		= exynos4_frc_resume,
 };
 
+/*
+ * Override the global weak sched_clock symbol with the lower word of
+ * the FRC, which gives a single register read per call.
+ */
+static DEFINE_CLOCK_DATA(cd);
+
+unsigned long long notrace sched_clock(void)
+{
+	return cyc_to_sched_clock(&cd, __raw_readl(EXYNOS4_MCT_G_CNT_L),
+				  (u32)~0);
+}
+
+static void notrace exynos4_update_sched_clock(void)
+{
+	update_sched_clock(&cd, __raw_readl(EXYNOS4_MCT_G_CNT_L), (u32)~0);
+}
+
 static void __init exynos4_clocksource_init(void)
 {
 	exynos4_mct_frc_start(0, 0);
 
+	init_sched_clock(&cd, exynos4_update_sched_clock, 32, clk_rate);
+
 	if (clocksource_register_hz(&mct_frc, clk_rate))
 		panic("%s: can't register clocksource\n", mct_frc.name);
 }
@@ -196,7 +232,7 @@ static void exynos4_mct_comp0_start(enum clock_event_mode mode,
 		exynos4_mct_write(cycles, EXYNOS4_MCT_G_COMP0_ADD_INCR);
 	}
 
-	comp_cycle = exynos4_frc_read(&mct_frc) + cycles;
+	comp_cycle = exynos4_frc_read64() + cycles;
 	exynos4_mct_write((u32)comp_cycle, EXYNOS4_MCT_G_COMP0_L);
 	exynos4_mct_write((u32)(comp_cycle >> 32), EXYNOS4_MCT_G_COMP0_U);
 
@@ -275,16 +311,66 @@ static void exynos4_clockevent_init(void)
 
 #ifdef CONFIG_LOCAL_TIMERS
 /* Clock event handling */
+/*
+ * Collect the write status of every posted local timer write with a
+ * single poll and a single clear, instead of waiting after each write.
+ */
+static void exynos4_mct_tick_sync(struct mct_clock_event_device *mevt)
+{
+	void __iomem *stat_addr = mevt->base + MCT_L_WSTAT_OFFSET;
+	u32 mask = mevt->wstat_pending;
+	u32 i;
+
+	if (!mask)
+		return;
+
+	for (i = 0; i < 0x1000; i++)
+		if ((__raw_readl(stat_addr) & mask) == mask) {
+			__raw_writel(mask, stat_addr);
+			mevt->wstat_pending = 0;
+			return;
+		}
+
+	panic("MCT hangs waiting for local timer write status 0x%x (base:0x%08x)\n",
+	      mask, (u32)mevt->base);
+}
+
+/*
+ * Post a write to a local timer register. A previous write to the same
+ * register must have landed before it may be written again.
+ */
+static void exynos4_mct_tick_write(struct mct_clock_event_device *mevt,
+				   unsigned int value, unsigned long offset,
+				   u32 wstat)
+{
+	if (mevt->wstat_pending & wstat)
+		exynos4_mct_tick_sync(mevt);
+
+	__raw_writel(value, mevt->base + offset);
+	mevt->wstat_pending |= wstat;
+}
+
+/* Resynchronize the software state with the hardware after a reset */
+static void exynos4_mct_tick_reset(struct mct_clock_event_device *mevt)
+{
+	__raw_writel(MCT_L_WSTAT_ALL, mevt->base + MCT_L_WSTAT_OFFSET);
+	mevt->wstat_pending = 0;
+	mevt->tcon = __raw_readl(mevt->base + MCT_L_TCON_OFFSET);
+
+	exynos4_mct_write(TICK_BASE_CNT, mevt->base + MCT_L_TCNTB_OFFSET);
+
+	/* the tick interrupt stays enabled, only TCON gates it */
+	__raw_writel(0x1, mevt->base + MCT_L_INT_ENB_OFFSET);
+}
+
 static void exynos4_mct_tick_stop(struct mct_clock_event_device *mevt)
 {
-	unsigned long tmp;
 	unsigned long mask = MCT_L_TCON_INT_START | MCT_L_TCON_TIMER_START;
-	void __iomem *addr = mevt->base + MCT_L_TCON_OFFSET;
 
-	tmp = __raw_readl(addr);
-	if (tmp & mask) {
-		tmp &= ~mask;
-		exynos4_mct_write(tmp, addr);
+	if (mevt->tcon & mask) {
+		mevt->tcon &= ~mask;
+		exynos4_mct_tick_write(mevt, mevt->tcon, MCT_L_TCON_OFFSET,
+				       MCT_L_WSTAT_TCON);
 	}
 }
 
@@ -298,15 +384,20 @@ static void exynos4_mct_tick_start(unsigned long cycles,
 	tmp = (1 << 31) | cycles;	/* MCT_L_UPDATE_ICNTB */
 
 	/* update interrupt count buffer */
-	exynos4_mct_write(tmp, mevt->base + MCT_L_ICNTB_OFFSET);
+	exynos4_mct_tick_write(mevt, tmp, MCT_L_ICNTB_OFFSET,
+			       MCT_L_WSTAT_ICNTB);
 
-	/* enable MCT tick interrupt */
-	exynos4_mct_write(0x1, mevt->base + MCT_L_INT_ENB_OFFSET);
+	/*
+	 * The stop and the new count must both have landed before the
+	 * timer is restarted. The start itself is collected lazily on the
+	 * next reprogramming, by when it has long completed.
+	 */
+	exynos4_mct_tick_sync(mevt);
 
-	tmp = __raw_readl(mevt->base + MCT_L_TCON_OFFSET);
-	tmp |= MCT_L_TCON_INT_START | MCT_L_TCON_TIMER_START |
-	       MCT_L_TCON_INTERVAL_MODE;
-	exynos4_mct_write(tmp, mevt->base + MCT_L_TCON_OFFSET);
+	mevt->tcon |= MCT_L_TCON_INT_START | MCT_L_TCON_TIMER_START |
+		      MCT_L_TCON_INTERVAL_MODE;
+	exynos4_mct_tick_write(mevt, mevt->tcon, MCT_L_TCON_OFFSET,
+			       MCT_L_WSTAT_TCON);
 }
 
 static int exynos4_tick_set_next_event(unsigned long cycles,
@@ -325,6 +416,9 @@ static inline void exynos4_tick_set_mode(enum clock_event_mode mode,
 {
 	struct mct_clock_event_device *mevt = &mct_tick[smp_processor_id()];
 
+	if (mode == CLOCK_EVT_MODE_RESUME)
+		exynos4_mct_tick_reset(mevt);
+
 	exynos4_mct_tick_stop(mevt);
 
 	switch (mode) {
@@ -339,7 +433,6 @@ static inline void exynos4_tick_set_mode(enum clock_event_mode mode,
 		break;
 
 	case CLOCK_EVT_MODE_RESUME:
-		exynos4_mct_write(TICK_BASE_CNT, mevt->base + MCT_L_TCNTB_OFFSET);
 		break;
 	}
 }
@@ -401,6 +494,7 @@ static void exynos4_mct_tick_init(struct clock_event_device *evt)
 	mct_tick[cpu].evt = evt;
 
 	mct_tick[cpu].base = EXYNOS4_MCT_L_BASE(cpu);
+	exynos4_mct_tick_reset(&mct_tick[cpu]);
 	sprintf(mct_tick[cpu].name, "mct_tick%d", cpu);
 
 	evt->name = mct_tick[cpu].name;
@@ -418,8 +512,6 @@ static void exynos4_mct_tick_init(struct clock_event_device *evt)
 
 	clockevents_register_device(evt);
 
-	exynos4_mct_write(TICK_BASE_CNT, mct_tick[cpu].base + MCT_L_TCNTB_OFFSET);
-
 	if (mct_int_type == MCT_INT_SPI) {
 		if (cpu == 0) {
 			mct_tick0_event_irq.dev_id = &mct_tick[cpu];
@@ -0,0 +1,156 @@
+/* linux/arch/arm/mach-exynos/mct_perf.c
+ *
+ * EXYNOS4 MCT(Multi-Core Timer) performance test
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/time.h>
+#include <linux/math64.h>
+#include <linux/err.h>
+
+static unsigned int try_cnt = 10000;
+module_param(try_cnt, uint, S_IRUGO);
+MODULE_PARM_DESC(try_cnt, "Try count to test");
+
+static unsigned int sleep_us = 100;
+module_param(sleep_us, uint, S_IRUGO);
+MODULE_PARM_DESC(sleep_us, "Sleep length for the wakeup latency test");
+
+static unsigned int sleep_cnt = 1000;
+module_param(sleep_cnt, uint, S_IRUGO);
+MODULE_PARM_DESC(sleep_cnt, "Try count for the wakeup latency test");
+
+static struct task_struct *mctperf_task;
+
+static enum hrtimer_restart mctperf_timer_fn(struct hrtimer *timer)
+{
+	return HRTIMER_NORESTART;
+}
+
+static void mctperf_report(const char *name, u64 total, unsigned int cnt)
+{
+	printk(KERN_INFO "%-24s: %llu ns\n", name, div_u64(total, cnt));
+}
+
+static void clock_read_perf(void)
+{
+	struct timespec ts;
+	u64 start;
+	unsigned int i;
+
+	start = sched_clock();
+	for (i = 0; i < try_cnt; i++)
+		sched_clock();
+	mctperf_report("sched_clock", sched_clock() - start, try_cnt);
+
+	start = sched_clock();
+	for (i = 0; i < try_cnt; i++)
+		ktime_get();
+	mctperf_report("ktime_get", sched_clock() - start, try_cnt);
+
+	start = sched_clock();
+	for (i = 0; i < try_cnt; i++)
+		getnstimeofday(&ts);
+	mctperf_report("getnstimeofday", sched_clock() - start, try_cnt);
+}
+
+/*
+ * A timer expiring before anything else queued on this CPU becomes the
+ * first event, so each start and each cancel reprograms the clockevent.
+ */
+static void clockevent_program_perf(void)
+{
+	struct hrtimer timer;
+	u64 start;
+	unsigned int i;
+
+	hrtimer_init_on_stack(&timer, CLOCK_MONOTONIC,
+			      HRTIMER_MODE_REL_PINNED);
+	timer.function = mctperf_timer_fn;
+
+	preempt_disable();
+	start = sched_clock();
+	for (i = 0; i < try_cnt; i++) {
+		hrtimer_start(&timer, ns_to_ktime(NSEC_PER_MSEC),
+			      HRTIMER_MODE_REL_PINNED);
+		hrtimer_cancel(&timer);
+	}
+	mctperf_report("hrtimer start+cancel", sched_clock() - start,
+		       try_cnt);
+	preempt_enable();
+
+	destroy_hrtimer_on_stack(&timer);
+}
+
+static void wakeup_latency_perf(void)
+{
+	ktime_t expires, now;
+	u64 total = 0;
+	s64 late, worst = 0;
+	unsigned int i;
+
+	for (i = 0; i < sleep_cnt && !kthread_should_stop(); i++) {
+		expires = ktime_add_us(ktime_get(), sleep_us);
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
+		now = ktime_get();
+
+		late = ktime_to_ns(ktime_sub(now, expires));
+		total += late;
+		if (late > worst)
+			worst = late;
+	}
+
+	if (!i)
+		return;
+
+	mctperf_report("wakeup latency (avg)", total, i);
+	printk(KERN_INFO "%-24s: %lld ns\n", "wakeup latency (max)", worst);
+}
+
+static int thread_func(void *data)
+{
+	printk(KERN_INFO "## MCT perf (try_cnt: %d, sleep: %dus x %d)\n",
+	       try_cnt, sleep_us, sleep_cnt);
+
+	clock_read_perf();
+	clockevent_program_perf();
+	wakeup_latency_perf();
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		schedule();
+	}
+
+	return 0;
+}
+
+static int __init mctperf_init(void)
+{
+	mctperf_task = kthread_run(thread_func, NULL, "mctperf_thread");
+	if (IS_ERR(mctperf_task)) {
+		printk(KERN_ERR "Failed to create mctperf thread\n");
+		return PTR_ERR(mctperf_task);
+	}
+
+	return 0;
+}
+module_init(mctperf_init);
+
+static void __exit mctperf_exit(void)
+{
+	kthread_stop(mctperf_task);
+}
+module_exit(mctperf_exit);
+MODULE_LICENSE("GPL");
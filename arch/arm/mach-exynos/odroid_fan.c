@@ -16,15 +16,26 @@
 #include <linux/input.h>
 #include <linux/gpio.h>
 #include <linux/pwm.h>
+#include <linux/notifier.h>
 
 #include <mach/gpio.h>
 #include <mach/regs-gpio.h>
 #include <plat/gpio-cfg.h>
+#ifdef CONFIG_EXYNOS_THERMAL
+#include <mach/tmu.h>
+#endif
 
 //[*]--------------------------------------------------------------------------------------------------[*]
 #define	DEBUG_PM_MSG
 #include	"odroid_fan.h"
 
+#define	FAN_CURVE_MAX	8
+
+struct fan_curve_point {
+	int	temp;
+	int	duty;
+};
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 /*
@@ -40,8 +51,38 @@ struct odroid_fan {
 	int period;
 	int duty;
 	int pwm_id;
+
+	/* duty actually programmed, -1 while the PWM is stopped */
+	int cur_duty;
+
+	/* in auto mode the duty follows the cooling level from the TMU */
+	int fan_mode;
+	int auto_duty;
+	struct notifier_block tmu_nb;
+
+	/* in curve mode the duty follows the TMU temperature */
+	struct fan_curve_point	curve[FAN_CURVE_MAX];
+	int nr_points;
+	int hysteresis;
+	int curve_step;
+	int curve_duty;
 };
 
+#define	FAN_MODE_MANUAL		0
+#define	FAN_MODE_AUTO		1
+#define	FAN_MODE_CURVE		2
+
+//[*]------------------------------------------------------------------------------------------------------------------
+// Default curve, full speed is reached below the cpufreq throttle point (82c ~ 85c).
+//[*]------------------------------------------------------------------------------------------------------------------
+static	const struct fan_curve_point	odroid_fan_default_curve[] = {
+	{ .temp = 60,	.duty = 102	},
+	{ .temp = 70,	.duty = 178	},
+	{ .temp = 78,	.duty = 255	},
+};
+
+#define	FAN_DEFAULT_HYSTERESIS	5
+
 //[*]------------------------------------------------------------------------------------------------------------------
 //
 // driver sysfs attribute define
@@ -55,9 +96,24 @@ static	ssize_t set_pwm_duty	(struct device *dev, struct device_attribute *attr,
 static	ssize_t show_pwm_duty	(struct device *dev, struct device_attribute *attr, char *buf);
 static	DEVICE_ATTR(pwm_duty, S_IRWXUGO, show_pwm_duty, set_pwm_duty);
 
+static	ssize_t set_fan_mode	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
+static	ssize_t show_fan_mode	(struct device *dev, struct device_attribute *attr, char *buf);
+static	DEVICE_ATTR(fan_mode, S_IRUGO | S_IWUSR, show_fan_mode, set_fan_mode);
+
+static	ssize_t set_fan_curve	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
+static	ssize_t show_fan_curve	(struct device *dev, struct device_attribute *attr, char *buf);
+static	DEVICE_ATTR(fan_curve, S_IRUGO | S_IWUSR, show_fan_curve, set_fan_curve);
+
+static	ssize_t set_fan_hysteresis	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
+static	ssize_t show_fan_hysteresis	(struct device *dev, struct device_attribute *attr, char *buf);
+static	DEVICE_ATTR(fan_hysteresis, S_IRUGO | S_IWUSR, show_fan_hysteresis, set_fan_hysteresis);
+
 static struct attribute *odroid_fan_sysfs_entries[] = {
 	&dev_attr_pwm_enable.attr,
 	&dev_attr_pwm_duty.attr,
+	&dev_attr_fan_mode.attr,
+	&dev_attr_fan_curve.attr,
+	&dev_attr_fan_hysteresis.attr,
 	NULL
 };
 
@@ -67,6 +123,34 @@ static struct attribute_group odroid_fan_attr_group = {
 };
 
 
+//[*]------------------------------------------------------------------------------------------------------------------
+// Program the duty of the current mode, called with fan->mutex held.
+// The PWM is only touched when the effective duty changes.
+//[*]------------------------------------------------------------------------------------------------------------------
+static	void	odroid_fan_update	(struct odroid_fan *fan)
+{
+	int	duty = -1;
+
+	if(fan->pwm_status) {
+		switch(fan->fan_mode)	{
+		case	FAN_MODE_AUTO	:	duty = fan->auto_duty;	break;
+		case	FAN_MODE_CURVE	:	duty = fan->curve_duty;	break;
+		default				:	duty = fan->duty;		break;
+		}
+	}
+
+	if(duty == fan->cur_duty)	return;
+
+	pwm_disable(fan->pwm);
+	if(duty < 0)
+		pwm_config(fan->pwm, 0, fan->period);
+	else {
+		pwm_config(fan->pwm, duty * fan->period / 255, fan->period);
+		pwm_enable(fan->pwm);
+	}
+	fan->cur_duty = duty;
+}
+
 //[*]------------------------------------------------------------------------------------------------------------------
 //[*]------------------------------------------------------------------------------------------------------------------
 static	ssize_t set_pwm_enable	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
@@ -78,17 +162,8 @@ static	ssize_t set_pwm_enable	(struct device *dev, struct device_attribute *attr
 	printk("PWM_0 : %s [%d] \n",__FUNCTION__,val);
 
 	mutex_lock(&fan->mutex);
-    if(val) {
-    	fan->pwm_status = 1;
-		pwm_disable(fan->pwm);
-		pwm_config(fan->pwm, fan->duty * fan->period / 255, fan->period);
-    	pwm_enable(fan->pwm);
-    }
-    else {
-    	pwm_disable(fan->pwm);
-		pwm_config(fan->pwm, 0, fan->period);
-    	fan->pwm_status = 0;
-    }
+	fan->pwm_status = val ? 1 : 0;
+	odroid_fan_update(fan);
 	mutex_unlock(&fan->mutex);
 
 	return count;
@@ -120,16 +195,7 @@ static	ssize_t set_pwm_duty	(struct device *dev, struct device_attribute *attr,
 
 	mutex_lock(&fan->mutex);
 	fan->duty = val;
-
-    if(fan->pwm_status){
-		pwm_disable(fan->pwm);
-		pwm_config(fan->pwm, fan->duty * fan->period / 255, fan->period);
-    	pwm_enable(fan->pwm);
-    }
-    else {
-		pwm_disable(fan->pwm);
-		pwm_config(fan->pwm, 0, fan->period);
-    }
+	odroid_fan_update(fan);
 	mutex_unlock(&fan->mutex);
 	
 	return count;
@@ -142,6 +208,154 @@ static	ssize_t show_pwm_duty	(struct device *dev, struct device_attribute *attr,
 	return	sprintf(buf, "PWM_0 : Duty cycle -> %d (%d) \n", fan->duty,fan->duty*100/255);
 }
 
+//[*]------------------------------------------------------------------------------------------------------------------
+//[*]------------------------------------------------------------------------------------------------------------------
+static	ssize_t set_fan_mode	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+	int	mode;
+
+	if(!strncmp(buf, "manual", 6))		mode = FAN_MODE_MANUAL;
+	else if(!strncmp(buf, "auto", 4))	mode = FAN_MODE_AUTO;
+	else if(!strncmp(buf, "curve", 5))	mode = FAN_MODE_CURVE;
+	else								return	-EINVAL;
+
+#ifndef CONFIG_EXYNOS_THERMAL
+	if(mode != FAN_MODE_MANUAL)			return	-ENODEV;
+#endif
+
+	mutex_lock(&fan->mutex);
+	fan->fan_mode = mode;
+	odroid_fan_update(fan);
+	mutex_unlock(&fan->mutex);
+
+	return count;
+}
+
+static	ssize_t show_fan_mode	(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+
+	if(fan->fan_mode == FAN_MODE_AUTO)
+		return	sprintf(buf, "auto (duty %d)\n", fan->auto_duty);
+	if(fan->fan_mode == FAN_MODE_CURVE)
+		return	sprintf(buf, "curve (duty %d)\n", fan->curve_duty);
+
+	return	sprintf(buf, "manual\n");
+}
+
+//[*]------------------------------------------------------------------------------------------------------------------
+// fan_curve : up to FAN_CURVE_MAX "temp:duty" pairs, temperatures ascending.
+// ex) echo "60:102 70:178 78:255" > fan_curve
+//[*]------------------------------------------------------------------------------------------------------------------
+static	ssize_t set_fan_curve	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+	struct fan_curve_point	curve[FAN_CURVE_MAX];
+	int	nr_points = 0, len;
+
+	while(nr_points < FAN_CURVE_MAX &&
+		sscanf(buf, " %d:%d%n", &curve[nr_points].temp, &curve[nr_points].duty, &len) == 2) {
+		if(curve[nr_points].duty < 0 || curve[nr_points].duty > 255)
+			return	-EINVAL;
+		if(nr_points && curve[nr_points].temp <= curve[nr_points - 1].temp)
+			return	-EINVAL;
+		buf += len;	nr_points++;
+	}
+
+	if(!nr_points)	return	-EINVAL;
+
+	mutex_lock(&fan->mutex);
+	memcpy(fan->curve, curve, sizeof(curve[0]) * nr_points);
+	fan->nr_points = nr_points;
+	fan->curve_step = -1;
+	mutex_unlock(&fan->mutex);
+
+	return count;
+}
+
+static	ssize_t show_fan_curve	(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+	int	i, len = 0;
+
+	mutex_lock(&fan->mutex);
+	for(i = 0; i < fan->nr_points; i++)
+		len += sprintf(buf + len, "%d:%d ", fan->curve[i].temp, fan->curve[i].duty);
+	mutex_unlock(&fan->mutex);
+
+	len += sprintf(buf + len, "\n");
+	return	len;
+}
+
+//[*]------------------------------------------------------------------------------------------------------------------
+//[*]------------------------------------------------------------------------------------------------------------------
+static	ssize_t set_fan_hysteresis	(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+	unsigned int	val;
+
+    if(!(sscanf(buf, "%u\n", &val)))	return	-EINVAL;
+
+	mutex_lock(&fan->mutex);
+	fan->hysteresis = val;
+	mutex_unlock(&fan->mutex);
+
+	return count;
+}
+
+static	ssize_t show_fan_hysteresis	(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct odroid_fan *fan = dev_get_drvdata(dev);
+
+	return	sprintf(buf, "%d\n", fan->hysteresis);
+}
+
+#ifdef CONFIG_EXYNOS_THERMAL
+//[*]------------------------------------------------------------------------------------------------------------------
+// Step up as soon as a point is reached, step down only once the
+// temperature is "hysteresis" below the point the fan is running at.
+//[*]------------------------------------------------------------------------------------------------------------------
+static	void	odroid_fan_curve_update	(struct odroid_fan *fan, int temp)
+{
+	int	step = -1, i;
+
+	for(i = 0; i < fan->nr_points; i++)
+		if(temp >= fan->curve[i].temp)	step = i;
+
+	while(fan->curve_step > step &&
+			temp < fan->curve[fan->curve_step].temp - fan->hysteresis)
+		fan->curve_step--;
+
+	if(step > fan->curve_step)	fan->curve_step = step;
+
+	fan->curve_duty = (fan->curve_step < 0) ? 0 : fan->curve[fan->curve_step].duty;
+}
+#endif
+
+#ifdef CONFIG_EXYNOS_THERMAL
+//[*]------------------------------------------------------------------------------------------------------------------
+// TMU sample notification : the thermal controller raises the fan level
+// before it caps the CPU, so in auto mode the duty simply follows it.
+//[*]------------------------------------------------------------------------------------------------------------------
+static	int		odroid_fan_tmu_notify	(struct notifier_block *nb, unsigned long event, void *data)
+{
+	struct odroid_fan *fan = container_of(nb, struct odroid_fan, tmu_nb);
+	struct tmu_notify_data *nd = data;
+
+	if(event != TMU_NOTIFY_SAMPLE)	return	NOTIFY_DONE;
+
+	mutex_lock(&fan->mutex);
+	fan->auto_duty = nd->fan_level * 255 / TMU_FAN_LEVEL_MAX;
+	odroid_fan_curve_update(fan, nd->temperature);
+	if(fan->fan_mode != FAN_MODE_MANUAL)
+		odroid_fan_update(fan);
+	mutex_unlock(&fan->mutex);
+
+	return	NOTIFY_OK;
+}
+#endif
+
 
 //[*]--------------------------------------------------------------------------------------------------[*]
 //[*]--------------------------------------------------------------------------------------------------[*]
@@ -193,22 +407,68 @@ static	int		odroid_fan_probe		(struct platform_device *pdev)
 	pwm_config(fan->pwm, fan->duty * fan->period / 255, fan->period);
 	pwm_enable(fan->pwm);
 	fan->pwm_status = 1;
+	fan->cur_duty = fan->duty;
+	fan->fan_mode = FAN_MODE_MANUAL;
 	mutex_init(&fan->mutex);
+
+	fan->nr_points = ARRAY_SIZE(odroid_fan_default_curve);
+	memcpy(fan->curve, odroid_fan_default_curve, sizeof(odroid_fan_default_curve));
+	fan->hysteresis = FAN_DEFAULT_HYSTERESIS;
+	fan->curve_step = -1;
+
+#ifdef CONFIG_EXYNOS_THERMAL
+	/* full speed until the first TMU sample arrives */
+	fan->auto_duty = fan->duty;
+	fan->curve_duty = fan->duty;
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	fan->fan_mode = FAN_MODE_AUTO;
+#else
+	fan->fan_mode = FAN_MODE_CURVE;
+#endif
+	fan->tmu_nb.notifier_call = odroid_fan_tmu_notify;
+	exynos_tmu_register_notifier(&fan->tmu_nb);
+#endif
 	
 	dev_set_drvdata(dev, fan);
 
 	ret =sysfs_create_group(&dev->kobj, &odroid_fan_attr_group);
 	if(ret < 0)	{
 		dev_err(&pdev->dev, "failed to create sysfs group !!\n");
+		goto err_sysfs;
 	}
 
 	return 0;
+
+err_sysfs:
+#ifdef CONFIG_EXYNOS_THERMAL
+	/* the chain must not keep a pointer into the freed fan */
+	exynos_tmu_unregister_notifier(&fan->tmu_nb);
+#endif
+	dev_set_drvdata(dev, NULL);
+	pwm_config(fan->pwm, fan->period, fan->period);
+	pwm_free(fan->pwm);
+	kfree(fan);
+	return ret;
 }
 
 //[*]--------------------------------------------------------------------------------------------------[*]
 static	int		odroid_fan_remove		(struct platform_device *pdev)	
 {
-    return	0;
+	struct odroid_fan *fan = dev_get_drvdata(&pdev->dev);
+
+#ifdef CONFIG_EXYNOS_THERMAL
+	/* returns once no sample is being delivered to the fan */
+	exynos_tmu_unregister_notifier(&fan->tmu_nb);
+#endif
+	sysfs_remove_group(&pdev->dev.kobj, &odroid_fan_attr_group);
+
+	/* nothing controls the fan from now on, leave it at full speed */
+	pwm_config(fan->pwm, fan->period, fan->period);
+	pwm_free(fan->pwm);
+	dev_set_drvdata(&pdev->dev, NULL);
+	kfree(fan);
+
+	return	0;
 }
 
 //[*]--------------------------------------------------------------------------------------------------[*]
@@ -24,6 +24,9 @@
 #include <linux/io.h>
 #include <linux/irq.h>
 #include <linux/slab.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/notifier.h>
 
 #include <mach/regs-tmu.h>
 #include <mach/cpufreq.h>
@@ -37,12 +40,95 @@
 
 #include <plat/cpu.h>
 
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+/*
+ * The controller output (demand) is split into consecutive bands:
+ * the first drives the fan, the next lowers the cpufreq cap step by step
+ * down to the warning frequency, and the last takes cores offline.
+ */
+#define TMU_PID_FAN_SHARE	300
+#define TMU_PID_CORE_SHARE	100
+#define TMU_PID_CPU_START	TMU_PID_FAN_SHARE
+#define TMU_PID_CORE_START	(TMU_PID_DEMAND_MAX - TMU_PID_CORE_SHARE)
+
+#define TMU_PID_DEFAULT_KP	60
+#define TMU_PID_DEFAULT_KI	10
+#define TMU_PID_DEFAULT_KD	100
+
+/* below target by this much with no demand, poll at the idle rate */
+#define TMU_PID_IDLE_MARGIN	10
+#define TMU_PID_IDLE_RATE	(1000 * 1000)
+#endif
+
 static DEFINE_MUTEX(tmu_lock);
+static BLOCKING_NOTIFIER_HEAD(tmu_notifier_list);
 
 unsigned int already_limit;
 unsigned int auto_refresh_changed;
 static struct workqueue_struct  *tmu_monitor_wq;
 
+/*
+ * While anyone listens for samples the monitor keeps polling in the
+ * normal state too, instead of waiting for the throttle interrupt.
+ */
+static struct tmu_info *tmu_notify_info;
+static int tmu_notifier_users;
+
+int exynos_tmu_register_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	ret = blocking_notifier_chain_register(&tmu_notifier_list, nb);
+	if (ret)
+		return ret;
+
+	mutex_lock(&tmu_lock);
+	if (!tmu_notifier_users++ && tmu_notify_info)
+		queue_delayed_work_on(0, tmu_monitor_wq,
+				&tmu_notify_info->polling, 0);
+	mutex_unlock(&tmu_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(exynos_tmu_register_notifier);
+
+int exynos_tmu_unregister_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	ret = blocking_notifier_chain_unregister(&tmu_notifier_list, nb);
+	if (ret)
+		return ret;
+
+	mutex_lock(&tmu_lock);
+	tmu_notifier_users--;
+	mutex_unlock(&tmu_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(exynos_tmu_unregister_notifier);
+
+static void tmu_notify_sample(struct tmu_info *info, int cur_temp)
+{
+	struct tmu_notify_data nd;
+
+	nd.temperature = cur_temp;
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	nd.fan_level = min(info->pid.demand, (unsigned int)TMU_PID_FAN_SHARE) *
+			TMU_FAN_LEVEL_MAX / TMU_PID_FAN_SHARE;
+#else
+	nd.fan_level = (info->tmu_state >= TMU_STATUS_THROTTLED &&
+			info->tmu_state <= TMU_STATUS_TRIPPED) ?
+			TMU_FAN_LEVEL_MAX : 0;
+#endif
+
+	blocking_notifier_call_chain(&tmu_notifier_list, TMU_NOTIFY_SAMPLE, &nd);
+}
+
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+static void tmu_pid_init_levels(struct tmu_info *info);
+#endif
+
 static void tmu_tripped_cb(void)
 {
 	/* To do */
@@ -321,6 +407,9 @@ static ssize_t store_warning_freq(struct device *dev,
 	/* Set frequecny level */
 	exynos_cpufreq_get_level(data->cpulimit.warning_freq,
 				&info->warning_freq);
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	tmu_pid_init_levels(info);
+#endif
 	mutex_unlock(&tmu_lock);
 
 	return count;
@@ -526,12 +615,189 @@ err_unlock:
 }
 #endif
 
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+/* valid cpufreq levels the cap may step through, fastest first */
+static void tmu_pid_init_levels(struct tmu_info *info)
+{
+	struct tmu_pid_state *s = &info->pid;
+	struct cpufreq_frequency_table *table;
+	unsigned int i, last;
+
+	s->nr_levels = 0;
+
+	table = cpufreq_frequency_get_table(0);
+	if (!table) {
+		pr_err("TMU: no cpufreq table, cpufreq capping disabled\n");
+		return;
+	}
+
+	last = info->warning_freq ? info->warning_freq : UINT_MAX;
+	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END && i <= last; i++) {
+		if (table[i].frequency == CPUFREQ_ENTRY_INVALID)
+			continue;
+		if (s->nr_levels == TMU_PID_MAX_LEVELS)
+			break;
+		s->levels[s->nr_levels++] = i;
+	}
+}
+
+static void tmu_pid_init(struct tmu_info *info)
+{
+	struct tmu_data *data = info->dev->platform_data;
+	struct thermal_pid_params *p = &data->pid;
+
+	if (!p->target_temp)
+		p->target_temp = data->ts.stop_throttle;
+	if (!p->kp)
+		p->kp = TMU_PID_DEFAULT_KP;
+	if (!p->ki)
+		p->ki = TMU_PID_DEFAULT_KI;
+	if (!p->kd)
+		p->kd = TMU_PID_DEFAULT_KD;
+
+	memset(&info->pid, 0, sizeof(info->pid));
+	tmu_pid_init_levels(info);
+
+	pr_info("TMU: PID target %dc, kp %d ki %d kd %d, %d cpufreq levels\n",
+		p->target_temp, p->kp, p->ki, p->kd, info->pid.nr_levels);
+}
+
+/*
+ * cpu_down() sleeps and runs the CPU notifiers, which may wait for work
+ * that needs tmu_lock, so the limit is applied outside of it.
+ */
+static void tmu_pid_hotplug(struct work_struct *work)
+{
+	struct tmu_info *info =
+		container_of(work, struct tmu_info, pid_hotplug);
+	unsigned int max_cpus;
+
+	mutex_lock(&tmu_lock);
+	max_cpus = info->pid.max_cpus;
+	mutex_unlock(&tmu_lock);
+
+	if (max_cpus)
+		exynos_cpu_hotplug_limit(DVFS_LOCK_ID_TMU, max_cpus);
+	else
+		exynos_cpu_hotplug_limit_free(DVFS_LOCK_ID_TMU);
+}
+
+static void tmu_pid_apply(struct tmu_info *info)
+{
+	struct tmu_pid_state *s = &info->pid;
+	unsigned int demand = s->demand;
+	unsigned int idx, cpu_level = 0, max_cpus = 0;
+	unsigned int nr_cpus = num_possible_cpus();
+
+	if (demand > TMU_PID_CPU_START && s->nr_levels > 1) {
+		idx = (min(demand, (unsigned int)TMU_PID_CORE_START) -
+		       TMU_PID_CPU_START) * (s->nr_levels - 1) /
+		      (TMU_PID_CORE_START - TMU_PID_CPU_START);
+		/* capping at the fastest level is no cap at all */
+		if (idx)
+			cpu_level = s->levels[idx];
+	}
+
+	if (demand > TMU_PID_CORE_START && nr_cpus > 1)
+		max_cpus = nr_cpus - (demand - TMU_PID_CORE_START) *
+				(nr_cpus - 1) / TMU_PID_CORE_SHARE;
+
+	if (cpu_level != s->cpu_level) {
+		if (s->cpu_level)
+			exynos_cpufreq_upper_limit_free(DVFS_LOCK_ID_TMU);
+		if (cpu_level)
+			exynos_cpufreq_upper_limit(DVFS_LOCK_ID_TMU, cpu_level);
+		s->cpu_level = cpu_level;
+	}
+
+	if (max_cpus != s->max_cpus) {
+		s->max_cpus = max_cpus;
+		schedule_work(&info->pid_hotplug);
+	}
+}
+
+/*
+ * Move the cooling demand towards holding target_temp. The integral term
+ * is clamped to the demand range so it can neither wind up while the
+ * chip is cool nor keep the cap after the load goes away.
+ */
+static void tmu_pid_control(struct tmu_info *info, int cur_temp)
+{
+	struct tmu_data *data = info->dev->platform_data;
+	struct thermal_pid_params *p = &data->pid;
+	struct tmu_pid_state *s = &info->pid;
+	int err, demand;
+
+	err = cur_temp - (int)p->target_temp;
+
+	s->integral += (int)p->ki * err;
+	s->integral = clamp(s->integral, 0, TMU_PID_DEMAND_MAX);
+
+	demand = (int)p->kp * err + s->integral +
+		 (int)p->kd * (err - s->last_err);
+	s->last_err = err;
+	s->demand = clamp(demand, 0, TMU_PID_DEMAND_MAX);
+
+	tmu_pid_apply(info);
+
+	if (s->max_cpus)
+		info->tmu_state = TMU_STATUS_WARNING;
+	else if (s->cpu_level)
+		info->tmu_state = TMU_STATUS_THROTTLED;
+	else
+		info->tmu_state = TMU_STATUS_NORMAL;
+}
+
+static ssize_t show_pid(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct tmu_info *info = dev_get_drvdata(dev);
+	struct tmu_data *data = info->dev->platform_data;
+
+	return sprintf(buf, "target %dc kp %d ki %d kd %d\n"
+		       "demand %d cpu_level %d max_cpus %d\n",
+		       data->pid.target_temp, data->pid.kp, data->pid.ki,
+		       data->pid.kd, info->pid.demand, info->pid.cpu_level,
+		       info->pid.max_cpus);
+}
+
+static ssize_t store_pid(struct device *dev, struct device_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct tmu_info *info = dev_get_drvdata(dev);
+	struct tmu_data *data = info->dev->platform_data;
+	unsigned int target, kp, ki, kd;
+
+	if (sscanf(buf, "%u %u %u %u", &target, &kp, &ki, &kd) != 4)
+		return -EINVAL;
+
+	if (!target || target >= data->ts.start_tripping)
+		return -EINVAL;
+
+	/* larger gains would overflow tmu_pid_control() and undo the cap */
+	if (kp > TMU_PID_DEMAND_MAX || ki > TMU_PID_DEMAND_MAX ||
+	    kd > TMU_PID_DEMAND_MAX)
+		return -EINVAL;
+
+	mutex_lock(&tmu_lock);
+	data->pid.target_temp = target;
+	data->pid.kp = kp;
+	data->pid.ki = ki;
+	data->pid.kd = kd;
+	mutex_unlock(&tmu_lock);
+
+	return count;
+}
+static DEVICE_ATTR(pid, 0644, show_pid, store_pid);
+#endif
+
 static void tmu_monitor(struct work_struct *work)
 {
 	struct delayed_work *delayed_work = to_delayed_work(work);
 	struct tmu_info *info =
 		container_of(delayed_work, struct tmu_info, polling);
 	struct tmu_data *data = info->dev->platform_data;
+	unsigned long delay = info->sampling_rate;
 	int cur_temp;
 
 	cur_temp = get_cur_temp(info);
@@ -557,6 +823,34 @@ static void tmu_monitor(struct work_struct *work)
 		}
 		break;
 #endif
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	case TMU_STATUS_INIT:
+	case TMU_STATUS_NORMAL:
+	case TMU_STATUS_THROTTLED:
+	case TMU_STATUS_WARNING:
+		if (cur_temp >= data->ts.start_tripping) {
+			info->tmu_state = TMU_STATUS_TRIPPED;
+			break;
+		}
+
+		tmu_pid_control(info, cur_temp);
+
+		/*
+		 * The controller polls on its own, the interrupt is only
+		 * needed to catch a fast rise between samples.
+		 */
+		if (info->irq_disabled && cur_temp < data->ts.start_throttle) {
+			__raw_writel((CLEAR_RISE_INT|CLEAR_FALL_INT),
+					info->tmu_base + INTCLEAR);
+			info->irq_disabled = false;
+			enable_irq(info->irq);
+		}
+
+		if (!info->pid.demand && cur_temp + TMU_PID_IDLE_MARGIN <
+				(int)data->pid.target_temp)
+			delay = usecs_to_jiffies(TMU_PID_IDLE_RATE);
+		break;
+#else
 	case TMU_STATUS_NORMAL:
 #ifdef CONFIG_TMU_DEBUG
 		queue_delayed_work_on(0, tmu_monitor_wq,
@@ -564,7 +858,16 @@ static void tmu_monitor(struct work_struct *work)
 #endif
 		__raw_writel((CLEAR_RISE_INT|CLEAR_FALL_INT),
 					info->tmu_base + INTCLEAR);
-		enable_irq(info->irq);
+		if (info->irq_disabled) {
+			info->irq_disabled = false;
+			enable_irq(info->irq);
+		}
+
+		/* a fan curve needs samples below the throttle point too */
+		if (tmu_notifier_users)
+			break;
+
+		tmu_notify_sample(info, cur_temp);
 		mutex_unlock(&tmu_lock);
 		return;
 
@@ -603,6 +906,7 @@ static void tmu_monitor(struct work_struct *work)
 			already_limit = 0;
 		}
 		break;
+#endif
 
 	case TMU_STATUS_TRIPPED:
 		mutex_unlock(&tmu_lock);
@@ -625,8 +929,9 @@ static void tmu_monitor(struct work_struct *work)
 			auto_refresh_changed = 0;
 	}
 
-	queue_delayed_work_on(0, tmu_monitor_wq,
-			&info->polling, info->sampling_rate);
+	tmu_notify_sample(info, cur_temp);
+
+	queue_delayed_work_on(0, tmu_monitor_wq, &info->polling, delay);
 	mutex_unlock(&tmu_lock);
 
 	return;
@@ -864,6 +1169,7 @@ static int exynos_tmu_init(struct tmu_info *info)
 	*/
 	if (get_cur_temp(info) <= data->ts.start_tc) {
 		disable_irq_nosync(info->irq);
+		info->irq_disabled = true;
 		if (exynos_tc_volt(info, 1) < 0)
 			pr_err("%s\n", __func__);
 
@@ -903,6 +1209,7 @@ static irqreturn_t tmu_irq(int irq, void *id)
 	unsigned int status;
 
 	disable_irq_nosync(irq);
+	info->irq_disabled = true;
 
 	status = __raw_readl(info->tmu_base + INTSTAT);
 
@@ -946,6 +1253,7 @@ static irqreturn_t exynos4210_tmu_irq(int irq, void *id)
 	unsigned int status;
 
 	disable_irq_nosync(irq);
+	info->irq_disabled = true;
 
 	status = __raw_readl(info->tmu_base + INTSTAT);
 
@@ -1062,6 +1370,24 @@ static int __devinit tmu_probe(struct platform_device *pdev)
 	if (ret < 0)
 		goto err_noinit;
 
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	tmu_pid_init(info);
+	INIT_WORK(&info->pid_hotplug, tmu_pid_hotplug);
+	if (device_create_file(&pdev->dev, &dev_attr_pid))
+		pr_err("Failed to create sysfs file [pid]\n");
+
+	/* the controller samples continuously, not only once throttled */
+	queue_delayed_work_on(0, tmu_monitor_wq,
+			&info->polling, info->sampling_rate);
+#endif
+
+	mutex_lock(&tmu_lock);
+	tmu_notify_info = info;
+	if (tmu_notifier_users)
+		queue_delayed_work_on(0, tmu_monitor_wq,
+				&info->polling, info->sampling_rate);
+	mutex_unlock(&tmu_lock);
+
 #ifdef CONFIG_TMU_DEBUG
 	queue_delayed_work_on(0, tmu_monitor_wq,
 			&info->monitor, info->sampling_rate);
@@ -1091,10 +1417,20 @@ static int __devinit tmu_remove(struct platform_device *pdev)
 {
 	struct tmu_info *info = platform_get_drvdata(pdev);
 
+	mutex_lock(&tmu_lock);
+	tmu_notify_info = NULL;
+	mutex_unlock(&tmu_lock);
+
 	cancel_delayed_work(&info->polling);
 	destroy_workqueue(tmu_monitor_wq);
 
 	thermal_remove_sysfs_file(&pdev->dev);
+#ifdef CONFIG_EXYNOS_THERMAL_PID
+	device_remove_file(&pdev->dev, &dev_attr_pid);
+	cancel_work_sync(&info->pid_hotplug);
+	exynos_cpufreq_upper_limit_free(DVFS_LOCK_ID_TMU);
+	exynos_cpu_hotplug_limit_free(DVFS_LOCK_ID_TMU);
+#endif
 
 	iounmap(info->tmu_base);
 	release_resource(info->ioarea);
@@ -1133,6 +1469,7 @@ static int tmu_resume(struct platform_device *pdev)
 	mdelay(1);
 	if (get_cur_temp(info) <= data->ts.start_tc) {
 		disable_irq_nosync(info->irq);
+		info->irq_disabled = true;
 		if (exynos_tc_volt(info, 1) < 0)
 			pr_err("%s\n", __func__);
 
@@ -47,18 +47,17 @@ void *__kmap_atomic(struct page *page)
 	if (!PageHighMem(page))
 		return page_address(page);
 
-#ifdef CONFIG_DEBUG_HIGHMEM
 	/*
-	 * There is no cache coherency issue when non VIVT, so force the
-	 * dedicated kmap usage for better debugging purposes in that case.
+	 * Only VIVT caches need the existing kmap() of the page to avoid
+	 * aliases.  kmap_high_get() takes the global kmap_lock with
+	 * interrupts off, the others are better off with their own fixmap
+	 * entry, there is no cache coherency issue when non VIVT.
 	 */
-	if (!cache_is_vivt())
-		kmap = NULL;
-	else
-#endif
+	if (cache_is_vivt()) {
 		kmap = kmap_high_get(page);
-	if (kmap)
-		return kmap;
+		if (kmap)
+			return kmap;
+	}
 
 	type = kmap_atomic_idx_push();
 
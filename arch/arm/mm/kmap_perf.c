@@ -0,0 +1,190 @@
+/* linux/arch/arm/mm/kmap_perf.c
+ *
+ * Cost of kmap/kunmap and kmap_atomic/kunmap_atomic of highmem pages,
+ * and the pkmap TLB flushes they cause, for a stream of pages mapped
+ * once, and for the same stream interleaved with a small hot set that
+ * is mapped over and over as file data and zram pages are.
+ *
+ * The test runs once at boot, in a kernel thread.  The flush counts come
+ * from the kmap_* events of /proc/vmstat, so they include other users of
+ * kmap meanwhile.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/errno.h>
+#include <linux/err.h>
+#include <linux/gfp.h>
+#include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/vmalloc.h>
+#include <linux/vmstat.h>
+
+static unsigned int nr_pages = 2 * LAST_PKMAP;
+module_param(nr_pages, uint, S_IRUGO);
+MODULE_PARM_DESC(nr_pages, "Highmem pages of the stream");
+
+static unsigned int hot = LAST_PKMAP / 8;
+module_param(hot, uint, S_IRUGO);
+MODULE_PARM_DESC(hot, "Pages of the hot set, mapped between stream pages");
+
+static unsigned int rounds = 16;
+module_param(rounds, uint, S_IRUGO);
+MODULE_PARM_DESC(rounds, "Passes over the stream");
+
+enum kmap_test {
+	TEST_ATOMIC,
+	TEST_STREAM,
+	TEST_HOT,
+	TEST_MAX,
+};
+
+static const char * const test_names[TEST_MAX] = {
+	[TEST_ATOMIC]	= "atomic",
+	[TEST_STREAM]	= "stream",
+	[TEST_HOT]	= "hot",
+};
+
+static unsigned long events_before[NR_VM_EVENT_ITEMS];
+static unsigned long events_after[NR_VM_EVENT_ITEMS];
+
+static void kmap_perf_touch(struct page *page)
+{
+	unsigned long *p = kmap(page);
+
+	p[0]++;
+	kunmap(page);
+}
+
+static unsigned long kmap_perf_run_one(enum kmap_test test,
+				       struct page **pages)
+{
+	unsigned long maps = 0;
+	unsigned int r, i;
+	unsigned long *p;
+
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < nr_pages; i++) {
+			switch (test) {
+			case TEST_ATOMIC:
+				p = kmap_atomic(pages[i]);
+				p[0]++;
+				kunmap_atomic(p);
+				break;
+			case TEST_HOT:
+				kmap_perf_touch(pages[nr_pages + i % hot]);
+				maps++;
+				/* fall through */
+			default:
+				kmap_perf_touch(pages[i]);
+				break;
+			}
+			maps++;
+		}
+		cond_resched();
+	}
+
+	return maps;
+}
+
+static unsigned long kmap_perf_events(enum vm_event_item item)
+{
+	return events_after[item] - events_before[item];
+}
+
+static void kmap_perf_report(enum kmap_test test, unsigned long maps, s64 ns)
+{
+	/* flushes and flushed slots per 1000 maps */
+	printk(KERN_INFO "%s: %lu %llu %lu %lu %lu %lu %lu\n",
+	       test_names[test], maps, div64_u64(max_t(s64, ns, 0), maps),
+	       kmap_perf_events(KMAP_HIT), kmap_perf_events(KMAP_MISS),
+	       kmap_perf_events(KMAP_WAIT),
+	       kmap_perf_events(KMAP_FLUSH) * 1000 / maps,
+	       kmap_perf_events(KMAP_FLUSH_PAGES) * 1000 / maps);
+}
+
+static int kmap_perf_run(void)
+{
+	unsigned int i, total = nr_pages + hot;
+	struct page **pages;
+	unsigned long maps;
+	ktime_t start;
+	s64 ns;
+	int test, err = 0;
+
+	if (!nr_pages || !hot || !rounds)
+		return -EINVAL;
+
+	pages = vzalloc(total * sizeof(*pages));
+	if (!pages)
+		return -ENOMEM;
+
+	for (i = 0; i < total; i++) {
+		pages[i] = alloc_page(GFP_HIGHUSER);
+		if (!pages[i]) {
+			err = -ENOMEM;
+			goto out;
+		}
+		if (!PageHighMem(pages[i])) {
+			/* nothing to measure without highmem */
+			err = -ENODEV;
+			goto out;
+		}
+	}
+
+	printk(KERN_INFO "## kmap perf (%u pages, hot %u, %u rounds): "
+	       "maps ns/map hit miss wait flush/1k flushed/1k\n",
+	       nr_pages, hot, rounds);
+
+	for (test = 0; test < TEST_MAX; test++) {
+		/* every test starts with the pkmap area empty */
+		kmap_flush_unused();
+
+		all_vm_events(events_before);
+		start = ktime_get();
+		maps = kmap_perf_run_one(test, pages);
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		all_vm_events(events_after);
+
+		kmap_perf_report(test, maps, ns);
+	}
+out:
+	for (i = 0; i < total && pages[i]; i++)
+		__free_page(pages[i]);
+	vfree(pages);
+
+	return err;
+}
+
+static int thread_func(void *data)
+{
+	int err;
+
+	err = kmap_perf_run();
+	if (err)
+		printk(KERN_ERR "kmap perf: test failed (%d)\n", err);
+
+	return 0;
+}
+
+static int __init kmap_perf_init(void)
+{
+	struct task_struct *task;
+
+	task = kthread_run(thread_func, NULL, "kmapperf_thread");
+	if (IS_ERR(task))
+		return PTR_ERR(task);
+
+	return 0;
+}
+late_initcall(kmap_perf_init);
@@ -0,0 +1,230 @@
+/* linux/arch/arm/mm/string_perf.c
+ *
+ * Bandwidth of the ARM and NEON memcpy, memset, copy_page and clear_page
+ * per size class, next to the version chosen by the boot calibration.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/errno.h>
+#include <linux/ktime.h>
+#include <linux/types.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/string.h>
+
+#include <asm/sizes.h>
+
+static unsigned int try_cnt = 10;
+module_param(try_cnt, uint, S_IRUGO);
+MODULE_PARM_DESC(try_cnt, "Passes per size, the best one is reported");
+
+static unsigned int max_size = SZ_4M;
+module_param(max_size, uint, S_IRUGO);
+MODULE_PARM_DESC(max_size, "Largest buffer size");
+
+#define START_SIZE	64
+/* bytes moved per pass, so small sizes are not lost in the timer */
+#define PASS_BYTES	SZ_4M
+
+enum string_impl {
+	IMPL_ARM,
+	IMPL_NEON,
+	IMPL_DEFAULT,
+	IMPL_MAX,
+};
+
+static const char * const impl_names[IMPL_MAX] = {
+	[IMPL_ARM]	= "arm",
+	[IMPL_NEON]	= "neon",
+	[IMPL_DEFAULT]	= "default",
+};
+
+enum string_op {
+	OP_MEMCPY,
+	OP_MEMSET,
+	OP_COPY_PAGE,
+	OP_CLEAR_PAGE,
+	OP_MAX,
+};
+
+static const char * const op_names[OP_MAX] = {
+	[OP_MEMCPY]	= "memcpy",
+	[OP_MEMSET]	= "memset",
+	[OP_COPY_PAGE]	= "copy_page",
+	[OP_CLEAR_PAGE]	= "clear_page",
+};
+
+static struct task_struct *stringperf_task;
+
+static void string_op_run(enum string_op op, enum string_impl impl,
+			  void *dst, void *src, u32 size)
+{
+	u32 off;
+
+	switch (op) {
+	case OP_MEMCPY:
+		if (impl == IMPL_ARM)
+			__memcpy_arm(dst, src, size);
+		else if (impl == IMPL_NEON)
+			memcpy_neon(dst, src, size);
+		else
+			memcpy(dst, src, size);
+		break;
+	case OP_MEMSET:
+		if (impl == IMPL_ARM)
+			__memset_arm(dst, 0x5a, size);
+		else if (impl == IMPL_NEON)
+			memset_neon(dst, 0x5a, size);
+		else
+			memset(dst, 0x5a, size);
+		break;
+	case OP_COPY_PAGE:
+		for (off = 0; off < size; off += PAGE_SIZE) {
+			if (impl == IMPL_ARM)
+				__copy_page_arm(dst + off, src + off);
+			else if (impl == IMPL_NEON)
+				copy_page_neon(dst + off, src + off);
+			else
+				copy_page(dst + off, src + off);
+		}
+		break;
+	case OP_CLEAR_PAGE:
+		for (off = 0; off < size; off += PAGE_SIZE) {
+			if (impl == IMPL_ARM)
+				__memzero_arm(dst + off, PAGE_SIZE);
+			else if (impl == IMPL_NEON)
+				clear_page_neon(dst + off);
+			else
+				clear_page(dst + off);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* MB/s of the best of try_cnt passes */
+static u32 string_op_bw(enum string_op op, enum string_impl impl,
+			void *dst, void *src, u32 size)
+{
+	u32 i, loops = max_t(u32, PASS_BYTES / size, 1);
+	s64 ns, best = LLONG_MAX;
+	ktime_t start;
+	u32 pass;
+
+	for (pass = 0; pass < try_cnt; pass++) {
+		start = ktime_get();
+		for (i = 0; i < loops; i++)
+			string_op_run(op, impl, dst, src, size);
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		if (ns < best)
+			best = ns;
+		if (kthread_should_stop())
+			break;
+	}
+
+	if (best <= 0)
+		return 0;
+
+	/* bytes per ns * 1000 is MB/s */
+	return div64_u64((u64)size * loops * 1000, best);
+}
+
+static void string_op_perf(enum string_op op, void *dst, void *src)
+{
+	u32 size, bw[IMPL_MAX];
+	int impl;
+
+	printk(KERN_INFO "## %s bandwidth (MB/s): size %s %s %s\n",
+	       op_names[op], impl_names[IMPL_ARM], impl_names[IMPL_NEON],
+	       impl_names[IMPL_DEFAULT]);
+
+	size = (op == OP_COPY_PAGE || op == OP_CLEAR_PAGE) ?
+		PAGE_SIZE : START_SIZE;
+	for (; size <= max_size; size *= 2) {
+		for (impl = 0; impl < IMPL_MAX; impl++)
+			bw[impl] = string_op_bw(op, impl, dst, src, size);
+
+		printk(KERN_INFO "%8u %6u %6u %6u\n", size,
+		       bw[IMPL_ARM], bw[IMPL_NEON], bw[IMPL_DEFAULT]);
+
+		if (kthread_should_stop())
+			return;
+	}
+}
+
+static int string_compare(void *dst, void *src, u32 size)
+{
+	memset(src, 0xab, size);
+	memset(dst, 0x00, size);
+	memcpy_neon(dst + 1, src + 3, size - 4);
+
+	if (memcmp(dst + 1, src + 3, size - 4)) {
+		printk(KERN_ERR "memcpy_neon: copy err\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int thread_func(void *data)
+{
+	void *src, *dst;
+	int op;
+
+	src = vmalloc(max_size);
+	dst = vmalloc(max_size);
+	if (!src || !dst) {
+		printk(KERN_ERR "Memory allocation error!\n");
+		goto out;
+	}
+
+	if (string_compare(dst, src, max_size))
+		goto out;
+
+	for (op = 0; op < OP_MAX; op++) {
+		string_op_perf(op, dst, src);
+		if (kthread_should_stop())
+			break;
+	}
+out:
+	vfree(dst);
+	vfree(src);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+
+	return 0;
+}
+
+static int __init stringperf_init(void)
+{
+	if (max_size < PAGE_SIZE || max_size & (PAGE_SIZE - 1))
+		return -EINVAL;
+
+	printk(KERN_INFO "Test condition: try_cnt: %u, (%dB ~ %uKB)\n",
+	       try_cnt, START_SIZE, max_size / SZ_1K);
+
+	stringperf_task = kthread_run(thread_func, NULL, "stringperf_thread");
+	if (IS_ERR(stringperf_task))
+		return PTR_ERR(stringperf_task);
+
+	return 0;
+}
+module_init(stringperf_init);
+
+static void __exit stringperf_exit(void)
+{
+	kthread_stop(stringperf_task);
+}
+module_exit(stringperf_exit);
+MODULE_LICENSE("GPL");
@@ -0,0 +1,204 @@
+/* linux/arch/arm/mm/uaccess_perf.c
+ *
+ * Throughput of user copies through a pipe and from a file with the
+ * assembly copy_{to,from}_user, with the pinned-page memcpy of
+ * CONFIG_UACCESS_WITH_MEMCPY, and with the current size threshold.
+ *
+ * The copies need a user address space, so the test runs in the context
+ * of the task writing to /sys/kernel/debug/uaccess_perf.  It changes the
+ * threshold for the whole system while it runs.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/errno.h>
+#include <linux/err.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/sched.h>
+#include <linux/test_trigger.h>
+#include <linux/uaccess.h>
+
+#include <asm/sizes.h>
+
+static unsigned int chunk = SZ_64K;
+module_param(chunk, uint, S_IRUGO);
+MODULE_PARM_DESC(chunk, "Bytes per read/write call");
+
+static unsigned int total_mb = 256;
+module_param(total_mb, uint, S_IRUGO);
+MODULE_PARM_DESC(total_mb, "Megabytes moved through the pipe");
+
+static char *file;
+module_param(file, charp, S_IRUGO);
+MODULE_PARM_DESC(file, "File read sequentially, none by default");
+
+enum uaccess_mode {
+	MODE_STD,
+	MODE_MEMCPY,
+	MODE_CURRENT,
+	MODE_MAX,
+};
+
+static u32 uaccess_perf_bw(u64 bytes, s64 ns)
+{
+	/* bytes per ns * 1000 is MB/s */
+	return ns > 0 ? div64_u64(bytes * 1000, ns) : 0;
+}
+
+/* write() then read() back the same buffer, MB/s through the pipe */
+static int pipe_perf(char __user *buf, u32 *bw)
+{
+	u64 total = (u64)total_mb << 20, done = 0;
+	struct file *wf, *rf;
+	ssize_t w, r;
+	ktime_t start;
+	int err = 0;
+
+	wf = create_write_pipe(O_NONBLOCK);
+	if (IS_ERR(wf))
+		return PTR_ERR(wf);
+
+	rf = create_read_pipe(wf, O_NONBLOCK);
+	if (IS_ERR(rf)) {
+		free_write_pipe(wf);
+		return PTR_ERR(rf);
+	}
+
+	start = ktime_get();
+	while (done < total) {
+		w = vfs_write(wf, buf, chunk, &wf->f_pos);
+		if (w <= 0) {
+			err = w ? w : -EIO;
+			break;
+		}
+
+		r = vfs_read(rf, buf, w, &rf->f_pos);
+		if (r != w) {
+			err = r < 0 ? r : -EIO;
+			break;
+		}
+
+		done += r;
+		if (fatal_signal_pending(current)) {
+			err = -EINTR;
+			break;
+		}
+	}
+	*bw = uaccess_perf_bw(done, ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	fput(rf);
+	fput(wf);
+
+	return err;
+}
+
+/* MB/s of one sequential read() of the whole file */
+static int file_perf(char __user *buf, u32 *bw)
+{
+	struct file *f;
+	loff_t pos = 0;
+	u64 done = 0;
+	ktime_t start;
+	ssize_t r;
+
+	f = filp_open(file, O_RDONLY | O_LARGEFILE, 0);
+	if (IS_ERR(f))
+		return PTR_ERR(f);
+
+	start = ktime_get();
+	do {
+		r = vfs_read(f, buf, chunk, &pos);
+		if (r > 0)
+			done += r;
+	} while (r > 0 && !fatal_signal_pending(current));
+	*bw = uaccess_perf_bw(done, ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	filp_close(f, NULL);
+
+	return r < 0 ? r : 0;
+}
+
+static int uaccess_perf_run(void)
+{
+	unsigned long saved = uaccess_memcpy_min;
+	u32 pipe_bw[MODE_MAX], file_bw[MODE_MAX];
+	unsigned long addr;
+	char __user *buf;
+	int mode, err;
+
+	if (!chunk)
+		return -EINVAL;
+
+	down_write(&current->mm->mmap_sem);
+	addr = do_mmap(NULL, 0, chunk, PROT_READ | PROT_WRITE,
+		       MAP_PRIVATE | MAP_ANONYMOUS, 0);
+	up_write(&current->mm->mmap_sem);
+	if (IS_ERR_VALUE(addr))
+		return addr;
+	buf = (char __user *)addr;
+
+	/* fault in and dirty the buffer, as a reused read() buffer is */
+	if (clear_user(buf, chunk)) {
+		err = -EFAULT;
+		goto out;
+	}
+
+	/* the file comes from the page cache for every mode */
+	if (file) {
+		err = file_perf(buf, &file_bw[MODE_STD]);
+		if (err)
+			goto out;
+	}
+
+	for (mode = 0; mode < MODE_MAX; mode++) {
+		if (mode == MODE_STD)
+			uaccess_memcpy_min = ULONG_MAX;
+		else if (mode == MODE_MEMCPY)
+			uaccess_memcpy_min = 0;
+		else
+			uaccess_memcpy_min = saved;
+
+		err = pipe_perf(buf, &pipe_bw[mode]);
+		if (!err && file)
+			err = file_perf(buf, &file_bw[mode]);
+		if (err)
+			break;
+	}
+	uaccess_memcpy_min = saved;
+	if (err)
+		goto out;
+
+	printk(KERN_INFO "## uaccess perf (MB/s, chunk %uB, min_size %lu): "
+	       "std memcpy current\n", chunk, saved);
+	printk(KERN_INFO "pipe: %u %u %u\n", pipe_bw[MODE_STD],
+	       pipe_bw[MODE_MEMCPY], pipe_bw[MODE_CURRENT]);
+	if (file)
+		printk(KERN_INFO "file: %u %u %u\n", file_bw[MODE_STD],
+		       file_bw[MODE_MEMCPY], file_bw[MODE_CURRENT]);
+out:
+	down_write(&current->mm->mmap_sem);
+	do_munmap(current->mm, addr, chunk);
+	up_write(&current->mm->mmap_sem);
+
+	return err;
+}
+
+static DEFINE_TEST_TRIGGER(uaccess_perf_trigger, "uaccess_perf",
+			   uaccess_perf_run);
+
+static int __init uaccess_perf_init(void)
+{
+	return test_trigger_register(&uaccess_perf_trigger);
+}
+late_initcall(uaccess_perf_init);
@@ -0,0 +1,712 @@
+/*
+ * Just-In-Time compiler for BPF filters on 32bit ARM
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; version 2 of the License.
+ */
+
+#include <linux/bitops.h>
+#include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/filter.h>
+#include <linux/log2.h>
+#include <linux/moduleloader.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <asm/cacheflush.h>
+#include <asm/thread_info.h>
+#include <asm/unaligned.h>
+
+#include "bpf_jit_32.h"
+
+/*
+ * ABI:
+ *
+ * r0	scratch register, first argument and return value of helpers
+ * r1	offset of the packet load, second argument of the load helpers
+ * r2-r3	scratch, r3 holds the address of the helper being called
+ * r4	A register
+ * r5	X register
+ * r6	pointer to the skb
+ * r7	skb->data
+ * r8	skb_headlen(skb)
+ *
+ * The scratch memory M[] lives on the stack, below the saved registers.
+ * Only ARMv7 is supported: constants are built with movw/movt and packet
+ * loads from the linear data rely on unaligned ldr/ldrh.
+ */
+
+#define r_scratch	ARM_R0
+#define r_off		ARM_R1
+#define r_A		ARM_R4
+#define r_X		ARM_R5
+#define r_skb		ARM_R6
+#define r_skb_data	ARM_R7
+#define r_skb_hl	ARM_R8
+
+#define SEEN_MEM	(1 << 0)	/* M[] is used */
+#define SEEN_DATA	(1 << 1)	/* skb data is loaded */
+#define SEEN_X		(1 << 2)	/* X is used */
+
+#define SCRATCH_SIZE	(BPF_MEMWORDS * 4)
+
+#define SAVED_REGS	((1 << r_A) | (1 << r_X) | (1 << r_skb) | \
+			 (1 << r_skb_data) | (1 << r_skb_hl))
+
+/* instructions in the slow path of a packet load, see emit_load() */
+#define LOAD_SLOW_LEN	7
+
+int bpf_jit_enable __read_mostly;
+EXPORT_SYMBOL_GPL(bpf_jit_enable);
+
+struct jit_ctx {
+	const struct sk_filter *skf;
+	unsigned idx;		/* next instruction */
+	unsigned ret0_idx;	/* "return 0" exit, used when a load fails */
+	u32 seen;
+	u32 *offsets;		/* first instruction of each BPF instruction */
+	u32 *target;		/* NULL while sizing the image */
+};
+
+/*
+ * Same semantics as load_pointer() in net/core/filter.c, including the
+ * SKF_NET_OFF and SKF_LL_OFF negative offsets.
+ */
+static const void *jit_load_pointer(const struct sk_buff *skb, int k,
+				    unsigned int size, void *buffer)
+{
+	u8 *ptr = NULL;
+
+	if (k >= 0)
+		return skb_header_pointer(skb, k, size, buffer);
+
+	if (k >= SKF_NET_OFF)
+		ptr = skb_network_header(skb) + k - SKF_NET_OFF;
+	else if (k >= SKF_LL_OFF)
+		ptr = skb_mac_header(skb) + k - SKF_LL_OFF;
+
+	if (ptr >= skb->head && ptr + size <= skb_tail_pointer(skb))
+		return ptr;
+	return NULL;
+}
+
+/*
+ * Slow path of the packet loads: the value is returned in r0 and a
+ * non-zero r1 tells the caller that the load failed.
+ */
+static u64 jit_get_skb_b(const struct sk_buff *skb, int offset)
+{
+	const u8 *ptr;
+	u8 tmp;
+
+	ptr = jit_load_pointer(skb, offset, 1, &tmp);
+	if (!ptr)
+		return (u64)1 << 32;
+	return *ptr;
+}
+
+static u64 jit_get_skb_h(const struct sk_buff *skb, int offset)
+{
+	const void *ptr;
+	u16 tmp;
+
+	ptr = jit_load_pointer(skb, offset, 2, &tmp);
+	if (!ptr)
+		return (u64)1 << 32;
+	return get_unaligned_be16(ptr);
+}
+
+static u64 jit_get_skb_w(const struct sk_buff *skb, int offset)
+{
+	const void *ptr;
+	u32 tmp;
+
+	ptr = jit_load_pointer(skb, offset, 4, &tmp);
+	if (!ptr)
+		return (u64)1 << 32;
+	return get_unaligned_be32(ptr);
+}
+
+/* Cortex-A9 has no hardware divider */
+static u32 jit_udiv(u32 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+static inline void _emit(int cond, u32 inst, struct jit_ctx *ctx)
+{
+	if (ctx->target != NULL)
+		ctx->target[ctx->idx] = inst | (cond << 28);
+
+	ctx->idx++;
+}
+
+static inline void emit(u32 inst, struct jit_ctx *ctx)
+{
+	_emit(ARM_COND_AL, inst, ctx);
+}
+
+/*
+ * Encode a data processing immediate: an 8 bit value rotated right by an
+ * even amount. Returns -1 when the value cannot be encoded.
+ */
+static int imm8m(u32 x)
+{
+	u32 rot;
+
+	for (rot = 0; rot < 16; rot++)
+		if ((x & ~ror32(0xff, 2 * rot)) == 0)
+			return rol32(x, 2 * rot) | (rot << 8);
+
+	return -1;
+}
+
+static void emit_mov_i(int rd, u32 val, struct jit_ctx *ctx)
+{
+	int imm12 = imm8m(val);
+
+	if (imm12 >= 0) {
+		emit(ARM_MOV_I(rd, imm12), ctx);
+		return;
+	}
+
+	imm12 = imm8m(~val);
+	if (imm12 >= 0) {
+		emit(ARM_MVN_I(rd, imm12), ctx);
+		return;
+	}
+
+	emit(ARM_MOVW(rd, val & 0xffff), ctx);
+	if (val > 0xffff)
+		emit(ARM_MOVT(rd, val >> 16), ctx);
+}
+
+/* movw/movt even for small addresses, branches around calls are fixed */
+static void emit_call(void *func, struct jit_ctx *ctx)
+{
+	u32 addr = (u32)func;
+
+	emit(ARM_MOVW(ARM_R3, addr & 0xffff), ctx);
+	emit(ARM_MOVT(ARM_R3, addr >> 16), ctx);
+	emit(ARM_BLX_R(ARM_R3), ctx);
+}
+
+/* branch offset to the first instruction of BPF instruction tgt */
+static inline int b_imm(unsigned tgt, struct jit_ctx *ctx)
+{
+	if (ctx->target == NULL)
+		return 0;
+
+	/* pc reads as the address of the branch plus 8 */
+	return ctx->offsets[tgt] - (ctx->idx + 2);
+}
+
+static inline int b_ret0(struct jit_ctx *ctx)
+{
+	if (ctx->target == NULL)
+		return 0;
+
+	return ctx->ret0_idx - (ctx->idx + 2);
+}
+
+/* 16 bit loads only have an 8 bit immediate offset, r1 is clobbered */
+static void emit_ldrh_field(int rd, int rn, unsigned off, struct jit_ctx *ctx)
+{
+	if (off < 256) {
+		emit(ARM_LDRH_I(rd, rn, off), ctx);
+	} else {
+		emit_mov_i(ARM_R1, off, ctx);
+		emit(ARM_LDRH_R(rd, rn, ARM_R1), ctx);
+	}
+}
+
+/*
+ * Data processing operation with an immediate operand, going through
+ * the scratch register when the constant cannot be encoded.
+ */
+static void emit_alu_k(u32 op_i, u32 op_r, u32 k, struct jit_ctx *ctx)
+{
+	int imm12 = imm8m(k);
+
+	if (imm12 >= 0) {
+		emit(op_i | r_A << 12 | r_A << 16 | imm12, ctx);
+	} else {
+		emit_mov_i(r_scratch, k, ctx);
+		emit(op_r | r_A << 12 | r_A << 16 | r_scratch, ctx);
+	}
+}
+
+static void build_prologue(struct jit_ctx *ctx)
+{
+	emit(ARM_PUSH(SAVED_REGS | (1 << ARM_LR)), ctx);
+	emit(ARM_MOV_R(r_skb, ARM_R0), ctx);
+
+	if (ctx->seen & SEEN_DATA) {
+		emit(ARM_LDR_I(r_skb_data, r_skb,
+			       offsetof(struct sk_buff, data)), ctx);
+		emit(ARM_LDR_I(r_skb_hl, r_skb,
+			       offsetof(struct sk_buff, len)), ctx);
+		emit(ARM_LDR_I(r_scratch, r_skb,
+			       offsetof(struct sk_buff, data_len)), ctx);
+		emit(ARM_SUB_R(r_skb_hl, r_skb_hl, r_scratch), ctx);
+	}
+
+	/* do not leak kernel data through uninitialised A or X */
+	if (ctx->seen & SEEN_X)
+		emit(ARM_MOV_I(r_X, 0), ctx);
+	emit(ARM_MOV_I(r_A, 0), ctx);
+
+	if (ctx->seen & SEEN_MEM)
+		emit(ARM_SUB_I(ARM_SP, ARM_SP, imm8m(SCRATCH_SIZE)), ctx);
+}
+
+/* return value already in r0 */
+static void build_epilogue(struct jit_ctx *ctx)
+{
+	if (ctx->seen & SEEN_MEM)
+		emit(ARM_ADD_I(ARM_SP, ARM_SP, imm8m(SCRATCH_SIZE)), ctx);
+	emit(ARM_POP(SAVED_REGS | (1 << ARM_PC)), ctx);
+}
+
+static void build_ret0(struct jit_ctx *ctx)
+{
+	ctx->ret0_idx = ctx->idx;
+	emit(ARM_MOV_I(ARM_R0, 0), ctx);
+	build_epilogue(ctx);
+}
+
+/*
+ * Load 1 << order bytes at offset K (or X + K) into rd, straight from the
+ * linear data when it is all there, through the C helpers otherwise.
+ */
+static void emit_load(int rd, unsigned order, bool ind, u32 k,
+		      struct jit_ctx *ctx)
+{
+	static void * const helpers[] = {
+		jit_get_skb_b, jit_get_skb_h, jit_get_skb_w,
+	};
+	int imm12;
+
+	ctx->seen |= SEEN_DATA;
+
+	if (ind) {
+		ctx->seen |= SEEN_X;
+		imm12 = imm8m(k);
+		if (imm12 >= 0) {
+			emit(ARM_ADD_I(r_off, r_X, imm12), ctx);
+		} else {
+			emit_mov_i(r_off, k, ctx);
+			emit(ARM_ADD_R(r_off, r_off, r_X), ctx);
+		}
+	} else {
+		emit_mov_i(r_off, k, ctx);
+	}
+
+	/* negative constant offsets are SKF_NET_OFF/SKF_LL_OFF, slow path */
+	if (ind || (s32)k >= 0) {
+		unsigned fast_len = order ? 3 : 2;
+
+		/* fast path if 0 <= off && off <= headlen - size */
+		emit(ARM_SUB_I(r_scratch, r_skb_hl, 1 << order), ctx);
+		emit(ARM_CMP_R(r_scratch, r_off), ctx);
+		if (ind)
+			_emit(ARM_COND_GE, ARM_CMP_I(r_off, 0), ctx);
+		_emit(ARM_COND_LT, ARM_B(fast_len - 1), ctx);
+
+		switch (order) {
+		case 0:
+			emit(ARM_LDRB_R(rd, r_skb_data, r_off), ctx);
+			break;
+		case 1:
+			emit(ARM_LDRH_R(rd, r_skb_data, r_off), ctx);
+			emit(ARM_REV16(rd, rd), ctx);
+			break;
+		case 2:
+			emit(ARM_LDR_R(rd, r_skb_data, r_off), ctx);
+			emit(ARM_REV(rd, rd), ctx);
+			break;
+		}
+		emit(ARM_B(LOAD_SLOW_LEN - 1), ctx);
+	}
+
+	/* r1 still holds the offset */
+	emit(ARM_MOV_R(ARM_R0, r_skb), ctx);
+	emit_call(helpers[order], ctx);
+	emit(ARM_CMP_I(ARM_R1, 0), ctx);
+	_emit(ARM_COND_NE, ARM_B(b_ret0(ctx)), ctx);
+	emit(ARM_MOV_R(rd, ARM_R0), ctx);
+}
+
+static int build_body(struct jit_ctx *ctx)
+{
+	const struct sk_filter *prog = ctx->skf;
+	const struct sock_filter *inst;
+	unsigned i, condt;
+	int imm12;
+	u32 k;
+
+	for (i = 0; i < prog->len; i++) {
+		inst = &prog->insns[i];
+		k = inst->k;
+
+		ctx->offsets[i] = ctx->idx;
+
+		switch (inst->code) {
+		case BPF_S_LD_IMM:
+			emit_mov_i(r_A, k, ctx);
+			break;
+		case BPF_S_LD_W_LEN:
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, len) != 4);
+			emit(ARM_LDR_I(r_A, r_skb,
+				       offsetof(struct sk_buff, len)), ctx);
+			break;
+		case BPF_S_LD_MEM:
+			ctx->seen |= SEEN_MEM;
+			emit(ARM_LDR_I(r_A, ARM_SP, k * 4), ctx);
+			break;
+		case BPF_S_LD_W_ABS:
+			emit_load(r_A, 2, false, k, ctx);
+			break;
+		case BPF_S_LD_H_ABS:
+			emit_load(r_A, 1, false, k, ctx);
+			break;
+		case BPF_S_LD_B_ABS:
+			emit_load(r_A, 0, false, k, ctx);
+			break;
+		case BPF_S_LD_W_IND:
+			emit_load(r_A, 2, true, k, ctx);
+			break;
+		case BPF_S_LD_H_IND:
+			emit_load(r_A, 1, true, k, ctx);
+			break;
+		case BPF_S_LD_B_IND:
+			emit_load(r_A, 0, true, k, ctx);
+			break;
+		case BPF_S_LDX_IMM:
+			ctx->seen |= SEEN_X;
+			emit_mov_i(r_X, k, ctx);
+			break;
+		case BPF_S_LDX_W_LEN:
+			ctx->seen |= SEEN_X;
+			emit(ARM_LDR_I(r_X, r_skb,
+				       offsetof(struct sk_buff, len)), ctx);
+			break;
+		case BPF_S_LDX_MEM:
+			ctx->seen |= SEEN_X | SEEN_MEM;
+			emit(ARM_LDR_I(r_X, ARM_SP, k * 4), ctx);
+			break;
+		case BPF_S_LDX_B_MSH:
+			/* X = ((*(u8 *)(skb->data + K)) & 0xf) << 2 */
+			ctx->seen |= SEEN_X;
+			emit_load(r_X, 0, false, k, ctx);
+			emit(ARM_AND_I(r_X, r_X, imm8m(0x0f)), ctx);
+			emit(ARM_LSL_I(r_X, r_X, 2), ctx);
+			break;
+		case BPF_S_ST:
+			ctx->seen |= SEEN_MEM;
+			emit(ARM_STR_I(r_A, ARM_SP, k * 4), ctx);
+			break;
+		case BPF_S_STX:
+			ctx->seen |= SEEN_X | SEEN_MEM;
+			emit(ARM_STR_I(r_X, ARM_SP, k * 4), ctx);
+			break;
+		case BPF_S_ALU_ADD_K:
+			emit_alu_k(ARM_INST_ADD_I, ARM_INST_ADD_R, k, ctx);
+			break;
+		case BPF_S_ALU_ADD_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_ADD_R(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_SUB_K:
+			emit_alu_k(ARM_INST_SUB_I, ARM_INST_SUB_R, k, ctx);
+			break;
+		case BPF_S_ALU_SUB_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_SUB_R(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_MUL_K:
+			emit_mov_i(r_scratch, k, ctx);
+			emit(ARM_MUL(r_A, r_A, r_scratch), ctx);
+			break;
+		case BPF_S_ALU_MUL_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_MUL(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_DIV_K:
+			/* sk_chk_filter() turned K into reciprocal_value(K) */
+			emit_mov_i(r_scratch, k, ctx);
+			emit(ARM_UMULL(ARM_R1, r_A, r_scratch, r_A), ctx);
+			break;
+		case BPF_S_ALU_DIV_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_CMP_I(r_X, 0), ctx);
+			_emit(ARM_COND_EQ, ARM_B(b_ret0(ctx)), ctx);
+			emit(ARM_MOV_R(ARM_R0, r_A), ctx);
+			emit(ARM_MOV_R(ARM_R1, r_X), ctx);
+			emit_call(jit_udiv, ctx);
+			emit(ARM_MOV_R(r_A, ARM_R0), ctx);
+			break;
+		case BPF_S_ALU_AND_K:
+			imm12 = imm8m(~k);
+			if (imm8m(k) < 0 && imm12 >= 0)
+				emit(ARM_BIC_I(r_A, r_A, imm12), ctx);
+			else
+				emit_alu_k(ARM_INST_AND_I, ARM_INST_AND_R,
+					   k, ctx);
+			break;
+		case BPF_S_ALU_AND_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_AND_R(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_OR_K:
+			emit_alu_k(ARM_INST_ORR_I, ARM_INST_ORR_R, k, ctx);
+			break;
+		case BPF_S_ALU_OR_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_ORR_R(r_A, r_A, r_X), ctx);
+			break;
+		/*
+		 * Shifts by 32 or more go through a register shift, which is
+		 * what the interpreter compiles to on ARM.
+		 */
+		case BPF_S_ALU_LSH_K:
+			if (k < 32) {
+				if (k)
+					emit(ARM_LSL_I(r_A, r_A, k), ctx);
+			} else {
+				emit_mov_i(r_scratch, k, ctx);
+				emit(ARM_LSL_R(r_A, r_A, r_scratch), ctx);
+			}
+			break;
+		case BPF_S_ALU_LSH_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_LSL_R(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_RSH_K:
+			if (k < 32) {
+				if (k)
+					emit(ARM_LSR_I(r_A, r_A, k), ctx);
+			} else {
+				emit_mov_i(r_scratch, k, ctx);
+				emit(ARM_LSR_R(r_A, r_A, r_scratch), ctx);
+			}
+			break;
+		case BPF_S_ALU_RSH_X:
+			ctx->seen |= SEEN_X;
+			emit(ARM_LSR_R(r_A, r_A, r_X), ctx);
+			break;
+		case BPF_S_ALU_NEG:
+			emit(ARM_RSB_I(r_A, r_A, 0), ctx);
+			break;
+		case BPF_S_MISC_TAX:
+			ctx->seen |= SEEN_X;
+			emit(ARM_MOV_R(r_X, r_A), ctx);
+			break;
+		case BPF_S_MISC_TXA:
+			ctx->seen |= SEEN_X;
+			emit(ARM_MOV_R(r_A, r_X), ctx);
+			break;
+		case BPF_S_RET_K:
+			emit_mov_i(ARM_R0, k, ctx);
+			build_epilogue(ctx);
+			break;
+		case BPF_S_RET_A:
+			emit(ARM_MOV_R(ARM_R0, r_A), ctx);
+			build_epilogue(ctx);
+			break;
+		case BPF_S_JMP_JA:
+			emit(ARM_B(b_imm(i + k + 1, ctx)), ctx);
+			break;
+		case BPF_S_JMP_JEQ_K:
+			condt = ARM_COND_EQ;
+			goto cmp_imm;
+		case BPF_S_JMP_JGT_K:
+			condt = ARM_COND_HI;
+			goto cmp_imm;
+		case BPF_S_JMP_JGE_K:
+			condt = ARM_COND_HS;
+cmp_imm:
+			imm12 = imm8m(k);
+			if (imm12 < 0) {
+				emit_mov_i(r_scratch, k, ctx);
+				emit(ARM_CMP_R(r_A, r_scratch), ctx);
+			} else {
+				emit(ARM_CMP_I(r_A, imm12), ctx);
+			}
+			goto cond_jump;
+		case BPF_S_JMP_JEQ_X:
+			condt = ARM_COND_EQ;
+			goto cmp_x;
+		case BPF_S_JMP_JGT_X:
+			condt = ARM_COND_HI;
+			goto cmp_x;
+		case BPF_S_JMP_JGE_X:
+			condt = ARM_COND_HS;
+cmp_x:
+			ctx->seen |= SEEN_X;
+			emit(ARM_CMP_R(r_A, r_X), ctx);
+			goto cond_jump;
+		case BPF_S_JMP_JSET_K:
+			condt = ARM_COND_NE;
+			imm12 = imm8m(k);
+			if (imm12 < 0) {
+				emit_mov_i(r_scratch, k, ctx);
+				emit(ARM_TST_R(r_A, r_scratch), ctx);
+			} else {
+				emit(ARM_TST_I(r_A, imm12), ctx);
+			}
+			goto cond_jump;
+		case BPF_S_JMP_JSET_X:
+			condt = ARM_COND_NE;
+			ctx->seen |= SEEN_X;
+			emit(ARM_TST_R(r_A, r_X), ctx);
+cond_jump:
+			/* inverting the low bit of the condition negates it */
+			if (inst->jt)
+				_emit(condt, ARM_B(b_imm(i + inst->jt + 1,
+							 ctx)), ctx);
+			if (inst->jf)
+				_emit(condt ^ 1, ARM_B(b_imm(i + inst->jf + 1,
+							     ctx)), ctx);
+			break;
+		case BPF_S_ANC_PROTOCOL:
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, protocol) != 2);
+			emit_ldrh_field(r_A, r_skb,
+					offsetof(struct sk_buff, protocol), ctx);
+			emit(ARM_REV16(r_A, r_A), ctx);
+			break;
+		case BPF_S_ANC_IFINDEX:
+		case BPF_S_ANC_HATYPE:
+			BUILD_BUG_ON(offsetof(struct sk_buff, dev) > 4095);
+			emit(ARM_LDR_I(r_scratch, r_skb,
+				       offsetof(struct sk_buff, dev)), ctx);
+			emit(ARM_CMP_I(r_scratch, 0), ctx);
+			_emit(ARM_COND_EQ, ARM_B(b_ret0(ctx)), ctx);
+
+			if (inst->code == BPF_S_ANC_IFINDEX) {
+				BUILD_BUG_ON(FIELD_SIZEOF(struct net_device,
+							  ifindex) != 4);
+				BUILD_BUG_ON(offsetof(struct net_device,
+						      ifindex) > 4095);
+				emit(ARM_LDR_I(r_A, r_scratch,
+					       offsetof(struct net_device,
+							ifindex)), ctx);
+			} else {
+				BUILD_BUG_ON(FIELD_SIZEOF(struct net_device,
+							  type) != 2);
+				emit_ldrh_field(r_A, r_scratch,
+						offsetof(struct net_device,
+							 type), ctx);
+			}
+			break;
+		case BPF_S_ANC_MARK:
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, mark) != 4);
+			emit(ARM_LDR_I(r_A, r_skb,
+				       offsetof(struct sk_buff, mark)), ctx);
+			break;
+		case BPF_S_ANC_RXHASH:
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff, rxhash) != 4);
+			emit(ARM_LDR_I(r_A, r_skb,
+				       offsetof(struct sk_buff, rxhash)), ctx);
+			break;
+		case BPF_S_ANC_QUEUE:
+			BUILD_BUG_ON(FIELD_SIZEOF(struct sk_buff,
+						  queue_mapping) != 2);
+			emit_ldrh_field(r_A, r_skb,
+					offsetof(struct sk_buff,
+						 queue_mapping), ctx);
+			break;
+		case BPF_S_ANC_CPU:
+#ifdef CONFIG_SMP
+			/* A = current_thread_info()->cpu */
+			emit(ARM_MOV_R(r_scratch, ARM_SP), ctx);
+			emit(ARM_LSR_I(r_scratch, r_scratch,
+				       ilog2(THREAD_SIZE)), ctx);
+			emit(ARM_LSL_I(r_scratch, r_scratch,
+				       ilog2(THREAD_SIZE)), ctx);
+			BUILD_BUG_ON(FIELD_SIZEOF(struct thread_info, cpu) != 4);
+			emit(ARM_LDR_I(r_A, r_scratch,
+				       offsetof(struct thread_info, cpu)), ctx);
+#else
+			emit(ARM_MOV_I(r_A, 0), ctx);
+#endif
+			break;
+		default:
+			/* pkttype, netlink attributes: leave to the interpreter */
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void bpf_jit_compile(struct sk_filter *fp)
+{
+	struct jit_ctx ctx;
+	unsigned alloc_size;
+
+	if (!bpf_jit_enable)
+		return;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.skf = fp;
+
+	ctx.offsets = kzalloc(fp->len * sizeof(*ctx.offsets), GFP_KERNEL);
+	if (ctx.offsets == NULL)
+		return;
+
+	/* find out which registers, helpers and scratch memory are used */
+	if (build_body(&ctx))
+		goto out;
+
+	/* size the image now that the prologue is known */
+	ctx.idx = 0;
+	build_prologue(&ctx);
+	build_body(&ctx);
+	build_ret0(&ctx);
+
+	/* the image is reused as a work_struct by bpf_jit_free() */
+	alloc_size = max_t(unsigned, ctx.idx * 4, sizeof(struct work_struct));
+	ctx.target = module_alloc(alloc_size);
+	if (unlikely(ctx.target == NULL))
+		goto out;
+
+	ctx.idx = 0;
+	build_prologue(&ctx);
+	build_body(&ctx);
+	build_ret0(&ctx);
+
+	flush_icache_range((u32)ctx.target, (u32)(ctx.target + ctx.idx));
+
+	if (bpf_jit_enable > 1)
+		print_hex_dump(KERN_INFO, "BPF JIT code: ",
+			       DUMP_PREFIX_ADDRESS, 16, 4, ctx.target,
+			       ctx.idx * 4, false);
+
+	fp->bpf_func = (void *)ctx.target;
+out:
+	kfree(ctx.offsets);
+}
+EXPORT_SYMBOL_GPL(bpf_jit_compile);
+
+static void bpf_jit_free_worker(struct work_struct *work)
+{
+	module_free(NULL, work);
+}
+
+/* called from softirq, module_free() needs process context */
+void bpf_jit_free(struct sk_filter *fp)
+{
+	struct work_struct *work;
+
+	if (fp->bpf_func != sk_run_filter) {
+		work = (struct work_struct *)fp->bpf_func;
+
+		INIT_WORK(work, bpf_jit_free_worker);
+		schedule_work(work);
+	}
+}
+EXPORT_SYMBOL_GPL(bpf_jit_free);
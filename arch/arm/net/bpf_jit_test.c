@@ -0,0 +1,437 @@
+/*
+ * BPF JIT test for 32bit ARM
+ *
+ * Every filter is run over a few sample packets by both sk_run_filter()
+ * and the JIT image, results must match. The time per packet of each is
+ * reported so the JIT can be compared against the interpreter.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; version 2 of the License.
+ */
+
+#include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/skbuff.h>
+#include <linux/netdevice.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <linux/math64.h>
+#include <linux/err.h>
+
+static unsigned int try_cnt = 10000;
+module_param(try_cnt, uint, S_IRUGO);
+MODULE_PARM_DESC(try_cnt, "Try count to test");
+
+static struct task_struct *bpftest_task;
+
+struct bpftest_filter {
+	const char *name;
+	unsigned int len;
+	struct sock_filter insns[24];
+};
+
+static struct bpftest_filter bpftest_filters[] = {
+	{
+		.name = "accept",
+		.len = 1,
+		.insns = {
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+		},
+	},
+	{
+		.name = "ip",
+		.len = 4,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 1),
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+		},
+	},
+	{
+		/* tcpdump -dd "ip and tcp port 22" */
+		.name = "tcp port 22",
+		.len = 14,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 11),
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 6, 0, 9),
+			BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),
+			BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 7, 0),
+			BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+			BPF_STMT(BPF_LD | BPF_H | BPF_IND, 14),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 22, 3, 0),
+			BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 22, 1, 0),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+		},
+	},
+	{
+		/* udp dst port 67, then the whole BOOTP op/htype/hlen word */
+		.name = "dhcp request",
+		.len = 11,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 8),
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 17, 0, 6),
+			BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+			BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 67, 0, 3),
+			BPF_STMT(BPF_LD | BPF_W | BPF_IND, 22),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x01010600, 0, 1),
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+		},
+	},
+	{
+		/* every ALU op, the result is the return value */
+		.name = "alu",
+		.len = 23,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 26),
+			BPF_STMT(BPF_ST, 0),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_K, 0x12345678),
+			BPF_STMT(BPF_ALU | BPF_SUB | BPF_K, 0x1000),
+			BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, 7),
+			BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, 3),
+			BPF_STMT(BPF_ALU | BPF_OR | BPF_K, 0x80000001),
+			BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xfff0fff0),
+			BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 3),
+			BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 5),
+			BPF_STMT(BPF_MISC | BPF_TAX, 0),
+			BPF_STMT(BPF_LD | BPF_MEM, 0),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+			BPF_STMT(BPF_ALU | BPF_MUL | BPF_X, 0),
+			BPF_STMT(BPF_ALU | BPF_SUB | BPF_X, 0),
+			BPF_STMT(BPF_ALU | BPF_NEG, 0),
+			BPF_STMT(BPF_STX, 1),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, 1),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 3),
+			BPF_STMT(BPF_ALU | BPF_LSH | BPF_X, 0),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_LEN, 0),
+			BPF_STMT(BPF_ALU | BPF_DIV | BPF_X, 0),
+			BPF_STMT(BPF_RET | BPF_A, 0),
+		},
+	},
+	{
+		/* division by a zero X returns 0 */
+		.name = "div by zero",
+		.len = 4,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 0),
+			BPF_STMT(BPF_ALU | BPF_DIV | BPF_X, 0),
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+		},
+	},
+	{
+		.name = "jumps",
+		.len = 12,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+			BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, 60, 0, 8),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 100),
+			BPF_JUMP(BPF_JMP | BPF_JGE | BPF_X, 0, 0, 2),
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 14),
+			BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x40, 3, 5),
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 21),
+			BPF_JUMP(BPF_JMP | BPF_JSET | BPF_X, 0, 2, 0),
+			BPF_JUMP(BPF_JMP | BPF_JA, 2, 0, 0),
+			BPF_STMT(BPF_RET | BPF_K, 1),
+			BPF_STMT(BPF_RET | BPF_K, 2),
+			BPF_STMT(BPF_RET | BPF_K, 3),
+		},
+	},
+	{
+		/* sum of the ancillary fields */
+		.name = "ancillary",
+		.len = 14,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PROTOCOL),
+			BPF_STMT(BPF_MISC | BPF_TAX, 0),
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_IFINDEX),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+			BPF_STMT(BPF_MISC | BPF_TAX, 0),
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_MARK),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+			BPF_STMT(BPF_MISC | BPF_TAX, 0),
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_QUEUE),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+			BPF_STMT(BPF_MISC | BPF_TAX, 0),
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_RXHASH),
+			BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),
+			BPF_STMT(BPF_RET | BPF_A, 0),
+		},
+	},
+	{
+		/* loads past the end of the packet return 0 */
+		.name = "out of bounds",
+		.len = 5,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+			BPF_STMT(BPF_LDX | BPF_W | BPF_LEN, 0),
+			BPF_STMT(BPF_LD | BPF_W | BPF_IND, 2),
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 4000),
+			BPF_STMT(BPF_RET | BPF_K, 0xffff),
+		},
+	},
+	{
+		/* network header relative loads go through the helpers */
+		.name = "net offset",
+		.len = 5,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_NET_OFF + 9),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 6, 0, 2),
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 16),
+			BPF_STMT(BPF_RET | BPF_A, 0),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+		},
+	},
+	{
+		/* not handled by the JIT, stays on the interpreter */
+		.name = "pkttype",
+		.len = 2,
+		.insns = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+			BPF_STMT(BPF_RET | BPF_A, 0),
+		},
+	},
+};
+
+static const u8 bpftest_tcp[] = {
+	/* ethernet */
+	0x00, 0x1e, 0x06, 0x11, 0x22, 0x33, 0x00, 0x1e,
+	0x06, 0x44, 0x55, 0x66, 0x08, 0x00,
+	/* ipv4, 20 bytes, tcp */
+	0x45, 0x00, 0x00, 0x34, 0x1c, 0x46, 0x40, 0x00,
+	0x40, 0x06, 0x00, 0x00, 0xc0, 0xa8, 0x00, 0x02,
+	0xc0, 0xa8, 0x00, 0x01,
+	/* tcp, 9002 -> 22 */
+	0x23, 0x2a, 0x00, 0x16, 0x00, 0x00, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x80, 0x02, 0x72, 0x10,
+	0x00, 0x00, 0x00, 0x00, 0x02, 0x04, 0x05, 0xb4,
+	0x01, 0x03, 0x03, 0x06, 0x01, 0x01, 0x04, 0x02,
+};
+
+static const u8 bpftest_dhcp[] = {
+	/* ethernet, broadcast */
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x1e,
+	0x06, 0x44, 0x55, 0x66, 0x08, 0x00,
+	/* ipv4, 20 bytes, udp */
+	0x45, 0x10, 0x01, 0x48, 0x00, 0x00, 0x00, 0x00,
+	0x80, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xff, 0xff, 0xff, 0xff,
+	/* udp, 68 -> 67 */
+	0x00, 0x44, 0x00, 0x43, 0x01, 0x34, 0x00, 0x00,
+	/* bootp request, ethernet, 6 byte hw address */
+	0x01, 0x01, 0x06, 0x00, 0x39, 0x03, 0xf3, 0x26,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const u8 bpftest_arp[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x1e,
+	0x06, 0x44, 0x55, 0x66, 0x08, 0x06,
+	0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01,
+	0x00, 0x1e, 0x06, 0x44, 0x55, 0x66, 0xc0, 0xa8,
+	0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xc0, 0xa8, 0x00, 0x01,
+};
+
+static const u8 bpftest_runt[] = {
+	0x00, 0x1e, 0x06, 0x11, 0x22, 0x33, 0x00, 0x1e,
+	0x06, 0x44, 0x55, 0x66, 0x08,
+};
+
+#define BPFTEST_NR_SKBS	5
+
+static struct sk_buff *bpftest_alloc_skb(const u8 *data, unsigned int len,
+					 unsigned int headlen)
+{
+	struct sk_buff *skb;
+	struct page *page;
+
+	skb = alloc_skb(NET_IP_ALIGN + len, GFP_KERNEL);
+	if (!skb)
+		return NULL;
+
+	skb_reserve(skb, NET_IP_ALIGN);
+	memcpy(skb_put(skb, headlen), data, headlen);
+
+	/* the rest goes to a page fragment, as a SG capable driver would */
+	if (headlen < len) {
+		page = alloc_page(GFP_KERNEL);
+		if (!page) {
+			kfree_skb(skb);
+			return NULL;
+		}
+		memcpy(page_address(page), data + headlen, len - headlen);
+		skb_fill_page_desc(skb, 0, page, 0, len - headlen);
+		skb->len += len - headlen;
+		skb->data_len += len - headlen;
+		skb->truesize += PAGE_SIZE;
+	}
+
+	skb_reset_mac_header(skb);
+	if (len >= ETH_HLEN) {
+		skb_set_network_header(skb, ETH_HLEN);
+		skb->protocol = ((__be16 *)data)[6];
+	}
+	skb->mark = 0x5a;
+	skb->rxhash = 0x12345678;
+	skb_record_rx_queue(skb, 1);
+
+	return skb;
+}
+
+static int bpftest_alloc_skbs(struct sk_buff **skbs)
+{
+	skbs[0] = bpftest_alloc_skb(bpftest_tcp, sizeof(bpftest_tcp),
+				    sizeof(bpftest_tcp));
+	skbs[1] = bpftest_alloc_skb(bpftest_dhcp, sizeof(bpftest_dhcp),
+				    sizeof(bpftest_dhcp));
+	skbs[2] = bpftest_alloc_skb(bpftest_arp, sizeof(bpftest_arp),
+				    sizeof(bpftest_arp));
+	skbs[3] = bpftest_alloc_skb(bpftest_runt, sizeof(bpftest_runt),
+				    sizeof(bpftest_runt));
+	/* ports and tcp header only reachable through skb_copy_bits() */
+	skbs[4] = bpftest_alloc_skb(bpftest_tcp, sizeof(bpftest_tcp),
+				    ETH_HLEN + 20);
+
+	return skbs[0] && skbs[1] && skbs[2] && skbs[3] && skbs[4] ?
+		0 : -ENOMEM;
+}
+
+static u64 bpftest_time(struct sk_filter *fp, struct sk_buff **skbs, bool jit)
+{
+	u64 start, total;
+	unsigned int i, j;
+
+	preempt_disable();
+	start = sched_clock();
+	for (i = 0; i < try_cnt; i++)
+		for (j = 0; j < BPFTEST_NR_SKBS; j++) {
+			if (jit)
+				fp->bpf_func(skbs[j], fp->insns);
+			else
+				sk_run_filter(skbs[j], fp->insns);
+		}
+	total = sched_clock() - start;
+	preempt_enable();
+
+	return div_u64(total, try_cnt * BPFTEST_NR_SKBS);
+}
+
+static int bpftest_run(struct bpftest_filter *f, struct sk_buff **skbs)
+{
+	struct sk_filter *fp;
+	unsigned int j, ret, jit_ret;
+	int enable, err = 0;
+	u64 interp_ns, jit_ns;
+
+	fp = kmalloc(sizeof(*fp) + f->len * sizeof(struct sock_filter),
+		     GFP_KERNEL);
+	if (!fp)
+		return -ENOMEM;
+
+	fp->len = f->len;
+	memcpy(fp->insns, f->insns, f->len * sizeof(struct sock_filter));
+
+	err = sk_chk_filter(fp->insns, fp->len);
+	if (err) {
+		printk(KERN_ERR "%-16s: rejected by sk_chk_filter (%d)\n",
+		       f->name, err);
+		goto out;
+	}
+
+	fp->bpf_func = sk_run_filter;
+	enable = bpf_jit_enable;
+	bpf_jit_enable = 1;
+	bpf_jit_compile(fp);
+	bpf_jit_enable = enable;
+
+	if (fp->bpf_func == sk_run_filter) {
+		printk(KERN_INFO "%-16s: not compiled, interpreter only\n",
+		       f->name);
+		goto out;
+	}
+
+	for (j = 0; j < BPFTEST_NR_SKBS; j++) {
+		ret = sk_run_filter(skbs[j], fp->insns);
+		jit_ret = fp->bpf_func(skbs[j], fp->insns);
+		if (ret != jit_ret) {
+			printk(KERN_ERR "%-16s: packet %u, interpreter %u, "
+			       "jit %u\n", f->name, j, ret, jit_ret);
+			err = -EINVAL;
+		}
+	}
+
+	interp_ns = bpftest_time(fp, skbs, false);
+	jit_ns = bpftest_time(fp, skbs, true);
+	printk(KERN_INFO "%-16s: interpreter %llu ns, jit %llu ns (x%llu)\n",
+	       f->name, interp_ns, jit_ns,
+	       jit_ns ? div64_u64(interp_ns, jit_ns) : 0);
+
+	bpf_jit_free(fp);
+out:
+	kfree(fp);
+	return err;
+}
+
+static int thread_func(void *data)
+{
+	struct sk_buff *skbs[BPFTEST_NR_SKBS] = { NULL };
+	unsigned int i, failed = 0;
+
+	printk(KERN_INFO "## BPF JIT test (try_cnt: %d)\n", try_cnt);
+
+	if (bpftest_alloc_skbs(skbs)) {
+		printk(KERN_ERR "Failed to allocate test packets\n");
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bpftest_filters); i++)
+		if (bpftest_run(&bpftest_filters[i], skbs))
+			failed++;
+
+	printk(KERN_INFO "## BPF JIT test: %u of %zu filters failed\n",
+	       failed, ARRAY_SIZE(bpftest_filters));
+out:
+	for (i = 0; i < BPFTEST_NR_SKBS; i++)
+		kfree_skb(skbs[i]);
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		schedule();
+	}
+
+	return 0;
+}
+
+static int __init bpftest_init(void)
+{
+	bpftest_task = kthread_run(thread_func, NULL, "bpftest_thread");
+	if (IS_ERR(bpftest_task)) {
+		printk(KERN_ERR "Failed to create bpftest thread\n");
+		return PTR_ERR(bpftest_task);
+	}
+
+	return 0;
+}
+module_init(bpftest_init);
+
+static void __exit bpftest_exit(void)
+{
+	kthread_stop(bpftest_task);
+}
+module_exit(bpftest_exit);
+MODULE_LICENSE("GPL");
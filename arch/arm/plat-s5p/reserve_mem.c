@@ -14,6 +14,7 @@
 #include <linux/memblock.h>
 #include <linux/mm.h>
 #include <linux/swap.h>
+#include <linux/string.h>
 #include <asm/setup.h>
 #include <linux/io.h>
 #include <mach/memory.h>
@@ -44,6 +45,12 @@ void __init s5p_cma_region_reserve(struct cma_region *regions_normal,
 			continue;
 		}
 
+#ifdef CONFIG_USE_FIMC_CMA
+		/* FIMC0/1 only need their buffers while the camera runs */
+		if (!strcmp(reg->name, "fimc0") || !strcmp(reg->name, "fimc1"))
+			reg->lend = 1;
+#endif
+
 		if (reg->alignment) {
 			if ((reg->alignment & ~PAGE_MASK) ||
 				(reg->alignment & ~reg->alignment)) {
@@ -157,6 +164,8 @@ void __init s5p_cma_region_reserve(struct cma_region *regions_normal,
 			do {
 				reg->start = paddr_last;
 				reg->reserved = 1;
+				/* the secure world owns these, never lend */
+				reg->nolend = 1;
 				paddr_last += reg->size;
 
 				pr_debug("S5P/CMA: "
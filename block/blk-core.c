@@ -1768,6 +1768,11 @@ static void blk_account_io_completion(struct request *req, unsigned int bytes)
 		part = req->part;
 		part_stat_add(cpu, part, sectors[rw], bytes >> 9);
 		part_stat_unlock();
+
+		/* whole reads only, they size the readahead window */
+		if (rw == READ && bytes == blk_rq_bytes(req))
+			bdi_account_read(&req->q->backing_dev_info, bytes,
+					 jiffies - req->start_time);
 	}
 }
 
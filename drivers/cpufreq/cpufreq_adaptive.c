@@ -326,10 +326,12 @@ static ssize_t store_##file_name##_old					\
 
 static void cpufreq_adaptive_timer(unsigned long data)
 {
+#ifndef CONFIG_SCHED_CPU_UTIL
 	cputime64_t cur_idle;
 	cputime64_t cur_wall;
 	unsigned int delta_idle;
 	unsigned int delta_time;
+#endif
 	int short_load;
 	unsigned int new_freq;
 	unsigned long flags;
@@ -344,6 +346,14 @@ static void cpufreq_adaptive_timer(unsigned long data)
 	policy = this_dbs_info->cur_policy;
 
 	for_each_online_cpu(j) {
+#ifdef CONFIG_SCHED_CPU_UTIL
+		/*
+		 * Like the idle exit sample it replaces, the short-term
+		 * load does not follow ignore_nice_load nor io_is_busy,
+		 * those apply to dbs_check_cpu() only.
+		 */
+		short_load = sched_cpu_util(j) * 100 / SCHED_UTIL_SCALE;
+#else
 		cur_idle = get_cpu_idle_time_us(j, &cur_wall);
 
 		delta_idle = (unsigned int) cputime64_sub(cur_idle,
@@ -361,6 +371,7 @@ static void cpufreq_adaptive_timer(unsigned long data)
 			short_load = 0;
 		else
 			short_load = 100 * (delta_time - delta_idle) / delta_time;
+#endif
 
 		if (short_load > max_load)
 			max_load = short_load;
@@ -512,6 +523,17 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 
 		load = 100 * (wall_time - idle_time) / wall_time;
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+		/*
+		 * The decayed busy time kept by the scheduler counts nice
+		 * tasks as busy and iowait as idle, so it is used only when
+		 * neither ignore_nice_load nor io_is_busy asks otherwise.
+		 * The deltas above are kept up to date either way.
+		 */
+		if (!dbs_tuners_ins.ignore_nice && !dbs_tuners_ins.io_is_busy)
+			load = sched_cpu_util(j) * 100 / SCHED_UTIL_SCALE;
+#endif
+
 		if (load > longterm_load)
 			longterm_load = load;
 
@@ -27,9 +27,15 @@
 #include <linux/workqueue.h>
 #include <linux/kthread.h>
 #include <linux/mutex.h>
+#include <linux/input.h>
+#include <linux/slab.h>
+#include <linux/cpufreq_interactive.h>
 
 #include <asm/cputime.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/cpufreq_interactive.h>
+
 static atomic_t active_count = ATOMIC_INIT(0);
 
 struct cpufreq_interactive_cpuinfo {
@@ -78,6 +84,30 @@ static unsigned long min_sample_time;
 #define DEFAULT_TIMER_RATE 20 * USEC_PER_MSEC
 static unsigned long timer_rate;
 
+/*
+ * How long a boost holds the CPUs at hispeed_freq at least.
+ */
+#define DEFAULT_BOOSTPULSE_DURATION 80 * USEC_PER_MSEC
+static unsigned long boostpulse_duration;
+
+/* Boost on touch and key events */
+static int input_boost;
+
+/* The boost window, set and ended from the timers of all CPUs */
+static DEFINE_SPINLOCK(boost_lock);
+static u64 boostpulse_endtime;
+static u64 boost_start_time;
+static int boost_ramping;
+static int boost_active;
+
+static ATOMIC_NOTIFIER_HEAD(boost_notifier_list);
+
+static const char * const boost_reason_name[] = {
+	[INTERACTIVE_BOOST_INPUT]	= "input",
+	[INTERACTIVE_BOOST_HISPEED]	= "hispeed",
+	[INTERACTIVE_BOOST_USER]	= "user",
+};
+
 static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		unsigned int event);
 
@@ -91,12 +121,106 @@ struct cpufreq_governor cpufreq_gov_interactive = {
 	.owner = THIS_MODULE,
 };
 
+/* Let the listeners ramp the bus and the cores together with cpufreq */
+static void cpufreq_interactive_boost_call(
+		enum cpufreq_interactive_boost_reason reason, u64 now)
+{
+	struct cpufreq_interactive_boost boost;
+
+	boost.reason = reason;
+	boost.start_us = now;
+	boost.duration_us = boostpulse_duration;
+
+	trace_cpufreq_interactive_boost(boost_reason_name[reason],
+					boostpulse_duration);
+	atomic_notifier_call_chain(&boost_notifier_list,
+				   INTERACTIVE_BOOST_START, &boost);
+}
+
+/*
+ * Start or extend the boost window that holds every CPU at hispeed_freq.
+ * A request arriving while more than half of the current window is left
+ * is dropped, this keeps a stream of input events cheap.
+ */
+static bool cpufreq_interactive_boost_notify(
+		enum cpufreq_interactive_boost_reason reason)
+{
+	u64 now = ktime_to_us(ktime_get());
+	unsigned long flags;
+
+	spin_lock_irqsave(&boost_lock, flags);
+	if (now + boostpulse_duration / 2 < boostpulse_endtime) {
+		spin_unlock_irqrestore(&boost_lock, flags);
+		return false;
+	}
+
+	boostpulse_endtime = now + boostpulse_duration;
+	if (!boost_active)
+		boost_start_time = now;
+	boost_active = 1;
+	boost_ramping = 1;
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	cpufreq_interactive_boost_call(reason, now);
+	return true;
+}
+
+void cpufreq_interactive_boost(enum cpufreq_interactive_boost_reason reason)
+{
+	unsigned int i;
+	int anyboost = 0;
+	unsigned long flags;
+	struct cpufreq_interactive_cpuinfo *pcpu;
+
+	if (!atomic_read(&active_count))
+		return;
+
+	if (!cpufreq_interactive_boost_notify(reason))
+		return;
+
+	spin_lock_irqsave(&up_cpumask_lock, flags);
+
+	for_each_online_cpu(i) {
+		pcpu = &per_cpu(cpuinfo, i);
+		if (!pcpu->governor_enabled)
+			continue;
+
+		if (pcpu->target_freq < hispeed_freq) {
+			pcpu->target_freq = hispeed_freq;
+			cpumask_set_cpu(i, &up_cpumask);
+			anyboost = 1;
+		}
+	}
+
+	spin_unlock_irqrestore(&up_cpumask_lock, flags);
+
+	if (anyboost)
+		wake_up_process(up_task);
+}
+EXPORT_SYMBOL_GPL(cpufreq_interactive_boost);
+
+int cpufreq_interactive_register_boost_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&boost_notifier_list, nb);
+}
+EXPORT_SYMBOL_GPL(cpufreq_interactive_register_boost_notifier);
+
+int cpufreq_interactive_unregister_boost_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&boost_notifier_list, nb);
+}
+EXPORT_SYMBOL_GPL(cpufreq_interactive_unregister_boost_notifier);
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(cpufreq_interactive_boost_ramp);
+
 static void cpufreq_interactive_timer(unsigned long data)
 {
+#ifndef CONFIG_SCHED_CPU_UTIL
 	unsigned int delta_idle;
 	unsigned int delta_time;
-	int cpu_load;
 	int load_since_change;
+#endif
+	int cpu_load;
 	u64 time_in_idle;
 	u64 idle_exit_time;
 	struct cpufreq_interactive_cpuinfo *pcpu =
@@ -105,6 +229,8 @@ static void cpufreq_interactive_timer(unsigned long data)
 	unsigned int new_freq;
 	unsigned int index;
 	unsigned long flags;
+	unsigned long boost_len = 0;
+	bool unboost = false;
 
 	smp_rmb();
 
@@ -129,6 +255,13 @@ static void cpufreq_interactive_timer(unsigned long data)
 	if (!idle_exit_time)
 		goto exit;
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+	/*
+	 * The scheduler keeps a decayed utilization that already covers
+	 * both short bursts and the time since the last speed change.
+	 */
+	cpu_load = sched_cpu_util(data) * 100 / SCHED_UTIL_SCALE;
+#else
 	delta_idle = (unsigned int) cputime64_sub(now_idle, time_in_idle);
 	delta_time = (unsigned int) cputime64_sub(pcpu->timer_run_time,
 						  idle_exit_time);
@@ -162,16 +295,42 @@ static void cpufreq_interactive_timer(unsigned long data)
 	 */
 	if (load_since_change > cpu_load)
 		cpu_load = load_since_change;
+#endif
 
 	if (cpu_load >= go_hispeed_load) {
-		if (pcpu->policy->cur == pcpu->policy->min)
+		if (pcpu->policy->cur == pcpu->policy->min) {
 			new_freq = hispeed_freq;
-		else
+			/*
+			 * Only this CPU jumps, the others keep following
+			 * their own load; the bus and the cores still get
+			 * to ramp with it.
+			 */
+			cpufreq_interactive_boost_call(
+				INTERACTIVE_BOOST_HISPEED,
+				ktime_to_us(ktime_get()));
+		} else {
 			new_freq = pcpu->policy->max * cpu_load / 100;
+		}
 	} else {
 		new_freq = pcpu->policy->cur * cpu_load / 100;
 	}
 
+	/* Hold hispeed_freq until the boost window is over */
+	spin_lock_irqsave(&boost_lock, flags);
+	if (boost_active) {
+		if (pcpu->timer_run_time < boostpulse_endtime) {
+			if (new_freq < hispeed_freq)
+				new_freq = hispeed_freq;
+		} else {
+			boost_active = 0;
+			boost_len = pcpu->timer_run_time - boost_start_time;
+			unboost = true;
+		}
+	}
+	spin_unlock_irqrestore(&boost_lock, flags);
+	if (unboost)
+		trace_cpufreq_interactive_unboost(boost_len);
+
 	if (cpufreq_frequency_table_target(pcpu->policy, pcpu->freq_table,
 					   new_freq, CPUFREQ_RELATION_H,
 					   &index)) {
@@ -332,6 +491,8 @@ static int cpufreq_interactive_up_task(void *data)
 	unsigned int cpu;
 	cpumask_t tmp_mask;
 	unsigned long flags;
+	unsigned long ramp_len = 0;
+	bool ramped;
 	struct cpufreq_interactive_cpuinfo *pcpu;
 
 	while (1) {
@@ -377,6 +538,19 @@ static int cpufreq_interactive_up_task(void *data)
 				__cpufreq_driver_target(pcpu->policy,
 							max_freq,
 							CPUFREQ_RELATION_H);
+
+			ramped = false;
+			spin_lock_irqsave(&boost_lock, flags);
+			if (boost_ramping && pcpu->policy->cur >= hispeed_freq) {
+				boost_ramping = 0;
+				ramp_len = ktime_to_us(ktime_get()) -
+					   boost_start_time;
+				ramped = true;
+			}
+			spin_unlock_irqrestore(&boost_lock, flags);
+			if (ramped)
+				trace_cpufreq_interactive_boost_ramp("cpufreq",
+								     ramp_len);
 			mutex_unlock(&set_speed_lock);
 
 			pcpu->freq_change_time_in_idle =
@@ -521,11 +695,69 @@ static ssize_t store_timer_rate(struct kobject *kobj,
 static struct global_attr timer_rate_attr = __ATTR(timer_rate, 0644,
 		show_timer_rate, store_timer_rate);
 
+static ssize_t show_boostpulse_duration(struct kobject *kobj,
+			struct attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", boostpulse_duration);
+}
+
+static ssize_t store_boostpulse_duration(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = strict_strtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	boostpulse_duration = val;
+	return count;
+}
+
+static struct global_attr boostpulse_duration_attr =
+	__ATTR(boostpulse_duration, 0644, show_boostpulse_duration,
+	       store_boostpulse_duration);
+
+static ssize_t store_boostpulse(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	cpufreq_interactive_boost(INTERACTIVE_BOOST_USER);
+	return count;
+}
+
+static struct global_attr boostpulse_attr = __ATTR(boostpulse, 0200,
+		NULL, store_boostpulse);
+
+static ssize_t show_input_boost(struct kobject *kobj,
+			struct attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", input_boost);
+}
+
+static ssize_t store_input_boost(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = strict_strtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	input_boost = !!val;
+	return count;
+}
+
+static struct global_attr input_boost_attr = __ATTR(input_boost, 0644,
+		show_input_boost, store_input_boost);
+
 static struct attribute *interactive_attributes[] = {
 	&hispeed_freq_attr.attr,
 	&go_hispeed_load_attr.attr,
 	&min_sample_time_attr.attr,
 	&timer_rate_attr.attr,
+	&boostpulse_duration_attr.attr,
+	&boostpulse_attr.attr,
+	&input_boost_attr.attr,
 	NULL,
 };
 
@@ -636,6 +868,120 @@ static struct notifier_block cpufreq_interactive_idle_nb = {
 	.notifier_call = cpufreq_interactive_idle_notifier,
 };
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+/*
+ * The utilization of a busy CPU moved a lot since the last report,
+ * re-evaluate its speed now instead of at the next timer_rate sample.
+ * Runs from the tick of that CPU.
+ */
+static int cpufreq_interactive_util_notifier(struct notifier_block *nb,
+					     unsigned long val, void *data)
+{
+	struct sched_util_change *change = data;
+	struct cpufreq_interactive_cpuinfo *pcpu =
+		&per_cpu(cpuinfo, change->cpu);
+
+	if (!pcpu->governor_enabled)
+		return NOTIFY_DONE;
+
+	if (timer_pending(&pcpu->cpu_timer)) {
+		mod_timer(&pcpu->cpu_timer, jiffies);
+	} else if (pcpu->timer_run_time >= pcpu->idle_exit_time) {
+		pcpu->time_in_idle = get_cpu_idle_time_us(change->cpu,
+						&pcpu->idle_exit_time);
+		pcpu->timer_idlecancel = 0;
+		mod_timer(&pcpu->cpu_timer, jiffies);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpufreq_interactive_util_nb = {
+	.notifier_call = cpufreq_interactive_util_notifier,
+};
+#endif
+
+static void cpufreq_interactive_input_event(struct input_handle *handle,
+					    unsigned int type,
+					    unsigned int code, int value)
+{
+	if (input_boost && type == EV_SYN && code == SYN_REPORT)
+		cpufreq_interactive_boost(INTERACTIVE_BOOST_INPUT);
+}
+
+static int cpufreq_interactive_input_connect(struct input_handler *handler,
+					     struct input_dev *dev,
+					     const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpufreq_interactive";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_free;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_unregister;
+
+	return 0;
+
+err_unregister:
+	input_unregister_handle(handle);
+err_free:
+	kfree(handle);
+	return error;
+}
+
+static void cpufreq_interactive_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id cpufreq_interactive_ids[] = {
+	/* multi-touch touchscreens */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			    BIT_MASK(ABS_MT_POSITION_X) |
+			    BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	/* single-touch touchscreens */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			    BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	/* keys and keyboards */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler cpufreq_interactive_input_handler = {
+	.event		= cpufreq_interactive_input_event,
+	.connect	= cpufreq_interactive_input_connect,
+	.disconnect	= cpufreq_interactive_input_disconnect,
+	.name		= "cpufreq_interactive",
+	.id_table	= cpufreq_interactive_ids,
+};
+
 static int __init cpufreq_interactive_init(void)
 {
 	unsigned int i;
@@ -645,6 +991,8 @@ static int __init cpufreq_interactive_init(void)
 	go_hispeed_load = DEFAULT_GO_HISPEED_LOAD;
 	min_sample_time = DEFAULT_MIN_SAMPLE_TIME;
 	timer_rate = DEFAULT_TIMER_RATE;
+	boostpulse_duration = DEFAULT_BOOSTPULSE_DURATION;
+	input_boost = 1;
 
 	/* Initalize per-cpu timers */
 	for_each_possible_cpu(i) {
@@ -677,6 +1025,12 @@ static int __init cpufreq_interactive_init(void)
 	mutex_init(&set_speed_lock);
 
 	idle_notifier_register(&cpufreq_interactive_idle_nb);
+#ifdef CONFIG_SCHED_CPU_UTIL
+	sched_util_register_notifier(&cpufreq_interactive_util_nb);
+#endif
+
+	if (input_register_handler(&cpufreq_interactive_input_handler))
+		pr_warn("%s: failed to register input handler\n", __func__);
 
 	return cpufreq_register_governor(&cpufreq_gov_interactive);
 
@@ -694,6 +1048,10 @@ module_init(cpufreq_interactive_init);
 static void __exit cpufreq_interactive_exit(void)
 {
 	cpufreq_unregister_governor(&cpufreq_gov_interactive);
+	input_unregister_handler(&cpufreq_interactive_input_handler);
+#ifdef CONFIG_SCHED_CPU_UTIL
+	sched_util_unregister_notifier(&cpufreq_interactive_util_nb);
+#endif
 	kthread_stop(up_task);
 	put_task_struct(up_task);
 	destroy_workqueue(down_wq);
@@ -87,6 +87,10 @@ struct cpu_dbs_info_s {
 	unsigned int rate_mult;
 	int cpu;
 	unsigned int sample_type:1;
+#ifdef CONFIG_SCHED_CPU_UTIL
+	/* the utilization notifier may kick work, under dbs_kick_lock */
+	int kick_enabled;
+#endif
 	/*
 	 * percpu mutex that serializes governor limit change with
 	 * do_dbs_timer invocation. We do not want do_dbs_timer to run
@@ -486,6 +490,17 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 
 		load = 100 * (wall_time - idle_time) / wall_time;
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+		/*
+		 * The decayed busy time kept by the scheduler counts nice
+		 * tasks as busy and iowait as idle, so it is used only when
+		 * neither ignore_nice_load nor io_is_busy asks otherwise.
+		 * The deltas above are kept up to date either way.
+		 */
+		if (!dbs_tuners_ins.ignore_nice && !dbs_tuners_ins.io_is_busy)
+			load = sched_cpu_util(j) * 100 / SCHED_UTIL_SCALE;
+#endif
+
 		freq_avg = __cpufreq_driver_getavg(policy, j);
 		if (freq_avg <= 0)
 			freq_avg = policy->cur;
@@ -582,6 +597,25 @@ static void do_dbs_timer(struct work_struct *work)
 	mutex_unlock(&dbs_info->timer_mutex);
 }
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+/* Orders dbs_util_notifier() kicks against dbs_timer_exit() */
+static DEFINE_SPINLOCK(dbs_kick_lock);
+
+static void dbs_kick_enable(struct cpu_dbs_info_s *dbs_info, int enable)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dbs_kick_lock, flags);
+	dbs_info->kick_enabled = enable;
+	spin_unlock_irqrestore(&dbs_kick_lock, flags);
+}
+#else
+static inline void dbs_kick_enable(struct cpu_dbs_info_s *dbs_info,
+				   int enable)
+{
+}
+#endif
+
 static inline void dbs_timer_init(struct cpu_dbs_info_s *dbs_info)
 {
 	/* We want all CPUs to do sampling nearly on same jiffy */
@@ -593,10 +627,13 @@ static inline void dbs_timer_init(struct cpu_dbs_info_s *dbs_info)
 	dbs_info->sample_type = DBS_NORMAL_SAMPLE;
 	INIT_DELAYED_WORK_DEFERRABLE(&dbs_info->work, do_dbs_timer);
 	schedule_delayed_work_on(dbs_info->cpu, &dbs_info->work, delay);
+	dbs_kick_enable(dbs_info, 1);
 }
 
 static inline void dbs_timer_exit(struct cpu_dbs_info_s *dbs_info)
 {
+	/* no kick can requeue the work once this returns */
+	dbs_kick_enable(dbs_info, 0);
 	cancel_delayed_work_sync(&dbs_info->work);
 }
 
@@ -715,6 +752,45 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 	return 0;
 }
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+/*
+ * A CPU crossed up_threshold between two samples, pull the next sample
+ * in so the frequency is raised within a tick. Runs from the tick.
+ */
+static int dbs_util_notifier(struct notifier_block *nb,
+			     unsigned long val, void *data)
+{
+	struct sched_util_change *change = data;
+	struct cpufreq_policy *policy;
+	struct cpu_dbs_info_s *dbs_info;
+	unsigned long flags;
+
+	if (!dbs_enable || change->util <= change->prev_util)
+		return NOTIFY_DONE;
+
+	if (change->util * 100 <
+	    dbs_tuners_ins.up_threshold * SCHED_UTIL_SCALE)
+		return NOTIFY_DONE;
+
+	policy = per_cpu(od_cpu_dbs_info, change->cpu).cur_policy;
+	if (!policy || policy->cur == policy->max)
+		return NOTIFY_DONE;
+
+	/* leave a sample that is already running alone */
+	dbs_info = &per_cpu(od_cpu_dbs_info, policy->cpu);
+	spin_lock_irqsave(&dbs_kick_lock, flags);
+	if (dbs_info->kick_enabled && __cancel_delayed_work(&dbs_info->work))
+		schedule_delayed_work_on(policy->cpu, &dbs_info->work, 0);
+	spin_unlock_irqrestore(&dbs_kick_lock, flags);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block dbs_util_nb = {
+	.notifier_call = dbs_util_notifier,
+};
+#endif
+
 static int __init cpufreq_gov_dbs_init(void)
 {
 	cputime64_t wall;
@@ -740,12 +816,18 @@ static int __init cpufreq_gov_dbs_init(void)
 			MIN_SAMPLING_RATE_RATIO * jiffies_to_usecs(10);
 	}
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+	sched_util_register_notifier(&dbs_util_nb);
+#endif
 	return cpufreq_register_governor(&cpufreq_gov_ondemand);
 }
 
 static void __exit cpufreq_gov_dbs_exit(void)
 {
 	cpufreq_unregister_governor(&cpufreq_gov_ondemand);
+#ifdef CONFIG_SCHED_CPU_UTIL
+	sched_util_unregister_notifier(&dbs_util_nb);
+#endif
 }
 
 
@@ -46,6 +46,8 @@
 #define SMSC95XX_INTERNAL_PHY_ID	(1)
 #define SMSC95XX_TX_OVERHEAD		(8)
 #define SMSC95XX_TX_OVERHEAD_CSUM	(12)
+#define SMSC95XX_TX_AGGR_SIZE		(8 * 1024)
+#define SMSC95XX_TX_AGGR_FRAMES		(16)
 
 struct smsc95xx_priv {
 	u32 mac_cr;
@@ -63,6 +65,14 @@ static int turbo_mode = true;
 module_param(turbo_mode, bool, 0644);
 MODULE_PARM_DESC(turbo_mode, "Enable multiple frames per Rx transaction");
 
+static unsigned int tx_aggr_size = SMSC95XX_TX_AGGR_SIZE;
+module_param(tx_aggr_size, uint, 0644);
+MODULE_PARM_DESC(tx_aggr_size, "Max bytes of Tx frames per transaction, 0 to disable");
+
+static unsigned int tx_aggr_timeout_us = 200;
+module_param(tx_aggr_timeout_us, uint, 0644);
+MODULE_PARM_DESC(tx_aggr_timeout_us, "Max time a Tx frame waits for aggregation");
+
 //----------------------------------------------------------------------
 //
 // ADD Hardkernel
@@ -660,6 +670,9 @@ static const struct ethtool_ops smsc95xx_ethtool_ops = {
 	.get_eeprom_len	= smsc95xx_ethtool_get_eeprom_len,
 	.get_eeprom	= smsc95xx_ethtool_get_eeprom,
 	.set_eeprom	= smsc95xx_ethtool_set_eeprom,
+	.get_sset_count	= usbnet_get_sset_count,
+	.get_strings	= usbnet_get_strings,
+	.get_ethtool_stats = usbnet_get_ethtool_stats,
 };
 
 static int smsc95xx_ioctl(struct net_device *netdev, struct ifreq *rq, int cmd)
@@ -1095,6 +1108,14 @@ static int smsc95xx_bind(struct usbnet *dev, struct usb_interface *intf)
 	dev->net->ethtool_ops = &smsc95xx_ethtool_ops;
 	dev->net->flags |= IFF_MULTICAST;
 	dev->net->hard_header_len += SMSC95XX_TX_OVERHEAD_CSUM;
+
+	/* each frame keeps its own command words, padded to a dword */
+	if (tx_aggr_size) {
+		dev->tx_aggr_max_size = tx_aggr_size;
+		dev->tx_aggr_max_frames = SMSC95XX_TX_AGGR_FRAMES;
+		dev->tx_aggr_align = 4;
+		dev->tx_aggr_timeout_us = tx_aggr_timeout_us;
+	}
 	return 0;
 }
 
@@ -1133,6 +1154,13 @@ static int smsc95xx_rx_fixup(struct usbnet *dev, struct sk_buff *skb)
 		size = (u16)((header & RX_STS_FL_) >> 16);
 		align_count = (4 - ((size + NET_IP_ALIGN) % 4)) % 4;
 
+		/* every frame is copied out now, never read past the urb */
+		if (unlikely(size > skb->len)) {
+			netif_dbg(dev, rx_err, dev->net,
+				  "truncated frame header=0x%08x\n", header);
+			return 0;
+		}
+
 		if (unlikely(header & RX_STS_ES_)) {
 			netif_dbg(dev, rx_err, dev->net,
 				  "Error header=0x%08x\n", header);
@@ -1157,34 +1185,28 @@ static int smsc95xx_rx_fixup(struct usbnet *dev, struct sk_buff *skb)
 				return 0;
 			}
 
-			/* last frame in this batch */
-			if (skb->len == size) {
-				if (dev->net->features & NETIF_F_RXCSUM)
-					smsc95xx_rx_csum_offload(skb);
-				skb_trim(skb, skb->len - 4); /* remove fcs */
-				skb->truesize = size + sizeof(struct sk_buff);
-
-				return 1;
-			}
-
-			ax_skb = skb_clone(skb, GFP_ATOMIC);
+			/* Copy out rather than clone: a clone pins the whole
+			 * turbo_mode urb buffer until the last frame is freed,
+			 * and its faked truesize keeps GRO from merging it.
+			 * With FLAG_RX_COPY usbnet then recycles the buffer.
+			 */
+			ax_skb = netdev_alloc_skb_ip_align(dev->net, size);
 			if (unlikely(!ax_skb)) {
 				netdev_warn(dev->net, "Error allocating skb\n");
-				return 0;
+				dev->net->stats.rx_dropped++;
+				goto next_frame;
 			}
 
-			ax_skb->len = size;
-			ax_skb->data = packet;
-			skb_set_tail_pointer(ax_skb, size);
+			memcpy(skb_put(ax_skb, size), packet, size);
 
 			if (dev->net->features & NETIF_F_RXCSUM)
 				smsc95xx_rx_csum_offload(ax_skb);
 			skb_trim(ax_skb, ax_skb->len - 4); /* remove fcs */
-			ax_skb->truesize = size + sizeof(struct sk_buff);
 
 			usbnet_skb_return(dev, ax_skb);
 		}
 
+next_frame:
 		skb_pull(skb, size);
 
 		/* padding bytes before the next frame starts */
@@ -1269,7 +1291,8 @@ static const struct driver_info smsc95xx_info = {
 	.rx_fixup	= smsc95xx_rx_fixup,
 	.tx_fixup	= smsc95xx_tx_fixup,
 	.status		= smsc95xx_status,
-	.flags		= FLAG_ETHER | FLAG_SEND_ZLP | FLAG_LINK_INTR,
+	.flags		= FLAG_ETHER | FLAG_SEND_ZLP | FLAG_LINK_INTR |
+			  FLAG_RX_COPY,
 };
 
 static const struct usb_device_id products[] = {
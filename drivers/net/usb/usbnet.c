@@ -49,6 +49,9 @@
 
 #define DRIVER_VERSION		"22-Aug-2005"
 
+/* rx urbs reaped per NAPI poll, each may carry several frames */
+#define USBNET_NAPI_WEIGHT	64
+
 
 /*-------------------------------------------------------------------------*/
 
@@ -218,6 +221,16 @@ static int init_status (struct usbnet *dev, struct usb_interface *intf)
 	return 0;
 }
 
+/* True when called from usbnet_poll(), directly or through rx_fixup().
+ * Softirqs don't nest on a cpu, so only the poll itself can be serving
+ * one on the cpu it runs on; a hardirq interrupting it is excluded.
+ */
+static inline int usbnet_in_poll(struct usbnet *dev)
+{
+	return in_serving_softirq() && !in_irq() &&
+		dev->rx_poll_cpu == smp_processor_id();
+}
+
 /* Passes this packet up the stack, updating its accounting.
  * Some link protocols batch packets, so their rx_fixup paths
  * can return clones as well as just modify the original skb.
@@ -238,6 +251,15 @@ void usbnet_skb_return (struct usbnet *dev, struct sk_buff *skb)
 	netif_dbg(dev, rx_status, dev->net, "< rx, len %zu, type 0x%x\n",
 		  skb->len + sizeof (struct ethhdr), skb->protocol);
 	memset (skb->cb, 0, sizeof (struct skb_data));
+
+	/* only usbnet_poll() owns the GRO list of dev->napi, it passes
+	 * the frames on within its budget
+	 */
+	if (usbnet_in_poll(dev)) {
+		__skb_queue_tail(&dev->rx_napi, skb);
+		return;
+	}
+
 	status = netif_rx (skb);
 	if (status != NET_RX_SUCCESS)
 		netif_dbg(dev, rx_err, dev->net,
@@ -269,8 +291,10 @@ int usbnet_change_mtu (struct net_device *net, int new_mtu)
 	dev->hard_mtu = net->mtu + net->hard_header_len;
 	if (dev->rx_urb_size == old_hard_mtu) {
 		dev->rx_urb_size = dev->hard_mtu;
-		if (dev->rx_urb_size > old_rx_urb_size)
+		if (dev->rx_urb_size > old_rx_urb_size) {
+			skb_queue_purge(&dev->rx_pool);
 			usbnet_unlink_rx_urbs(dev);
+		}
 	}
 
 	return 0;
@@ -289,6 +313,27 @@ static void __usbnet_queue_skb(struct sk_buff_head *list,
 
 /*-------------------------------------------------------------------------*/
 
+/* While the interface is up, completed urbs are reaped from NAPI poll
+ * so received frames go through GRO with a budget; the tasklet is used
+ * only while bringing the link down and for drivers never opened.
+ */
+static void usbnet_bh_schedule(struct usbnet *dev)
+{
+	if (!test_bit(EVENT_RX_NAPI, &dev->flags)) {
+		tasklet_schedule(&dev->bh);
+		return;
+	}
+
+	/* from process context, have the raised softirq run right away */
+	if (in_interrupt() || irqs_disabled()) {
+		napi_schedule(&dev->napi);
+	} else {
+		local_bh_disable();
+		napi_schedule(&dev->napi);
+		local_bh_enable();
+	}
+}
+
 /* some LK 2.4 HCDs oopsed if we freed or resubmitted urbs from
  * completion callbacks.  2.5 should have fixed those bugs...
  */
@@ -308,7 +353,7 @@ static enum skb_state defer_bh(struct usbnet *dev, struct sk_buff *skb,
 	spin_lock(&dev->done.lock);
 	__skb_queue_tail(&dev->done, skb);
 	if (dev->done.qlen == 1)
-		tasklet_schedule(&dev->bh);
+		usbnet_bh_schedule(dev);
 	spin_unlock_irqrestore(&dev->done.lock, flags);
 	return old_state;
 }
@@ -330,6 +375,67 @@ EXPORT_SYMBOL_GPL(usbnet_defer_kevent);
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * Receive buffers are rx_urb_size, several pages with turbo framing, so
+ * allocating them with GFP_ATOMIC from urb completions fails often and
+ * loads the allocator.  Buffers the minidriver did not pass up the stack
+ * go back to a pool, which keventd tops up with GFP_KERNEL in batches.
+ */
+static void usbnet_rx_pool_fill (struct usbnet *dev, gfp_t flags)
+{
+	size_t			size = dev->rx_urb_size + NET_IP_ALIGN;
+	struct sk_buff		*skb;
+
+	while (skb_queue_len(&dev->rx_pool) < RX_QLEN(dev)) {
+		skb = __netdev_alloc_skb(dev->net, size, flags);
+		if (!skb) {
+			dev->xstats.rx_alloc_errors++;
+			break;
+		}
+		skb_queue_tail(&dev->rx_pool, skb);
+	}
+}
+
+static struct sk_buff *usbnet_rx_pool_get (struct usbnet *dev, gfp_t flags)
+{
+	size_t			size = dev->rx_urb_size + NET_IP_ALIGN;
+	struct sk_buff		*skb;
+
+	skb = skb_dequeue(&dev->rx_pool);
+	if (skb && skb_tailroom(skb) < size) {
+		/* left over from before an mtu change */
+		dev_kfree_skb_any(skb);
+		skb = NULL;
+	}
+
+	if (skb_queue_len(&dev->rx_pool) < RX_QLEN(dev) / 2 &&
+	    !test_bit(EVENT_RX_POOL, &dev->flags))
+		usbnet_defer_kevent(dev, EVENT_RX_POOL);
+
+	if (skb) {
+		dev->xstats.rx_pool_hits++;
+		return skb;
+	}
+
+	dev->xstats.rx_pool_misses++;
+	skb = __netdev_alloc_skb(dev->net, size, flags);
+	if (!skb)
+		dev->xstats.rx_alloc_errors++;
+	return skb;
+}
+
+/* called from the bh with irqs enabled, as skb_recycle_check() wants */
+static void usbnet_rx_recycle (struct usbnet *dev, struct sk_buff *skb)
+{
+	if (netif_running(dev->net) &&
+	    skb_queue_len(&dev->rx_pool) < RX_QLEN(dev) &&
+	    skb_recycle_check(skb, dev->rx_urb_size + NET_IP_ALIGN)) {
+		skb_queue_tail(&dev->rx_pool, skb);
+		dev->xstats.rx_recycled++;
+	} else
+		dev_kfree_skb (skb);
+}
+
 static void rx_complete (struct urb *urb);
 
 static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
@@ -340,7 +446,7 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 	unsigned long		lockflags;
 	size_t			size = dev->rx_urb_size;
 
-	if ((skb = alloc_skb (size + NET_IP_ALIGN, flags)) == NULL) {
+	if ((skb = usbnet_rx_pool_get (dev, flags)) == NULL) {
 		netif_dbg(dev, rx_err, dev->net, "no rx skb\n");
 		usbnet_defer_kevent (dev, EVENT_RX_MEMORY);
 		usb_free_urb (urb);
@@ -379,7 +485,7 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 		default:
 			netif_dbg(dev, rx_err, dev->net,
 				  "rx submit, %d\n", retval);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 			break;
 		case 0:
 			__usbnet_queue_skb(&dev->rxq, skb, rx_start);
@@ -410,6 +516,10 @@ static inline void rx_process (struct usbnet *dev, struct sk_buff *skb)
 	}
 	// else network stack removes extra byte if we forced a short packet
 
+	/* every frame was copied out, the buffer goes back to the pool */
+	if (dev->driver_info->flags & FLAG_RX_COPY)
+		goto done;
+
 	if (skb->len) {
 		/* all data was already cloned from skb inside the driver */
 		if (dev->driver_info->flags & FLAG_MULTI_PACKET)
@@ -570,7 +680,7 @@ void usbnet_resume_rx(struct usbnet *dev)
 		num++;
 	}
 
-	tasklet_schedule(&dev->bh);
+	usbnet_bh_schedule(dev);
 
 	netif_dbg(dev, rx_status, dev->net,
 		  "paused rx queue disabled, %d skbs requeued\n", num);
@@ -639,7 +749,7 @@ void usbnet_unlink_rx_urbs(struct usbnet *dev)
 {
 	if (netif_running(dev->net)) {
 		(void) unlink_urbs (dev, &dev->rxq);
-		tasklet_schedule(&dev->bh);
+		usbnet_bh_schedule(dev);
 	}
 }
 EXPORT_SYMBOL_GPL(usbnet_unlink_rx_urbs);
@@ -674,6 +784,8 @@ static void usbnet_terminate_urbs(struct usbnet *dev)
 	remove_wait_queue(&unlink_wakeup, &wait);
 }
 
+static void usbnet_tx_aggr_stop (struct usbnet *dev);
+
 int usbnet_stop (struct net_device *net)
 {
 	struct usbnet		*dev = netdev_priv(net);
@@ -683,6 +795,15 @@ int usbnet_stop (struct net_device *net)
 	clear_bit(EVENT_DEV_OPEN, &dev->flags);
 	netif_stop_queue (net);
 
+	/* back to the tasklet, which also wakes usbnet_terminate_urbs();
+	 * anything left on the done queue by the last poll is reaped there.
+	 */
+	clear_bit(EVENT_RX_NAPI, &dev->flags);
+	napi_disable(&dev->napi);
+	__skb_queue_purge(&dev->rx_napi);
+	tasklet_schedule(&dev->bh);
+	usbnet_tx_aggr_stop(dev);
+
 	netif_info(dev, ifdown, dev->net,
 		   "stop stats: rx/tx %lu/%lu, errs %lu/%lu\n",
 		   net->stats.rx_packets, net->stats.tx_packets,
@@ -706,6 +827,7 @@ int usbnet_stop (struct net_device *net)
 	usb_kill_urb(dev->interrupt);
 
 	usbnet_purge_paused_rxq(dev);
+	skb_queue_purge(&dev->rx_pool);
 
 	/* deferred work (task, timer, softirq) must also stop.
 	 * can't flush_scheduled_work() until we drop rtnl (later),
@@ -772,7 +894,11 @@ int usbnet_open (struct net_device *net)
 		}
 	}
 
+	usbnet_rx_pool_fill(dev, GFP_KERNEL);
+
 	set_bit(EVENT_DEV_OPEN, &dev->flags);
+	napi_enable(&dev->napi);
+	set_bit(EVENT_RX_NAPI, &dev->flags);
 	netif_start_queue (net);
 	netif_info(dev, ifup, dev->net,
 		   "open: enable queueing (rx %d, tx %d) mtu %d %s framing\n",
@@ -786,11 +912,15 @@ int usbnet_open (struct net_device *net)
 		   "simple");
 
 	// delay posting reads until we're fully open
-	tasklet_schedule (&dev->bh);
+	usbnet_bh_schedule(dev);
 	if (info->manage_power) {
 		retval = info->manage_power(dev, 1);
-		if (retval < 0)
+		if (retval < 0) {
+			clear_bit(EVENT_RX_NAPI, &dev->flags);
+			napi_disable(&dev->napi);
+			__skb_queue_purge(&dev->rx_napi);
 			goto done;
+		}
 		usb_autopm_put_interface(dev->intf);
 	}
 	return retval;
@@ -895,6 +1025,59 @@ void usbnet_set_msglevel (struct net_device *net, u32 level)
 EXPORT_SYMBOL_GPL(usbnet_set_msglevel);
 
 /* drivers may override default ethtool_ops in their bind() routine */
+#define USBNET_STAT(m)	{ #m, offsetof(struct usbnet_stats, m) }
+
+static const struct {
+	char		name[ETH_GSTRING_LEN];
+	size_t		offset;
+} usbnet_gstrings_stats[] = {
+	USBNET_STAT(rx_pool_hits),
+	USBNET_STAT(rx_pool_misses),
+	USBNET_STAT(rx_recycled),
+	USBNET_STAT(rx_alloc_errors),
+	USBNET_STAT(tx_aggr_urbs),
+	USBNET_STAT(tx_aggr_frames),
+	USBNET_STAT(tx_aggr_max_depth),
+	USBNET_STAT(tx_aggr_timeouts),
+	USBNET_STAT(tx_aggr_alloc_errors),
+};
+
+int usbnet_get_sset_count(struct net_device *net, int sset)
+{
+	switch (sset) {
+	case ETH_SS_STATS:
+		return ARRAY_SIZE(usbnet_gstrings_stats);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+EXPORT_SYMBOL_GPL(usbnet_get_sset_count);
+
+void usbnet_get_strings(struct net_device *net, u32 sset, u8 *data)
+{
+	int i;
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(usbnet_gstrings_stats); i++)
+		memcpy(data + i * ETH_GSTRING_LEN,
+		       usbnet_gstrings_stats[i].name, ETH_GSTRING_LEN);
+}
+EXPORT_SYMBOL_GPL(usbnet_get_strings);
+
+void usbnet_get_ethtool_stats(struct net_device *net,
+			      struct ethtool_stats *stats, u64 *data)
+{
+	struct usbnet *dev = netdev_priv(net);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(usbnet_gstrings_stats); i++)
+		data[i] = *(unsigned long *)((char *)&dev->xstats +
+					     usbnet_gstrings_stats[i].offset);
+}
+EXPORT_SYMBOL_GPL(usbnet_get_ethtool_stats);
+
 static const struct ethtool_ops usbnet_ethtool_ops = {
 	.get_settings		= usbnet_get_settings,
 	.set_settings		= usbnet_set_settings,
@@ -903,6 +1086,9 @@ static const struct ethtool_ops usbnet_ethtool_ops = {
 	.get_drvinfo		= usbnet_get_drvinfo,
 	.get_msglevel		= usbnet_get_msglevel,
 	.set_msglevel		= usbnet_set_msglevel,
+	.get_sset_count		= usbnet_get_sset_count,
+	.get_strings		= usbnet_get_strings,
+	.get_ethtool_stats	= usbnet_get_ethtool_stats,
 };
 
 /*-------------------------------------------------------------------------*/
@@ -956,7 +1142,7 @@ fail_halt:
 					   status);
 		} else {
 			clear_bit (EVENT_RX_HALT, &dev->flags);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 		}
 	}
 
@@ -981,7 +1167,7 @@ fail_halt:
 			usb_autopm_put_interface(dev->intf);
 fail_lowmem:
 			if (resched)
-				tasklet_schedule (&dev->bh);
+				usbnet_bh_schedule(dev);
 		}
 	}
 
@@ -1006,6 +1192,12 @@ skip_reset:
 		}
 	}
 
+	if (test_bit (EVENT_RX_POOL, &dev->flags)) {
+		clear_bit (EVENT_RX_POOL, &dev->flags);
+		if (netif_running (dev->net))
+			usbnet_rx_pool_fill (dev, GFP_KERNEL);
+	}
+
 	if (dev->flags)
 		netdev_dbg(dev->net, "kevent done, flags = 0x%lx\n", dev->flags);
 }
@@ -1020,7 +1212,7 @@ static void tx_complete (struct urb *urb)
 
 	if (urb->status == 0) {
 		if (!(dev->driver_info->flags & FLAG_MULTI_PACKET))
-			dev->net->stats.tx_packets++;
+			dev->net->stats.tx_packets += entry->packets;
 		dev->net->stats.tx_bytes += entry->length;
 	} else {
 		dev->net->stats.tx_errors++;
@@ -1067,7 +1259,7 @@ void usbnet_tx_timeout (struct net_device *net)
 	struct usbnet		*dev = netdev_priv(net);
 
 	unlink_urbs (dev, &dev->txq);
-	tasklet_schedule (&dev->bh);
+	usbnet_bh_schedule(dev);
 
 	// FIXME: device recovery -- reset?
 }
@@ -1075,10 +1267,10 @@ EXPORT_SYMBOL_GPL(usbnet_tx_timeout);
 
 /*-------------------------------------------------------------------------*/
 
-netdev_tx_t usbnet_start_xmit (struct sk_buff *skb,
-				     struct net_device *net)
+static void usbnet_tx_submit (struct usbnet *dev, struct sk_buff *skb,
+			      unsigned packets)
 {
-	struct usbnet		*dev = netdev_priv(net);
+	struct net_device	*net = dev->net;
 	int			length;
 	struct urb		*urb = NULL;
 	struct skb_data		*entry;
@@ -1086,20 +1278,6 @@ netdev_tx_t usbnet_start_xmit (struct sk_buff *skb,
 	unsigned long		flags;
 	int retval;
 
-	// some devices want funky USB-level framing, for
-	// win32 driver (usually) and/or hardware quirks
-	if (info->tx_fixup) {
-		skb = info->tx_fixup (dev, skb, GFP_ATOMIC);
-		if (!skb) {
-			if (netif_msg_tx_err(dev)) {
-				netif_dbg(dev, tx_err, dev->net, "can't tx_fixup skb\n");
-				goto drop;
-			} else {
-				/* cdc_ncm collected packet; waits for more */
-				goto not_drop;
-			}
-		}
-	}
 	length = skb->len;
 
 	if (!(urb = usb_alloc_urb (0, GFP_ATOMIC))) {
@@ -1111,6 +1289,7 @@ netdev_tx_t usbnet_start_xmit (struct sk_buff *skb,
 	entry->urb = urb;
 	entry->dev = dev;
 	entry->length = length;
+	entry->packets = packets;
 
 	usb_fill_bulk_urb (urb, dev->udev, dev->out,
 			skb->data, skb->len, tx_complete, skb);
@@ -1177,10 +1356,8 @@ netdev_tx_t usbnet_start_xmit (struct sk_buff *skb,
 	if (retval) {
 		netif_dbg(dev, tx_err, dev->net, "drop, code %d\n", retval);
 drop:
-		dev->net->stats.tx_dropped++;
-not_drop:
-		if (skb)
-			dev_kfree_skb_any (skb);
+		dev->net->stats.tx_dropped += packets;
+		dev_kfree_skb_any (skb);
 		usb_free_urb (urb);
 	} else
 		netif_dbg(dev, tx_queued, dev->net,
@@ -1188,21 +1365,154 @@ not_drop:
 #ifdef CONFIG_PM
 deferred:
 #endif
+	return;
+}
+
+/*
+ * Frames are only held back while an urb is already in flight, so an
+ * idle link sends at once.  The pending urb goes out when it is full,
+ * when the pipe drains (see usbnet_bh_process) or after tx_aggr_timeout_us.
+ * Submitting under tx_aggr_lock keeps frames in order with the flushes.
+ */
+static void __usbnet_tx_aggr_submit (struct usbnet *dev)
+{
+	struct sk_buff		*skb = dev->tx_aggr_skb;
+	unsigned		frames = dev->tx_aggr_frames;
+
+	dev->tx_aggr_skb = NULL;
+	dev->xstats.tx_aggr_urbs++;
+	dev->xstats.tx_aggr_frames += frames;
+	if (frames > dev->xstats.tx_aggr_max_depth)
+		dev->xstats.tx_aggr_max_depth = frames;
+	usbnet_tx_submit(dev, skb, frames);
+}
+
+static void usbnet_tx_aggr_flush (struct usbnet *dev)
+{
+	unsigned long		flags;
+
+	spin_lock_irqsave(&dev->tx_aggr_lock, flags);
+	if (dev->tx_aggr_skb)
+		__usbnet_tx_aggr_submit(dev);
+	spin_unlock_irqrestore(&dev->tx_aggr_lock, flags);
+}
+
+static enum hrtimer_restart usbnet_tx_aggr_timeout (struct hrtimer *timer)
+{
+	struct usbnet		*dev = container_of(timer, struct usbnet,
+						    tx_aggr_timer);
+
+	if (dev->tx_aggr_skb) {
+		dev->xstats.tx_aggr_timeouts++;
+		usbnet_tx_aggr_flush(dev);
+	}
+	return HRTIMER_NORESTART;
+}
+
+static void usbnet_tx_aggr (struct usbnet *dev, struct sk_buff *skb)
+{
+	struct sk_buff		*agg;
+	unsigned long		flags;
+	unsigned		offset;
+
+	spin_lock_irqsave(&dev->tx_aggr_lock, flags);
+
+	agg = dev->tx_aggr_skb;
+	if (agg && (dev->tx_aggr_frames >= dev->tx_aggr_max_frames ||
+		    ALIGN(agg->len, dev->tx_aggr_align) + skb->len >
+		    dev->tx_aggr_max_size)) {
+		__usbnet_tx_aggr_submit(dev);
+		agg = NULL;
+	}
+
+	if (!agg) {
+		if (!dev->txq.qlen || skb->len > dev->tx_aggr_max_size)
+			goto send;
+
+		agg = alloc_skb(dev->tx_aggr_max_size, GFP_ATOMIC);
+		if (!agg) {
+			dev->xstats.tx_aggr_alloc_errors++;
+			goto send;
+		}
+		dev->tx_aggr_skb = agg;
+		dev->tx_aggr_frames = 0;
+		hrtimer_start(&dev->tx_aggr_timer,
+			      ns_to_ktime(dev->tx_aggr_timeout_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+
+	offset = ALIGN(agg->len, dev->tx_aggr_align);
+	memset(skb_put(agg, offset - agg->len), 0, offset - agg->len);
+	memcpy(skb_put(agg, skb->len), skb->data, skb->len);
+	dev->tx_aggr_frames++;
+	if (dev->tx_aggr_frames >= dev->tx_aggr_max_frames)
+		__usbnet_tx_aggr_submit(dev);
+
+	spin_unlock_irqrestore(&dev->tx_aggr_lock, flags);
+	dev_kfree_skb_any(skb);
+	return;
+
+send:
+	usbnet_tx_submit(dev, skb, 1);
+	spin_unlock_irqrestore(&dev->tx_aggr_lock, flags);
+}
+
+static void usbnet_tx_aggr_stop (struct usbnet *dev)
+{
+	if (!dev->tx_aggr_max_size)
+		return;
+
+	hrtimer_cancel(&dev->tx_aggr_timer);
+
+	spin_lock_irq(&dev->tx_aggr_lock);
+	if (dev->tx_aggr_skb) {
+		dev->net->stats.tx_dropped += dev->tx_aggr_frames;
+		dev_kfree_skb_any(dev->tx_aggr_skb);
+		dev->tx_aggr_skb = NULL;
+	}
+	spin_unlock_irq(&dev->tx_aggr_lock);
+}
+
+netdev_tx_t usbnet_start_xmit (struct sk_buff *skb,
+				     struct net_device *net)
+{
+	struct usbnet		*dev = netdev_priv(net);
+	struct driver_info	*info = dev->driver_info;
+
+	// some devices want funky USB-level framing, for
+	// win32 driver (usually) and/or hardware quirks
+	if (info->tx_fixup) {
+		skb = info->tx_fixup (dev, skb, GFP_ATOMIC);
+		if (!skb) {
+			if (netif_msg_tx_err(dev)) {
+				netif_dbg(dev, tx_err, dev->net, "can't tx_fixup skb\n");
+				dev->net->stats.tx_dropped++;
+			}
+			/* else cdc_ncm collected packet; waits for more */
+			return NETDEV_TX_OK;
+		}
+	}
+
+	if (dev->tx_aggr_max_size)
+		usbnet_tx_aggr(dev, skb);
+	else
+		usbnet_tx_submit(dev, skb, 1);
+
 	return NETDEV_TX_OK;
 }
 EXPORT_SYMBOL_GPL(usbnet_start_xmit);
 
 /*-------------------------------------------------------------------------*/
 
-// tasklet (work deferred from completions, in_irq) or timer
+// reap completed urbs, until "budget" frames wait for the poll to pass them on
 
-static void usbnet_bh (unsigned long param)
+static void usbnet_bh_process(struct usbnet *dev, int budget)
 {
-	struct usbnet		*dev = (struct usbnet *) param;
 	struct sk_buff		*skb;
 	struct skb_data		*entry;
 
-	while ((skb = skb_dequeue (&dev->done))) {
+	while (skb_queue_len(&dev->rx_napi) < budget &&
+	       (skb = skb_dequeue (&dev->done))) {
 		entry = (struct skb_data *) skb->cb;
 		switch (entry->state) {
 		case rx_done:
@@ -1210,15 +1520,26 @@ static void usbnet_bh (unsigned long param)
 			rx_process (dev, skb);
 			continue;
 		case tx_done:
-		case rx_cleanup:
 			usb_free_urb (entry->urb);
 			dev_kfree_skb (skb);
+			// keep the pipe busy with whatever was aggregated
+			if (dev->tx_aggr_skb && dev->txq.qlen < 2)
+				usbnet_tx_aggr_flush(dev);
+			continue;
+		case rx_cleanup:
+			usb_free_urb (entry->urb);
+			usbnet_rx_recycle (dev, skb);
 			continue;
 		default:
 			netdev_dbg(dev->net, "bogus skb state %d\n", entry->state);
 		}
 	}
+}
+
+// returns nonzero if the rx queue is still short and must be revisited
 
+static int usbnet_bh_refill(struct usbnet *dev)
+{
 	// waiting for all pending urbs to complete?
 	if (dev->wait) {
 		if ((dev->txq.qlen + dev->rxq.qlen + dev->done.qlen) == 0) {
@@ -1232,6 +1553,7 @@ static void usbnet_bh (unsigned long param)
 		   !test_bit (EVENT_RX_HALT, &dev->flags)) {
 		int	temp = dev->rxq.qlen;
 		int	qlen = RX_QLEN (dev);
+		int	short_urbs = 0;
 
 		if (temp < qlen) {
 			struct urb	*urb;
@@ -1243,21 +1565,74 @@ static void usbnet_bh (unsigned long param)
 				if (urb != NULL) {
 					if (rx_submit (dev, urb, GFP_ATOMIC) ==
 					    -ENOLINK)
-						return;
+						return 0;
 				}
 			}
 			if (temp != dev->rxq.qlen)
 				netif_dbg(dev, link, dev->net,
 					  "rxqlen %d --> %d\n",
 					  temp, dev->rxq.qlen);
-			if (dev->rxq.qlen < qlen)
-				tasklet_schedule (&dev->bh);
+			short_urbs = dev->rxq.qlen < qlen;
 		}
 		if (dev->txq.qlen < TX_QLEN (dev))
 			netif_wake_queue (dev->net);
+		return short_urbs;
+	}
+	return 0;
+}
+
+// tasklet (work deferred from completions, in_irq) or timer
+
+static void usbnet_bh (unsigned long param)
+{
+	struct usbnet		*dev = (struct usbnet *) param;
+
+	/* the delay timer also lands here; hand it over to the poller */
+	if (test_bit(EVENT_RX_NAPI, &dev->flags)) {
+		napi_schedule(&dev->napi);
+		return;
 	}
+
+	usbnet_bh_process(dev, INT_MAX);
+	if (usbnet_bh_refill(dev))
+		tasklet_schedule (&dev->bh);
 }
 
+// NAPI poll: frames are handed to GRO, at most "budget" frames per call.
+// An urb may carry several frames, those beyond the budget wait in
+// dev->rx_napi for the next call.
+
+static int usbnet_poll(struct napi_struct *napi, int budget)
+{
+	struct usbnet		*dev = container_of(napi, struct usbnet, napi);
+	struct sk_buff		*skb;
+	int			work = 0;
+
+	dev->rx_poll_cpu = smp_processor_id();
+	usbnet_bh_process(dev, budget);
+	dev->rx_poll_cpu = -1;
+
+	while (work < budget && (skb = __skb_dequeue(&dev->rx_napi))) {
+		if (napi_gro_receive(napi, skb) == GRO_DROP)
+			dev->net->stats.rx_dropped++;
+		work++;
+	}
+
+	if (work >= budget)
+		return budget;
+
+	// stay scheduled while short of rx urbs, like the tasklet did
+	if (usbnet_bh_refill(dev))
+		return budget;
+
+	napi_complete(napi);
+
+	// defer_bh() only schedules on an empty queue, don't miss a race
+	if (!skb_queue_empty(&dev->done))
+		napi_schedule(napi);
+
+	return work;
+}
 
 /*-------------------------------------------------------------------------
  *
@@ -1289,6 +1664,7 @@ void usbnet_disconnect (struct usb_interface *intf)
 	unregister_netdev (net);
 
 	cancel_work_sync(&dev->kevent);
+	skb_queue_purge(&dev->rx_pool);
 
 	if (dev->driver_info->unbind)
 		dev->driver_info->unbind (dev, intf);
@@ -1380,6 +1756,14 @@ usbnet_probe (struct usb_interface *udev, const struct usb_device_id *prod)
 	skb_queue_head_init(&dev->rxq_pause);
 	dev->bh.func = usbnet_bh;
 	dev->bh.data = (unsigned long) dev;
+	netif_napi_add(net, &dev->napi, usbnet_poll, USBNET_NAPI_WEIGHT);
+	dev->rx_poll_cpu = -1;
+	__skb_queue_head_init(&dev->rx_napi);
+	skb_queue_head_init(&dev->rx_pool);
+	spin_lock_init(&dev->tx_aggr_lock);
+	hrtimer_init(&dev->tx_aggr_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev->tx_aggr_timer.function = usbnet_tx_aggr_timeout;
+	dev->tx_aggr_align = 4;
 	INIT_WORK (&dev->kevent, kevent);
 	init_usb_anchor(&dev->deferred);
 	dev->delay.function = usbnet_bh;
@@ -1561,7 +1945,7 @@ int usbnet_resume (struct usb_interface *intf)
 		if (test_bit(EVENT_DEV_OPEN, &dev->flags)) {
 			if (!(dev->txq.qlen >= TX_QLEN(dev)))
 				netif_start_queue(dev->net);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 		}
 	}
 	return 0;
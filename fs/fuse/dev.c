@@ -228,27 +228,71 @@ static unsigned len_args(unsigned numargs, struct fuse_arg *args)
 	return nbytes;
 }
 
-static u64 fuse_get_unique(struct fuse_conn *fc)
+/*
+ * The low bits of the unique ID name the queue of the request, so the
+ * reply is looked up on that queue only.  Called with fc->lock.
+ */
+static u64 fuse_get_unique_queue(struct fuse_conn *fc, unsigned qid)
 {
+	BUILD_BUG_ON(FUSE_NR_QUEUES > (1 << FUSE_QUEUE_BITS));
+
+	/* zero is special, the counter is never zero */
 	fc->reqctr++;
-	/* zero is special */
 	if (fc->reqctr == 0)
 		fc->reqctr = 1;
 
-	return fc->reqctr;
+	return (fc->reqctr << FUSE_QUEUE_BITS) | qid;
+}
+
+static u64 fuse_get_unique(struct fuse_conn *fc)
+{
+	return fuse_get_unique_queue(fc, smp_processor_id() % FUSE_NR_QUEUES);
+}
+
+static struct fuse_queue *fuse_unique_queue(struct fuse_conn *fc, u64 unique)
+{
+	return &fc->queues[(unique & FUSE_QUEUE_MASK) % FUSE_NR_QUEUES];
+}
+
+/*
+ * Wake one reader that is actually asleep on the queue.  A bound reader
+ * stays on the wait queue until it gets fc->lock back, so one that was
+ * woken already, or is busy in between, must not swallow the wakeup.
+ * Readers set their state under fc->lock, which the caller holds.
+ */
+static int wake_bound_reader(struct fuse_queue *q)
+{
+	wait_queue_t *curr;
+	unsigned long flags;
+	int woken = 0;
+
+	spin_lock_irqsave(&q->waitq.lock, flags);
+	list_for_each_entry(curr, &q->waitq.task_list, task_list) {
+		if (curr->func(curr, TASK_NORMAL, 0, NULL)) {
+			woken = 1;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&q->waitq.lock, flags);
+
+	return woken;
 }
 
 static void queue_request(struct fuse_conn *fc, struct fuse_req *req)
 {
+	struct fuse_queue *q = fuse_unique_queue(fc, req->in.h.unique);
+
 	req->in.h.len = sizeof(struct fuse_in_header) +
 		len_args(req->in.numargs, (struct fuse_arg *) req->in.args);
-	list_add_tail(&req->list, &fc->pending);
+	list_add_tail(&req->list, &q->pending);
 	req->state = FUSE_REQ_PENDING;
 	if (!req->waiting) {
 		req->waiting = 1;
 		atomic_inc(&fc->num_waiting);
 	}
-	wake_up(&fc->waitq);
+	/* Prefer an idle reader bound to this queue, any other can steal it */
+	if (!wake_bound_reader(q))
+		wake_up(&fc->waitq);
 	kill_fasync(&fc->fasync, SIGIO, POLL_IN);
 }
 
@@ -915,20 +959,71 @@ static int forget_pending(struct fuse_conn *fc)
 	return fc->forget_list_head.next != NULL;
 }
 
+static int queues_pending(struct fuse_conn *fc)
+{
+	int i;
+
+	for (i = 0; i < FUSE_NR_QUEUES; i++)
+		if (!list_empty(&fc->queues[i].pending))
+			return 1;
+	return 0;
+}
+
 static int request_pending(struct fuse_conn *fc)
 {
-	return !list_empty(&fc->pending) || !list_empty(&fc->interrupts) ||
+	return queues_pending(fc) || !list_empty(&fc->interrupts) ||
 		forget_pending(fc);
 }
 
-/* Wait until a request is available on the pending list */
-static void request_wait(struct fuse_conn *fc)
+/*
+ * A reader pinned to a single cpu is bound to the queue of that cpu,
+ * others return -1
+ */
+static int reader_queue(void)
+{
+	const struct cpumask *mask = tsk_cpus_allowed(current);
+
+	if (cpumask_weight(mask) != 1)
+		return -1;
+
+	return cpumask_first(mask) % FUSE_NR_QUEUES;
+}
+
+/*
+ * Pick the queue to take the next request from: the reader's own, else
+ * the others in turn so that none of them starves
+ */
+static struct fuse_queue *pending_queue(struct fuse_conn *fc, int qid)
+{
+	unsigned i, n;
+
+	if (qid >= 0 && !list_empty(&fc->queues[qid].pending))
+		return &fc->queues[qid];
+
+	for (i = 0; i < FUSE_NR_QUEUES; i++) {
+		n = (fc->queue_rr + i) % FUSE_NR_QUEUES;
+		if (!list_empty(&fc->queues[n].pending)) {
+			fc->queue_rr = (n + 1) % FUSE_NR_QUEUES;
+			return &fc->queues[n];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Wait until a request is available on a pending list.  Bound readers
+ * wait on their queue too, to be woken for its requests first.
+ */
+static void request_wait(struct fuse_conn *fc, int qid)
 __releases(fc->lock)
 __acquires(fc->lock)
 {
 	DECLARE_WAITQUEUE(wait, current);
+	DECLARE_WAITQUEUE(qwait, current);
 
 	add_wait_queue_exclusive(&fc->waitq, &wait);
+	if (qid >= 0)
+		add_wait_queue_exclusive(&fc->queues[qid].waitq, &qwait);
 	while (fc->connected && !request_pending(fc)) {
 		set_current_state(TASK_INTERRUPTIBLE);
 		if (signal_pending(current))
@@ -939,6 +1034,8 @@ __acquires(fc->lock)
 		spin_lock(&fc->lock);
 	}
 	set_current_state(TASK_RUNNING);
+	if (qid >= 0)
+		remove_wait_queue(&fc->queues[qid].waitq, &qwait);
 	remove_wait_queue(&fc->waitq, &wait);
 }
 
@@ -960,7 +1057,8 @@ __releases(fc->lock)
 	int err;
 
 	list_del_init(&req->intr_entry);
-	req->intr_unique = fuse_get_unique(fc);
+	req->intr_unique = fuse_get_unique_queue(fc,
+				req->in.h.unique & FUSE_QUEUE_MASK);
 	memset(&ih, 0, sizeof(ih));
 	memset(&arg, 0, sizeof(arg));
 	ih.len = reqsize;
@@ -1108,8 +1206,10 @@ static ssize_t fuse_dev_do_read(struct fuse_conn *fc, struct file *file,
 {
 	int err;
 	struct fuse_req *req;
+	struct fuse_queue *q;
 	struct fuse_in *in;
 	unsigned reqsize;
+	int qid = reader_queue();
 
  restart:
 	spin_lock(&fc->lock);
@@ -1118,7 +1218,7 @@ static ssize_t fuse_dev_do_read(struct fuse_conn *fc, struct file *file,
 	    !request_pending(fc))
 		goto err_unlock;
 
-	request_wait(fc);
+	request_wait(fc, qid);
 	err = -ENODEV;
 	if (!fc->connected)
 		goto err_unlock;
@@ -1133,14 +1233,15 @@ static ssize_t fuse_dev_do_read(struct fuse_conn *fc, struct file *file,
 	}
 
 	if (forget_pending(fc)) {
-		if (list_empty(&fc->pending) || fc->forget_batch-- > 0)
+		if (!queues_pending(fc) || fc->forget_batch-- > 0)
 			return fuse_read_forget(fc, cs, nbytes);
 
 		if (fc->forget_batch <= -8)
 			fc->forget_batch = 16;
 	}
 
-	req = list_entry(fc->pending.next, struct fuse_req, list);
+	q = pending_queue(fc, qid);
+	req = list_entry(q->pending.next, struct fuse_req, list);
 	req->state = FUSE_REQ_READING;
 	list_move(&req->list, &fc->io);
 
@@ -1177,7 +1278,7 @@ static ssize_t fuse_dev_do_read(struct fuse_conn *fc, struct file *file,
 		request_end(fc, req);
 	else {
 		req->state = FUSE_REQ_SENT;
-		list_move_tail(&req->list, &fc->processing);
+		list_move_tail(&req->list, &q->processing);
 		if (req->interrupted)
 			queue_interrupt(fc, req);
 		spin_unlock(&fc->lock);
@@ -1608,12 +1709,13 @@ static int fuse_notify(struct fuse_conn *fc, enum fuse_notify_code code,
 	}
 }
 
-/* Look up request on processing list by unique ID */
+/* Look up request on processing list of its queue by unique ID */
 static struct fuse_req *request_find(struct fuse_conn *fc, u64 unique)
 {
+	struct fuse_queue *q = fuse_unique_queue(fc, unique);
 	struct list_head *entry;
 
-	list_for_each(entry, &fc->processing) {
+	list_for_each(entry, &q->processing) {
 		struct fuse_req *req;
 		req = list_entry(entry, struct fuse_req, list);
 		if (req->in.h.unique == unique || req->intr_unique == unique)
@@ -1840,10 +1942,14 @@ static unsigned fuse_dev_poll(struct file *file, poll_table *wait)
 {
 	unsigned mask = POLLOUT | POLLWRNORM;
 	struct fuse_conn *fc = fuse_get_conn(file);
+	int i;
+
 	if (!fc)
 		return POLLERR;
 
 	poll_wait(file, &fc->waitq, wait);
+	for (i = 0; i < FUSE_NR_QUEUES; i++)
+		poll_wait(file, &fc->queues[i].waitq, wait);
 
 	spin_lock(&fc->lock);
 	if (!fc->connected)
@@ -1914,10 +2020,14 @@ static void end_queued_requests(struct fuse_conn *fc)
 __releases(fc->lock)
 __acquires(fc->lock)
 {
+	int i;
+
 	fc->max_background = UINT_MAX;
 	flush_bg_queue(fc);
-	end_requests(fc, &fc->pending);
-	end_requests(fc, &fc->processing);
+	for (i = 0; i < FUSE_NR_QUEUES; i++) {
+		end_requests(fc, &fc->queues[i].pending);
+		end_requests(fc, &fc->queues[i].processing);
+	}
 	while (forget_pending(fc))
 		kfree(dequeue_forget(fc, 1, NULL));
 }
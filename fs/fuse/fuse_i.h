@@ -29,6 +29,13 @@
 /** Bias for fi->writectr, meaning new writepages must not be sent */
 #define FUSE_NOWRITE INT_MIN
 
+/** Number of request queues, requests are queued by submitting cpu */
+#define FUSE_NR_QUEUES (NR_CPUS < 8 ? NR_CPUS : 8)
+
+/** Low bits of the unique ID naming the queue of a request */
+#define FUSE_QUEUE_BITS 3
+#define FUSE_QUEUE_MASK ((1 << FUSE_QUEUE_BITS) - 1)
+
 /** It could be as large as PATH_MAX, but would that have any uses? */
 #define FUSE_NAME_MAX 1024
 
@@ -319,6 +326,25 @@ struct fuse_req {
  * destroyed, when the client device is closed and the filesystem is
  * unmounted.
  */
+/**
+ * A request queue
+ *
+ * Requests are queued on the queue of the cpu submitting them.  A
+ * daemon thread pinned to a single cpu reads the queue of that cpu
+ * first, and is woken for requests on it in preference to other
+ * readers.  Protected by fc->lock.
+ */
+struct fuse_queue {
+	/** Readers bound to this queue are waiting on this */
+	wait_queue_head_t waitq;
+
+	/** The list of pending requests */
+	struct list_head pending;
+
+	/** The list of requests being processed */
+	struct list_head processing;
+} ____cacheline_aligned_in_smp;
+
 struct fuse_conn {
 	/** Lock protecting accessess to  members of this structure */
 	spinlock_t lock;
@@ -347,11 +373,11 @@ struct fuse_conn {
 	/** Readers of the connection are waiting on this */
 	wait_queue_head_t waitq;
 
-	/** The list of pending requests */
-	struct list_head pending;
+	/** Per-cpu request queues */
+	struct fuse_queue queues[FUSE_NR_QUEUES];
 
-	/** The list of requests being processed */
-	struct list_head processing;
+	/** Next queue unbound readers take requests from */
+	unsigned queue_rr;
 
 	/** The list of requests under I/O */
 	struct list_head io;
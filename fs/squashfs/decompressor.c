@@ -22,7 +22,6 @@
  */
 
 #include <linux/types.h>
-#include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/buffer_head.h>
 
@@ -77,10 +76,10 @@ const struct squashfs_decompressor *squashfs_lookup_decompressor(int id)
 }
 
 
-void *squashfs_decompressor_init(struct super_block *sb, unsigned short flags)
+int squashfs_decompressor_setup(struct super_block *sb, unsigned short flags)
 {
 	struct squashfs_sb_info *msblk = sb->s_fs_info;
-	void *strm, *buffer = NULL;
+	void *buffer = NULL;
 	int length = 0;
 
 	/*
@@ -89,22 +88,21 @@ void *squashfs_decompressor_init(struct super_block *sb, unsigned short flags)
 	if (SQUASHFS_COMP_OPTS(flags)) {
 		buffer = kmalloc(PAGE_CACHE_SIZE, GFP_KERNEL);
 		if (buffer == NULL)
-			return ERR_PTR(-ENOMEM);
+			return -ENOMEM;
 
 		length = squashfs_read_data(sb, &buffer,
 			sizeof(struct squashfs_super_block), 0, NULL,
 			PAGE_CACHE_SIZE, 1);
 
 		if (length < 0) {
-			strm = ERR_PTR(length);
-			goto finished;
+			kfree(buffer);
+			return length;
 		}
 	}
 
-	strm = msblk->decompressor->init(msblk, buffer, length);
-
-finished:
-	kfree(buffer);
-
-	return strm;
+	/*
+	 * The options are kept with the streams, the multi stream modes
+	 * need them again to create further streams after mount
+	 */
+	return squashfs_decompressor_create(msblk, buffer, length);
 }
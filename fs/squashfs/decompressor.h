@@ -26,27 +26,34 @@
 struct squashfs_decompressor {
 	void	*(*init)(struct squashfs_sb_info *, void *, int);
 	void	(*free)(void *);
-	int	(*decompress)(struct squashfs_sb_info *, void **,
+	int	(*decompress)(struct squashfs_sb_info *, void *, void **,
 		struct buffer_head **, int, int, int, int, int);
 	int	id;
 	char	*name;
 	int	supported;
 };
 
-static inline void squashfs_decompressor_free(struct squashfs_sb_info *msblk,
-	void *s)
-{
-	if (msblk->decompressor)
-		msblk->decompressor->free(s);
-}
+/*
+ * How decompressor streams are shared by the readers of a filesystem,
+ * selected with the threads= mount option
+ */
+enum {
+	SQUASHFS_DECOMP_SINGLE,		/* one stream behind a mutex */
+	SQUASHFS_DECOMP_MULTI,		/* pool grown up to 2 per online cpu */
+	SQUASHFS_DECOMP_PERCPU,		/* one stream per cpu */
+};
+
+#if defined(CONFIG_SQUASHFS_DECOMP_MULTI_PERCPU)
+#define SQUASHFS_DECOMP_DEFAULT	SQUASHFS_DECOMP_PERCPU
+#elif defined(CONFIG_SQUASHFS_DECOMP_MULTI)
+#define SQUASHFS_DECOMP_DEFAULT	SQUASHFS_DECOMP_MULTI
+#else
+#define SQUASHFS_DECOMP_DEFAULT	SQUASHFS_DECOMP_SINGLE
+#endif
 
-static inline int squashfs_decompress(struct squashfs_sb_info *msblk,
-	void **buffer, struct buffer_head **bh, int b, int offset, int length,
-	int srclength, int pages)
-{
-	return msblk->decompressor->decompress(msblk, buffer, bh, b, offset,
-		length, srclength, pages);
-}
+/* decompressor_multi.c */
+extern int squashfs_decompress(struct squashfs_sb_info *, void **,
+	struct buffer_head **, int, int, int, int, int);
 
 #ifdef CONFIG_SQUASHFS_XZ
 extern const struct squashfs_decompressor squashfs_xz_comp_ops;
@@ -0,0 +1,349 @@
+/*
+ * Squashfs - a compressed read only filesystem for Linux
+ *
+ * Copyright (c) 2002, 2003, 2004, 2005, 2006, 2007, 2008, 2009
+ * Phillip Lougher <phillip@squashfs.org.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * decompressor_multi.c
+ */
+
+/*
+ * This file implements the management of decompressor streams.  With a
+ * single stream every block read on the filesystem is serialised, the
+ * multi and per-cpu modes let readers on different cpus decompress in
+ * parallel.
+ *
+ * multi:  streams are kept on a free list, a reader takes one and a new
+ *	   one is created on demand, up to two per online cpu.  If the
+ *	   limit is reached, or memory is short, the reader waits for a
+ *	   stream to be released.
+ *
+ * percpu: a stream is allocated for every possible cpu at mount, the
+ *	   reader takes the stream of the cpu it is running on under that
+ *	   stream's mutex.  The reader may sleep or migrate while it holds
+ *	   it, another reader on that cpu then waits for the stream.
+ *	   Fastest, at the cost of the memory of num_possible_cpus()
+ *	   streams.
+ */
+
+#include <linux/types.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/list.h>
+#include <linux/wait.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/buffer_head.h>
+
+#include "squashfs_fs.h"
+#include "squashfs_fs_sb.h"
+#include "decompressor.h"
+#include "squashfs.h"
+
+#define MAX_DECOMPRESSOR	(num_online_cpus() * 2)
+
+struct decomp_stream {
+	void			*stream;
+	struct list_head	list;
+};
+
+struct percpu_stream {
+	void			*stream;
+	struct mutex		mutex;
+};
+
+struct squashfs_stream {
+	int			mode;
+	void			*comp_opts;
+	int			comp_opts_len;
+	struct mutex		mutex;
+	/* SQUASHFS_DECOMP_SINGLE */
+	void			*stream;
+	/* SQUASHFS_DECOMP_MULTI */
+	struct list_head	strm_list;
+	int			avail_decomp;
+	wait_queue_head_t	wait;
+	/* SQUASHFS_DECOMP_PERCPU */
+	struct percpu_stream __percpu *percpu;
+};
+
+static const char * const squashfs_decomp_names[] = {
+	[SQUASHFS_DECOMP_SINGLE]	= "single",
+	[SQUASHFS_DECOMP_MULTI]		= "multi",
+	[SQUASHFS_DECOMP_PERCPU]	= "percpu",
+};
+
+
+int squashfs_decompressor_mode(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(squashfs_decomp_names); i++)
+		if (strcmp(name, squashfs_decomp_names[i]) == 0)
+			return i;
+
+	return -EINVAL;
+}
+
+
+const char *squashfs_decompressor_mode_name(int mode)
+{
+	return squashfs_decomp_names[mode];
+}
+
+
+static void *create_stream(struct squashfs_sb_info *msblk,
+	struct squashfs_stream *stream)
+{
+	return msblk->decompressor->init(msblk, stream->comp_opts,
+		stream->comp_opts_len);
+}
+
+
+static int create_percpu_streams(struct squashfs_sb_info *msblk,
+	struct squashfs_stream *stream)
+{
+	struct percpu_stream *pcs;
+	void *strm;
+	int cpu;
+
+	stream->percpu = alloc_percpu(struct percpu_stream);
+	if (stream->percpu == NULL)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		strm = create_stream(msblk, stream);
+		if (IS_ERR(strm))
+			return PTR_ERR(strm);
+		pcs = per_cpu_ptr(stream->percpu, cpu);
+		mutex_init(&pcs->mutex);
+		pcs->stream = strm;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Create the streams of the mode chosen at mount, takes ownership of
+ * the compressor options read from the filesystem
+ */
+int squashfs_decompressor_create(struct squashfs_sb_info *msblk,
+	void *comp_opts, int length)
+{
+	struct squashfs_stream *stream;
+	struct decomp_stream *decomp_strm;
+	int err;
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (stream == NULL) {
+		kfree(comp_opts);
+		return -ENOMEM;
+	}
+
+	stream->mode = msblk->threads;
+	stream->comp_opts = comp_opts;
+	stream->comp_opts_len = length;
+	mutex_init(&stream->mutex);
+	INIT_LIST_HEAD(&stream->strm_list);
+	init_waitqueue_head(&stream->wait);
+	msblk->stream = stream;
+
+	switch (stream->mode) {
+	case SQUASHFS_DECOMP_MULTI:
+		/*
+		 * One stream up front, so a reader always finds one to wait
+		 * for should creating more fail
+		 */
+		decomp_strm = kmalloc(sizeof(*decomp_strm), GFP_KERNEL);
+		if (decomp_strm == NULL) {
+			err = -ENOMEM;
+			goto failed;
+		}
+
+		decomp_strm->stream = create_stream(msblk, stream);
+		if (IS_ERR(decomp_strm->stream)) {
+			err = PTR_ERR(decomp_strm->stream);
+			kfree(decomp_strm);
+			goto failed;
+		}
+
+		list_add(&decomp_strm->list, &stream->strm_list);
+		stream->avail_decomp = 1;
+		break;
+	case SQUASHFS_DECOMP_PERCPU:
+		err = create_percpu_streams(msblk, stream);
+		if (err)
+			goto failed;
+		break;
+	default:
+		stream->stream = create_stream(msblk, stream);
+		if (IS_ERR(stream->stream)) {
+			err = PTR_ERR(stream->stream);
+			stream->stream = NULL;
+			goto failed;
+		}
+	}
+
+	return 0;
+
+failed:
+	squashfs_decompressor_destroy(msblk);
+	return err;
+}
+
+
+void squashfs_decompressor_destroy(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *stream = msblk->stream;
+	struct decomp_stream *decomp_strm, *next;
+	void *strm;
+	int cpu;
+
+	if (stream == NULL)
+		return;
+
+	switch (stream->mode) {
+	case SQUASHFS_DECOMP_MULTI:
+		list_for_each_entry_safe(decomp_strm, next, &stream->strm_list,
+								list) {
+			msblk->decompressor->free(decomp_strm->stream);
+			kfree(decomp_strm);
+			stream->avail_decomp--;
+		}
+		WARN_ON(stream->avail_decomp);
+		break;
+	case SQUASHFS_DECOMP_PERCPU:
+		if (stream->percpu == NULL)
+			break;
+		for_each_possible_cpu(cpu) {
+			strm = per_cpu_ptr(stream->percpu, cpu)->stream;
+			if (strm)
+				msblk->decompressor->free(strm);
+		}
+		free_percpu(stream->percpu);
+		break;
+	default:
+		if (stream->stream)
+			msblk->decompressor->free(stream->stream);
+	}
+
+	kfree(stream->comp_opts);
+	kfree(stream);
+	msblk->stream = NULL;
+}
+
+
+static struct decomp_stream *get_decomp_stream(struct squashfs_sb_info *msblk,
+	struct squashfs_stream *stream)
+{
+	struct decomp_stream *decomp_strm;
+
+	while (1) {
+		mutex_lock(&stream->mutex);
+
+		if (!list_empty(&stream->strm_list)) {
+			decomp_strm = list_first_entry(&stream->strm_list,
+				struct decomp_stream, list);
+			list_del(&decomp_strm->list);
+			break;
+		}
+
+		if (stream->avail_decomp >= MAX_DECOMPRESSOR)
+			goto wait;
+
+		decomp_strm = kmalloc(sizeof(*decomp_strm), GFP_KERNEL);
+		if (decomp_strm == NULL)
+			goto wait;
+
+		decomp_strm->stream = create_stream(msblk, stream);
+		if (IS_ERR(decomp_strm->stream)) {
+			kfree(decomp_strm);
+			goto wait;
+		}
+
+		stream->avail_decomp++;
+		break;
+
+wait:
+		/*
+		 * Rather than pushing the VM for another stream, wait
+		 * for a reader to release one
+		 */
+		mutex_unlock(&stream->mutex);
+		wait_event(stream->wait, !list_empty(&stream->strm_list));
+	}
+
+	mutex_unlock(&stream->mutex);
+	return decomp_strm;
+}
+
+
+static void put_decomp_stream(struct squashfs_stream *stream,
+	struct decomp_stream *decomp_strm)
+{
+	mutex_lock(&stream->mutex);
+	list_add(&decomp_strm->list, &stream->strm_list);
+	mutex_unlock(&stream->mutex);
+	wake_up(&stream->wait);
+}
+
+
+int squashfs_decompress(struct squashfs_sb_info *msblk, void **buffer,
+	struct buffer_head **bh, int b, int offset, int length, int srclength,
+	int pages)
+{
+	struct squashfs_stream *stream = msblk->stream;
+	struct decomp_stream *decomp_strm;
+	struct percpu_stream *pcs;
+	int res;
+
+	if (unlikely(stream == NULL)) {
+		for (res = 0; res < b; res++)
+			put_bh(bh[res]);
+		return -EIO;
+	}
+
+	switch (stream->mode) {
+	case SQUASHFS_DECOMP_MULTI:
+		decomp_strm = get_decomp_stream(msblk, stream);
+		res = msblk->decompressor->decompress(msblk,
+			decomp_strm->stream, buffer, bh, b, offset, length,
+			srclength, pages);
+		put_decomp_stream(stream, decomp_strm);
+		break;
+	case SQUASHFS_DECOMP_PERCPU:
+		/*
+		 * The cpu only picks the stream, its mutex guards it should
+		 * we migrate or sleep in the decompressor
+		 */
+		pcs = per_cpu_ptr(stream->percpu, raw_smp_processor_id());
+		mutex_lock(&pcs->mutex);
+		res = msblk->decompressor->decompress(msblk, pcs->stream,
+			buffer, bh, b, offset, length, srclength, pages);
+		mutex_unlock(&pcs->mutex);
+		break;
+	default:
+		mutex_lock(&stream->mutex);
+		res = msblk->decompressor->decompress(msblk, stream->stream,
+			buffer, bh, b, offset, length, srclength, pages);
+		mutex_unlock(&stream->mutex);
+	}
+
+	return res;
+}
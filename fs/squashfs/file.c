@@ -371,6 +371,121 @@ static int read_blocklist(struct inode *inode, int index, u64 *block)
 }
 
 
+/*
+ * Decompress a datablock straight into the page cache pages it covers,
+ * rather than into the "data" cache and copying it out from there.
+ *
+ * page[] holds the locked pages of the block the caller already has,
+ * the other slots are grabbed here.  Pages which can't be grabbed, are
+ * already uptodate or lie beyond the end of the file are decompressed
+ * into a scratch page and thrown away.
+ *
+ * A reference on every page but target_page is consumed.  On success all
+ * pages, target_page included, are uptodate and unlocked.  On failure the
+ * other pages are unlocked without being uptodate and target_page is left
+ * locked, -ENOMEM tells the caller it may fall back to the cache.
+ */
+static int squashfs_read_block_pages(struct inode *inode, struct page **page,
+	struct page *target_page, int start_index, u64 block, int bsize)
+{
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int pages = 1 << (msblk->block_log - PAGE_CACHE_SHIFT);
+	int file_end = (i_size_read(inode) - 1) >> PAGE_CACHE_SHIFT;
+	int i, n, res = -ENOMEM, bytes, avail;
+	void **data, *scratch = NULL;
+
+	data = kcalloc(pages, sizeof(*data), GFP_KERNEL);
+	if (data == NULL)
+		goto release;
+
+	for (i = 0, n = start_index; i < pages; i++, n++) {
+		if (page[i] == NULL && n <= file_end) {
+			page[i] = grab_cache_page_nowait(inode->i_mapping, n);
+			if (page[i] && PageUptodate(page[i])) {
+				unlock_page(page[i]);
+				page_cache_release(page[i]);
+				page[i] = NULL;
+			}
+		}
+
+		if (page[i]) {
+			data[i] = kmap(page[i]);
+			continue;
+		}
+
+		if (scratch == NULL) {
+			scratch = kmalloc(PAGE_CACHE_SIZE, GFP_KERNEL);
+			if (scratch == NULL)
+				goto release;
+		}
+		data[i] = scratch;
+	}
+
+	res = squashfs_read_data(inode->i_sb, data, block, bsize, NULL,
+		msblk->block_size, pages);
+	if (res < 0)
+		goto release;
+
+	for (i = 0, bytes = res; i < pages; i++, bytes -= PAGE_CACHE_SIZE) {
+		if (page[i] == NULL)
+			continue;
+
+		avail = clamp_t(int, bytes, 0, PAGE_CACHE_SIZE);
+		memset(data[i] + avail, 0, PAGE_CACHE_SIZE - avail);
+		kunmap(page[i]);
+		flush_dcache_page(page[i]);
+		SetPageUptodate(page[i]);
+		unlock_page(page[i]);
+		if (page[i] != target_page)
+			page_cache_release(page[i]);
+	}
+
+	kfree(scratch);
+	kfree(data);
+	return 0;
+
+release:
+	for (i = 0; i < pages; i++) {
+		if (page[i] == NULL)
+			continue;
+
+		if (data && data[i])
+			kunmap(page[i]);
+		if (page[i] != target_page) {
+			unlock_page(page[i]);
+			page_cache_release(page[i]);
+		}
+	}
+
+	kfree(scratch);
+	kfree(data);
+	return res;
+}
+
+
+static int squashfs_readpage_block(struct page *target_page, u64 block,
+	int bsize)
+{
+	struct inode *inode = target_page->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int mask = (1 << (msblk->block_log - PAGE_CACHE_SHIFT)) - 1;
+	int start_index = target_page->index & ~mask;
+	struct page **page;
+	int res;
+
+	page = kcalloc(mask + 1, sizeof(*page), GFP_KERNEL);
+	if (page == NULL)
+		return -ENOMEM;
+
+	page[target_page->index - start_index] = target_page;
+	res = squashfs_read_block_pages(inode, page, target_page, start_index,
+		block, bsize);
+
+	kfree(page);
+	return res;
+}
+
+
 static int squashfs_readpage(struct file *file, struct page *page)
 {
 	struct inode *inode = page->mapping->host;
@@ -410,8 +525,16 @@ static int squashfs_readpage(struct file *file, struct page *page)
 			sparse = 1;
 		} else {
 			/*
-			 * Read and decompress datablock.
+			 * Read and decompress datablock, straight into the
+			 * page cache unless memory is short.
 			 */
+			int res = squashfs_readpage_block(page, block, bsize);
+
+			if (res == 0)
+				return 0;
+			else if (res != -ENOMEM)
+				goto error_out;
+
 			buffer = squashfs_get_datablock(inode->i_sb,
 								block, bsize);
 			if (buffer->error) {
@@ -496,6 +619,80 @@ out:
 }
 
 
+/*
+ * Readahead.  The pages of each datablock in the readahead window are
+ * added to the page cache together and the block is decompressed once
+ * into all of them.  Fragments, holes and anything left over once a
+ * block can't be read go page by page through squashfs_readpage().
+ */
+static int squashfs_readpages(struct file *file, struct address_space *mapping,
+	struct list_head *pages, unsigned nr_pages)
+{
+	struct inode *inode = mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int shift = msblk->block_log - PAGE_CACHE_SHIFT;
+	int mask = (1 << shift) - 1;
+	int file_end = i_size_read(inode) >> msblk->block_log;
+	int index, start_index, bsize, added;
+	struct page **page, *p;
+	u64 block;
+
+	page = kcalloc(mask + 1, sizeof(*page), GFP_KERNEL);
+	if (page == NULL)
+		goto single_pages;
+
+	while (!list_empty(pages)) {
+		p = list_entry(pages->prev, struct page, lru);
+		index = p->index >> shift;
+		start_index = p->index & ~mask;
+
+		if (index >= file_end && squashfs_i(inode)->fragment_block !=
+						SQUASHFS_INVALID_BLK)
+			break;
+
+		bsize = read_blocklist(inode, index, &block);
+		if (bsize <= 0)
+			break;
+
+		/* the list is in ascending index order from its tail */
+		memset(page, 0, (mask + 1) * sizeof(*page));
+		added = 0;
+		while (!list_empty(pages)) {
+			p = list_entry(pages->prev, struct page, lru);
+			if ((p->index & ~mask) != start_index)
+				break;
+
+			list_del(&p->lru);
+			if (add_to_page_cache_lru(p, mapping, p->index,
+								GFP_KERNEL))
+				page_cache_release(p);
+			else {
+				page[p->index - start_index] = p;
+				added++;
+			}
+		}
+
+		if (added)
+			squashfs_read_block_pages(inode, page, NULL,
+				start_index, block, bsize);
+	}
+
+	kfree(page);
+
+single_pages:
+	while (!list_empty(pages)) {
+		p = list_entry(pages->prev, struct page, lru);
+		list_del(&p->lru);
+		if (!add_to_page_cache_lru(p, mapping, p->index, GFP_KERNEL))
+			squashfs_readpage(file, p);
+		page_cache_release(p);
+	}
+
+	return 0;
+}
+
+
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+	.readpages = squashfs_readpages
 };
@@ -48,7 +48,13 @@ extern void *squashfs_read_table(struct super_block *, u64, int);
 
 /* decompressor.c */
 extern const struct squashfs_decompressor *squashfs_lookup_decompressor(int);
-extern void *squashfs_decompressor_init(struct super_block *, unsigned short);
+extern int squashfs_decompressor_setup(struct super_block *, unsigned short);
+
+/* decompressor_multi.c */
+extern int squashfs_decompressor_mode(const char *);
+extern const char *squashfs_decompressor_mode_name(int);
+extern int squashfs_decompressor_create(struct squashfs_sb_info *, void *, int);
+extern void squashfs_decompressor_destroy(struct squashfs_sb_info *);
 
 /* export.c */
 extern __le64 *squashfs_read_inode_lookup_table(struct super_block *, u64, u64,
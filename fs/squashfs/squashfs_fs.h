@@ -207,6 +207,10 @@
 
 /* cached data constants for filesystem */
 #define SQUASHFS_CACHED_BLKS		8
+#define SQUASHFS_CACHED_DATA		1
+
+/* upper bound of the data_cache= and fragment_cache= mount options */
+#define SQUASHFS_CACHED_MAX		64
 
 #define SQUASHFS_MAX_FILE_SIZE_LOG	64
 
@@ -36,6 +36,8 @@
 #include <linux/module.h>
 #include <linux/magic.h>
 #include <linux/xattr.h>
+#include <linux/parser.h>
+#include <linux/seq_file.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -74,6 +76,70 @@ static const struct squashfs_decompressor *supported_squashfs_filesystem(short
 }
 
 
+enum {
+	Opt_threads, Opt_data_cache, Opt_fragment_cache, Opt_err
+};
+
+static const match_table_t squashfs_tokens = {
+	{Opt_threads, "threads=%s"},
+	{Opt_data_cache, "data_cache=%u"},
+	{Opt_fragment_cache, "fragment_cache=%u"},
+	{Opt_err, NULL}
+};
+
+static int squashfs_parse_options(struct squashfs_sb_info *msblk,
+	char *options)
+{
+	substring_t args[MAX_OPT_ARGS];
+	char *p, *name;
+	int token, mode, entries;
+
+	msblk->threads = SQUASHFS_DECOMP_DEFAULT;
+	msblk->data_entries = SQUASHFS_CACHED_DATA;
+	msblk->fragment_entries = SQUASHFS_CACHED_FRAGMENTS;
+
+	if (options == NULL)
+		return 0;
+
+	while ((p = strsep(&options, ",")) != NULL) {
+		if (!*p)
+			continue;
+
+		token = match_token(p, squashfs_tokens, args);
+		switch (token) {
+		case Opt_threads:
+			name = match_strdup(&args[0]);
+			if (name == NULL)
+				return -ENOMEM;
+			mode = squashfs_decompressor_mode(name);
+			kfree(name);
+			if (mode < 0)
+				goto bad_option;
+			msblk->threads = mode;
+			break;
+		case Opt_data_cache:
+		case Opt_fragment_cache:
+			if (match_int(&args[0], &entries) || entries < 1 ||
+					entries > SQUASHFS_CACHED_MAX)
+				goto bad_option;
+			if (token == Opt_data_cache)
+				msblk->data_entries = entries;
+			else
+				msblk->fragment_entries = entries;
+			break;
+		default:
+			goto bad_option;
+		}
+	}
+
+	return 0;
+
+bad_option:
+	ERROR("Unrecognized mount option \"%s\"\n", p);
+	return -EINVAL;
+}
+
+
 static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 {
 	struct squashfs_sb_info *msblk;
@@ -98,9 +164,12 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 	msblk->devblksize = sb_min_blocksize(sb, BLOCK_SIZE);
 	msblk->devblksize_log2 = ffz(~msblk->devblksize);
 
-	mutex_init(&msblk->read_data_mutex);
 	mutex_init(&msblk->meta_index_mutex);
 
+	err = squashfs_parse_options(msblk, data);
+	if (err)
+		goto failed_mount;
+
 	/*
 	 * msblk->bytes_used is checked in squashfs_read_table to ensure reads
 	 * are not beyond filesystem end.  But as we're using
@@ -201,18 +270,16 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 		goto failed_mount;
 
 	/* Allocate read_page block */
-	msblk->read_page = squashfs_cache_init("data", 1, msblk->block_size);
+	msblk->read_page = squashfs_cache_init("data", msblk->data_entries,
+		msblk->block_size);
 	if (msblk->read_page == NULL) {
 		ERROR("Failed to allocate read_page block\n");
 		goto failed_mount;
 	}
 
-	msblk->stream = squashfs_decompressor_init(sb, flags);
-	if (IS_ERR(msblk->stream)) {
-		err = PTR_ERR(msblk->stream);
-		msblk->stream = NULL;
+	err = squashfs_decompressor_setup(sb, flags);
+	if (err)
 		goto failed_mount;
-	}
 
 	/* Handle xattrs */
 	sb->s_xattr = squashfs_xattr_handlers;
@@ -271,7 +338,7 @@ handle_fragments:
 		goto check_directory_table;
 
 	msblk->fragment_cache = squashfs_cache_init("fragment",
-		SQUASHFS_CACHED_FRAGMENTS, msblk->block_size);
+		msblk->fragment_entries, msblk->block_size);
 	if (msblk->fragment_cache == NULL) {
 		err = -ENOMEM;
 		goto failed_mount;
@@ -332,7 +399,7 @@ failed_mount:
 	squashfs_cache_delete(msblk->block_cache);
 	squashfs_cache_delete(msblk->fragment_cache);
 	squashfs_cache_delete(msblk->read_page);
-	squashfs_decompressor_free(msblk, msblk->stream);
+	squashfs_decompressor_destroy(msblk);
 	kfree(msblk->inode_lookup_table);
 	kfree(msblk->fragment_index);
 	kfree(msblk->id_table);
@@ -372,6 +439,53 @@ static int squashfs_remount(struct super_block *sb, int *flags, char *data)
 }
 
 
+static int squashfs_show_options(struct seq_file *seq, struct vfsmount *mnt)
+{
+	struct squashfs_sb_info *msblk = mnt->mnt_sb->s_fs_info;
+
+	seq_printf(seq, ",threads=%s",
+		squashfs_decompressor_mode_name(msblk->threads));
+	seq_printf(seq, ",data_cache=%d", msblk->data_entries);
+	seq_printf(seq, ",fragment_cache=%d", msblk->fragment_entries);
+
+	return 0;
+}
+
+
+static void squashfs_show_cache(struct seq_file *seq,
+	struct squashfs_cache *cache)
+{
+	unsigned long hits, misses;
+
+	if (cache == NULL)
+		return;
+
+	spin_lock(&cache->lock);
+	hits = cache->hits;
+	misses = cache->misses;
+	spin_unlock(&cache->lock);
+
+	seq_printf(seq, "\n\tcache %s: entries %d hits %lu misses %lu",
+		cache->name, cache->entries, hits, misses);
+}
+
+
+/*
+ * Cache hit/miss counters, in /proc/self/mountstats
+ */
+static int squashfs_show_stats(struct seq_file *seq, struct vfsmount *mnt)
+{
+	struct squashfs_sb_info *msblk = mnt->mnt_sb->s_fs_info;
+
+	seq_printf(seq, "block_size %d", msblk->block_size);
+	squashfs_show_cache(seq, msblk->block_cache);
+	squashfs_show_cache(seq, msblk->fragment_cache);
+	squashfs_show_cache(seq, msblk->read_page);
+
+	return 0;
+}
+
+
 static void squashfs_put_super(struct super_block *sb)
 {
 	if (sb->s_fs_info) {
@@ -379,7 +493,7 @@ static void squashfs_put_super(struct super_block *sb)
 		squashfs_cache_delete(sbi->block_cache);
 		squashfs_cache_delete(sbi->fragment_cache);
 		squashfs_cache_delete(sbi->read_page);
-		squashfs_decompressor_free(sbi, sbi->stream);
+		squashfs_decompressor_destroy(sbi);
 		kfree(sbi->id_table);
 		kfree(sbi->fragment_index);
 		kfree(sbi->meta_index);
@@ -487,7 +601,9 @@ static const struct super_operations squashfs_super_ops = {
 	.destroy_inode = squashfs_destroy_inode,
 	.statfs = squashfs_statfs,
 	.put_super = squashfs_put_super,
-	.remount_fs = squashfs_remount
+	.remount_fs = squashfs_remount,
+	.show_options = squashfs_show_options,
+	.show_stats = squashfs_show_stats
 };
 
 module_init(init_squashfs_fs);
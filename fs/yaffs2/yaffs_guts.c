@@ -860,6 +860,44 @@ struct yaffs_tnode *yaffs_find_tnode_0(struct yaffs_dev *dev,
 	return tn;
 }
 
+/* Forget the cached level 0 tnodes, called whenever tnodes may be freed */
+void yaffs_tnode_cache_clear(struct yaffs_file_var *file_struct)
+{
+	memset(file_struct->tn_cache, 0, sizeof(file_struct->tn_cache));
+}
+
+/*
+ * Sequential reads and writes hit the same level 0 tnode 16 times in a row,
+ * so keep the last few found to save walking down the tree for every chunk.
+ */
+static struct yaffs_tnode *yaffs_find_tnode_0_cached(struct yaffs_dev *dev,
+					struct yaffs_file_var *file_struct,
+					u32 chunk_id)
+{
+	struct yaffs_tnode_cache *tc;
+	struct yaffs_tnode *tn;
+	u32 group;
+
+	if (!file_struct->top || chunk_id > YAFFS_MAX_CHUNK_ID)
+		return NULL;
+
+	group = (chunk_id >> YAFFS_TNODES_LEVEL0_BITS) + 1;
+	tc = &file_struct->tn_cache[group % YAFFS_TNODE_CACHE_SIZE];
+
+	if (tc->group == group) {
+		dev->tnode_cache_hits++;
+		return tc->tn;
+	}
+
+	dev->tnode_cache_misses++;
+	tn = yaffs_find_tnode_0(dev, file_struct, chunk_id);
+	if (tn) {
+		tc->group = group;
+		tc->tn = tn;
+	}
+	return tn;
+}
+
 /* AddOrFindLevel0Tnode finds the level 0 tnode if it exists, otherwise first expands the tree.
  * This happens in two steps:
  *  1. If the tree isn't tall enough, then make it taller.
@@ -938,10 +976,13 @@ struct yaffs_tnode *yaffs_add_find_tnode_0(struct yaffs_dev *dev,
 				/* Looking from level 1 at level 0 */
 				if (passed_tn) {
 					/* If we already have one, then release it. */
-					if (tn->internal[x])
+					if (tn->internal[x]) {
 						yaffs_free_tnode(dev,
 								 tn->
 								 internal[x]);
+						yaffs_tnode_cache_clear
+						    (file_struct);
+					}
 					tn->internal[x] = passed_tn;
 
 				} else if (!tn->internal[x]) {
@@ -1018,7 +1059,8 @@ static int yaffs_find_chunk_in_file(struct yaffs_obj *in, int inode_chunk,
 		tags = &local_tags;
 	}
 
-	tn = yaffs_find_tnode_0(dev, &in->variant.file_variant, inode_chunk);
+	tn = yaffs_find_tnode_0_cached(dev, &in->variant.file_variant,
+				       inode_chunk);
 
 	if (tn) {
 		the_chunk = yaffs_get_group_base(dev, tn, inode_chunk);
@@ -1046,7 +1088,8 @@ static int yaffs_find_del_file_chunk(struct yaffs_obj *in, int inode_chunk,
 		tags = &local_tags;
 	}
 
-	tn = yaffs_find_tnode_0(dev, &in->variant.file_variant, inode_chunk);
+	tn = yaffs_find_tnode_0_cached(dev, &in->variant.file_variant,
+				       inode_chunk);
 
 	if (tn) {
 
@@ -1712,6 +1755,7 @@ static void yaffs_soft_del_file(struct yaffs_obj *obj)
 {
 	if (obj->deleted &&
 	    obj->variant_type == YAFFS_OBJECT_TYPE_FILE && !obj->soft_del) {
+		yaffs_tnode_cache_clear(&obj->variant.file_variant);
 		if (obj->n_data_chunks <= 0) {
 			/* Empty file with no duplicate object headers,
 			 * just delete it immediately */
@@ -1802,6 +1846,8 @@ static int yaffs_prune_tree(struct yaffs_dev *dev,
 	int done = 0;
 	struct yaffs_tnode *tn;
 
+	yaffs_tnode_cache_clear(file_struct);
+
 	if (file_struct->top_level > 0) {
 		file_struct->top =
 		    yaffs_prune_worker(dev, file_struct->top,
@@ -2006,6 +2052,7 @@ struct yaffs_obj *yaffs_new_obj(struct yaffs_dev *dev, int number,
 			the_obj->variant.file_variant.shrink_size = ~0;	/* max */
 			the_obj->variant.file_variant.top_level = 0;
 			the_obj->variant.file_variant.top = tn;
+			yaffs_tnode_cache_clear(&the_obj->variant.file_variant);
 			break;
 		case YAFFS_OBJECT_TYPE_DIRECTORY:
 			INIT_LIST_HEAD(&the_obj->variant.dir_variant.children);
@@ -2891,6 +2938,8 @@ static int yaffs_check_gc(struct yaffs_dev *dev, int background)
 	int min_erased;
 	int erased_chunks;
 	int checkpt_block_adjust;
+	u64 gc_start = 0;
+	u32 gc_us;
 
 	if (dev->param.gc_control && (dev->param.gc_control(dev) & 1) == 0)
 		return YAFFS_OK;
@@ -2958,6 +3007,8 @@ static int yaffs_check_gc(struct yaffs_dev *dev, int background)
 				"yaffs: GC n_erased_blocks %d aggressive %d",
 				dev->n_erased_blocks, aggressive);
 
+			if (!gc_start)
+				gc_start = Y_TIME_US();
 			gc_ok = yaffs_gc_block(dev, dev->gc_block, aggressive);
 		}
 
@@ -2971,6 +3022,19 @@ static int yaffs_check_gc(struct yaffs_dev *dev, int background)
 	} while ((dev->n_erased_blocks < dev->param.n_reserved_blocks) &&
 		 (dev->gc_block > 0) && (max_tries < 2));
 
+	/* Account the time spent, a foreground gc stalls the writer */
+	if (gc_start) {
+		gc_us = (u32)(Y_TIME_US() - gc_start);
+		if (background) {
+			dev->bg_gc_us += gc_us;
+		} else {
+			dev->fg_gc_us += gc_us;
+			dev->fg_gc_stalls++;
+			if (gc_us > dev->fg_gc_stall_max_us)
+				dev->fg_gc_stall_max_us = gc_us;
+		}
+	}
+
 	return aggressive ? gc_ok : YAFFS_OK;
 }
 
@@ -4916,6 +4980,12 @@ int yaffs_guts_initialise(struct yaffs_dev *dev)
 	dev->passive_gc_count = 0;
 	dev->oldest_dirty_gc_count = 0;
 	dev->bg_gcs = 0;
+	dev->bg_gc_us = 0;
+	dev->fg_gc_us = 0;
+	dev->fg_gc_stalls = 0;
+	dev->fg_gc_stall_max_us = 0;
+	dev->tnode_cache_hits = 0;
+	dev->tnode_cache_misses = 0;
 	dev->gc_block_finder = 0;
 	dev->buffered_block = -1;
 	dev->doing_buffered_block_rewrite = 0;
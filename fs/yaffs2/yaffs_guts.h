@@ -338,6 +338,14 @@ struct yaffs_tnode {
 	struct yaffs_tnode *internal[YAFFS_NTNODES_INTERNAL];
 };
 
+/* Level 0 tnodes recently looked up in a file, saves walking the tree */
+#define YAFFS_TNODE_CACHE_SIZE	2
+
+struct yaffs_tnode_cache {
+	u32 group;		/* (chunk_id >> YAFFS_TNODES_LEVEL0_BITS) + 1, 0 if unused */
+	struct yaffs_tnode *tn;
+};
+
 /*------------------------  Object -----------------------------*/
 /* An object can be one of:
  * - a directory (no data, has children links
@@ -352,6 +360,7 @@ struct yaffs_file_var {
 	u32 shrink_size;
 	int top_level;
 	struct yaffs_tnode *top;
+	struct yaffs_tnode_cache tn_cache[YAFFS_TNODE_CACHE_SIZE];
 };
 
 struct yaffs_dir_var {
@@ -574,6 +583,10 @@ struct yaffs_param {
 	int auto_unicode;
 #endif
 	int always_check_erased;	/* Force chunk erased check always on */
+
+	int scan_threads;	/* Tag reader threads for the yaffs2 mount scan,
+				 * 0 reads the tags inline.
+				 */
 };
 
 struct yaffs_dev {
@@ -609,6 +622,9 @@ struct yaffs_dev {
 	int read_only;
 	int is_checkpointed;
 
+	/* Serialises NAND access while scan threads read ahead, else NULL */
+	struct mutex *nand_lock;
+
 	/* Stuff to support block offsetting to support start block zero */
 	int internal_start_block;
 	int internal_end_block;
@@ -734,6 +750,14 @@ struct yaffs_dev {
 	u32 n_unmarked_deletions;
 	u32 refresh_count;
 	u32 cache_hits;
+	u32 tnode_cache_hits;
+	u32 tnode_cache_misses;
+
+	/* Garbage collection time, in microseconds */
+	u64 bg_gc_us;
+	u64 fg_gc_us;
+	u32 fg_gc_stalls;	/* Writes that had to garbage collect */
+	u32 fg_gc_stall_max_us;
 
 };
 
@@ -904,6 +928,7 @@ void yaffs_skip_rest_of_block(struct yaffs_dev *dev);
 
 int yaffs_count_free_chunks(struct yaffs_dev *dev);
 
+void yaffs_tnode_cache_clear(struct yaffs_file_var *file_struct);
 struct yaffs_tnode *yaffs_find_tnode_0(struct yaffs_dev *dev,
 				       struct yaffs_file_var *file_struct,
 				       u32 chunk_id);
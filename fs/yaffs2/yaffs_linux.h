@@ -24,6 +24,9 @@ struct yaffs_linux_context {
 	struct super_block *super;
 	struct task_struct *bg_thread;	/* Background thread for this device */
 	int bg_running;
+	u32 bg_last_writes;	/* Host writes seen by the last pass */
+	unsigned long bg_last_write;	/* jiffies when they last changed */
+	u32 bg_checkpoints;	/* Checkpoints written by the thread */
 	struct mutex gross_lock;	/* Gross locking mutex*/
 	u8 *spare_buffer;	/* For mtdif2 use. Don't know the size of the buffer
 				 * at compile time so we have to allocate it.
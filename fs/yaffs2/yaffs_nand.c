@@ -17,6 +17,22 @@
 
 #include "yaffs_getblockinfo.h"
 
+/*
+ * The mount scan may read tags from several threads, the drivers share
+ * buffers and counters in the device so only one may be in at a time.
+ */
+static inline void yaffs_nand_lock(struct yaffs_dev *dev)
+{
+	if (dev->nand_lock)
+		mutex_lock(dev->nand_lock);
+}
+
+static inline void yaffs_nand_unlock(struct yaffs_dev *dev)
+{
+	if (dev->nand_lock)
+		mutex_unlock(dev->nand_lock);
+}
+
 int yaffs_rd_chunk_tags_nand(struct yaffs_dev *dev, int nand_chunk,
 			     u8 * buffer, struct yaffs_ext_tags *tags)
 {
@@ -25,6 +41,8 @@ int yaffs_rd_chunk_tags_nand(struct yaffs_dev *dev, int nand_chunk,
 
 	int realigned_chunk = nand_chunk - dev->chunk_offset;
 
+	yaffs_nand_lock(dev);
+
 	dev->n_page_reads++;
 
 	/* If there are no tags provided, use local tags to get prioritised gc working */
@@ -47,6 +65,8 @@ int yaffs_rd_chunk_tags_nand(struct yaffs_dev *dev, int nand_chunk,
 		yaffs_handle_chunk_error(dev, bi);
 	}
 
+	yaffs_nand_unlock(dev);
+
 	return result;
 }
 
@@ -54,6 +74,9 @@ int yaffs_wr_chunk_tags_nand(struct yaffs_dev *dev,
 			     int nand_chunk,
 			     const u8 * buffer, struct yaffs_ext_tags *tags)
 {
+	int result;
+
+	yaffs_nand_lock(dev);
 
 	dev->n_page_writes++;
 
@@ -75,20 +98,30 @@ int yaffs_wr_chunk_tags_nand(struct yaffs_dev *dev,
 	}
 
 	if (dev->param.write_chunk_tags_fn)
-		return dev->param.write_chunk_tags_fn(dev, nand_chunk, buffer,
-						      tags);
+		result = dev->param.write_chunk_tags_fn(dev, nand_chunk, buffer,
+							tags);
 	else
-		return yaffs_tags_compat_wr(dev, nand_chunk, buffer, tags);
+		result = yaffs_tags_compat_wr(dev, nand_chunk, buffer, tags);
+
+	yaffs_nand_unlock(dev);
+
+	return result;
 }
 
 int yaffs_mark_bad(struct yaffs_dev *dev, int block_no)
 {
+	int result;
+
 	block_no -= dev->block_offset;
 
+	yaffs_nand_lock(dev);
 	if (dev->param.bad_block_fn)
-		return dev->param.bad_block_fn(dev, block_no);
+		result = dev->param.bad_block_fn(dev, block_no);
 	else
-		return yaffs_tags_compat_mark_bad(dev, block_no);
+		result = yaffs_tags_compat_mark_bad(dev, block_no);
+	yaffs_nand_unlock(dev);
+
+	return result;
 }
 
 int yaffs_query_init_block_state(struct yaffs_dev *dev,
@@ -96,14 +129,20 @@ int yaffs_query_init_block_state(struct yaffs_dev *dev,
 				 enum yaffs_block_state *state,
 				 u32 * seq_number)
 {
+	int result;
+
 	block_no -= dev->block_offset;
 
+	yaffs_nand_lock(dev);
 	if (dev->param.query_block_fn)
-		return dev->param.query_block_fn(dev, block_no, state,
-						 seq_number);
+		result = dev->param.query_block_fn(dev, block_no, state,
+						   seq_number);
 	else
-		return yaffs_tags_compat_query_block(dev, block_no,
-						     state, seq_number);
+		result = yaffs_tags_compat_query_block(dev, block_no,
+						       state, seq_number);
+	yaffs_nand_unlock(dev);
+
+	return result;
 }
 
 int yaffs_erase_block(struct yaffs_dev *dev, int flash_block)
@@ -112,10 +151,14 @@ int yaffs_erase_block(struct yaffs_dev *dev, int flash_block)
 
 	flash_block -= dev->block_offset;
 
+	yaffs_nand_lock(dev);
+
 	dev->n_erasures++;
 
 	result = dev->param.erase_fn(dev, flash_block);
 
+	yaffs_nand_unlock(dev);
+
 	return result;
 }
 
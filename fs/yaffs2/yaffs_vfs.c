@@ -85,6 +85,7 @@ static uint32_t YCALCBLOCKS(uint64_t partition_size, uint32_t block_size)
 #include "yaffs_trace.h"
 #include "yaffs_guts.h"
 #include "yaffs_attribs.h"
+#include "yaffs_yaffs2.h"
 
 #include "yaffs_linux.h"
 
@@ -97,6 +98,9 @@ unsigned int yaffs_wr_attempts = YAFFS_WR_ATTEMPTS;
 unsigned int yaffs_auto_checkpoint = 1;
 unsigned int yaffs_gc_control = 1;
 unsigned int yaffs_bg_enable = 1;
+unsigned int yaffs_bg_gc_dirty_pct = 50;
+unsigned int yaffs_bg_checkpoint_secs = 30;
+unsigned int yaffs_scan_threads = 1;
 
 /* Module Parameters */
 module_param(yaffs_trace_mask, uint, 0644);
@@ -104,6 +108,9 @@ module_param(yaffs_wr_attempts, uint, 0644);
 module_param(yaffs_auto_checkpoint, uint, 0644);
 module_param(yaffs_gc_control, uint, 0644);
 module_param(yaffs_bg_enable, uint, 0644);
+module_param(yaffs_bg_gc_dirty_pct, uint, 0644);
+module_param(yaffs_bg_checkpoint_secs, uint, 0644);
+module_param(yaffs_scan_threads, uint, 0644);
 
 
 #define yaffs_inode_to_obj_lv(iptr) ((iptr)->i_private)
@@ -1546,26 +1553,53 @@ static void yaffs_flush_super(struct super_block *sb, int do_checkpoint)
 		yaffs_checkpoint_save(dev);
 }
 
-static unsigned yaffs_bg_gc_urgency(struct yaffs_dev *dev)
+/*
+ * Write the checkpoint once the device has been left alone for
+ * yaffs_bg_checkpoint_secs, so that a mount after an unclean shutdown
+ * usually finds a valid one instead of scanning the whole device.
+ */
+static int yaffs_bg_checkpoint_due(struct yaffs_dev *dev, unsigned long now)
+{
+	struct yaffs_linux_context *context = yaffs_dev_to_lc(dev);
+
+	if (!yaffs_bg_checkpoint_secs || !yaffs_auto_checkpoint ||
+	    dev->is_checkpointed || !yaffs2_checkpt_required(dev))
+		return 0;
+
+	return time_after(now, context->bg_last_write +
+			  yaffs_bg_checkpoint_secs * HZ);
+}
+
+/*
+ * How hard the background thread should collect.
+ * The free space that is not in erased blocks is "dirty", it has to be
+ * collected before it can be written.  Collection starts once the dirty
+ * share passes yaffs_bg_gc_dirty_pct, and gets urgent past 75%.  When the
+ * device is idle there is nobody to stall, so collect anyway.
+ */
+static unsigned yaffs_bg_gc_urgency(struct yaffs_dev *dev, int idle)
 {
 	unsigned erased_chunks =
 	    dev->n_erased_blocks * dev->param.chunks_per_block;
 	struct yaffs_linux_context *context = yaffs_dev_to_lc(dev);
 	unsigned scattered = 0;	/* Free chunks not in an erased block */
+	unsigned dirty_pct = 0;
 
-	if (erased_chunks < dev->n_free_chunks)
+	if (erased_chunks < dev->n_free_chunks) {
 		scattered = (dev->n_free_chunks - erased_chunks);
+		dirty_pct = (scattered * 100) / dev->n_free_chunks;
+	}
 
 	if (!context->bg_running)
 		return 0;
 	else if (scattered < (dev->param.chunks_per_block * 2))
 		return 0;
-	else if (erased_chunks > dev->n_free_chunks / 2)
-		return 0;
-	else if (erased_chunks > dev->n_free_chunks / 4)
+	else if (dirty_pct >= 75)
+		return 2;
+	else if (dirty_pct >= yaffs_bg_gc_dirty_pct || idle)
 		return 1;
 	else
-		return 2;
+		return 0;
 }
 
 static int yaffs_do_sync_fs(struct super_block *sb, int request_checkpoint)
@@ -1573,7 +1607,7 @@ static int yaffs_do_sync_fs(struct super_block *sb, int request_checkpoint)
 
 	struct yaffs_dev *dev = yaffs_super_to_dev(sb);
 	unsigned int oneshot_checkpoint = (yaffs_auto_checkpoint & 4);
-	unsigned gc_urgent = yaffs_bg_gc_urgency(dev);
+	unsigned gc_urgent = yaffs_bg_gc_urgency(dev, 0);
 	int do_checkpoint;
 
 	yaffs_trace(YAFFS_TRACE_OS | YAFFS_TRACE_SYNC | YAFFS_TRACE_BACKGROUND,
@@ -1624,6 +1658,9 @@ static int yaffs_bg_thread_fn(void *data)
 	unsigned long next_gc = now;
 	unsigned long expires;
 	unsigned int urgency;
+	u32 writes;
+	u32 gcs;
+	int idle;
 
 	int gc_result;
 	struct timer_list timer;
@@ -1650,10 +1687,29 @@ static int yaffs_bg_thread_fn(void *data)
 			next_dir_update = now + HZ;
 		}
 
+		/* Idle if nothing but gc wrote since last time */
+		writes = dev->n_page_writes - dev->n_gc_copies;
+		idle = (writes == context->bg_last_writes);
+		if (!idle)
+			context->bg_last_write = now;
+
 		if (time_after(now, next_gc) && yaffs_bg_enable) {
 			if (!dev->is_checkpointed) {
-				urgency = yaffs_bg_gc_urgency(dev);
+				urgency = yaffs_bg_gc_urgency(dev, idle);
+				gcs = dev->all_gcs;
 				gc_result = yaffs_bg_gc(dev, urgency);
+				/* Nothing worth collecting, don't spin while idle */
+				if (idle && gcs == dev->all_gcs)
+					urgency = 0;
+				if (urgency == 0 &&
+				    yaffs_bg_checkpoint_due(dev, now)) {
+					yaffs_flush_super(context->super, 1);
+					context->super->s_dirt = 0;
+					/* Retry later if it did not fit */
+					context->bg_last_write = now;
+					if (dev->is_checkpointed)
+						context->bg_checkpoints++;
+				}
 				if (urgency > 1)
 					next_gc = now + HZ / 20 + 1;
 				else if (urgency > 0)
@@ -1668,6 +1724,7 @@ static int yaffs_bg_thread_fn(void *data)
 				next_gc = next_dir_update;
                         }
 		}
+		context->bg_last_writes = dev->n_page_writes - dev->n_gc_copies;
 		yaffs_gross_unlock(dev);
 		expires = next_dir_update;
 		if (time_before(next_gc, expires))
@@ -1698,6 +1755,7 @@ static int yaffs_bg_start(struct yaffs_dev *dev)
 		return -1;
 
 	context->bg_running = 1;
+	context->bg_last_write = jiffies;
 
 	context->bg_thread = kthread_run(yaffs_bg_thread_fn,
 					 (void *)dev, "yaffs-bg-%d",
@@ -2296,6 +2354,7 @@ static struct super_block *yaffs_internal_read_super(int yaffs_version,
 
 	param->skip_checkpt_rd = options.skip_checkpoint_read;
 	param->skip_checkpt_wr = options.skip_checkpoint_write;
+	param->scan_threads = yaffs_scan_threads;
 
 	mutex_lock(&yaffs_context_lock);
 	/* Get a mount id */
@@ -2474,6 +2533,17 @@ static char *yaffs_dump_dev_part1(char *buf, struct yaffs_dev *dev)
 		    dev->oldest_dirty_gc_count);
 	buf += sprintf(buf, "n_gc_blocks........... %u\n", dev->n_gc_blocks);
 	buf += sprintf(buf, "bg_gcs................ %u\n", dev->bg_gcs);
+	buf += sprintf(buf, "bg_gc_us.............. %llu\n",
+			(unsigned long long)dev->bg_gc_us);
+	buf += sprintf(buf, "fg_gc_us.............. %llu\n",
+			(unsigned long long)dev->fg_gc_us);
+	buf += sprintf(buf, "fg_gc_stalls.......... %u\n", dev->fg_gc_stalls);
+	buf +=
+	    sprintf(buf, "fg_gc_stall_max_us.... %u\n",
+		    dev->fg_gc_stall_max_us);
+	buf +=
+	    sprintf(buf, "bg_checkpoints........ %u\n",
+		    yaffs_dev_to_lc(dev)->bg_checkpoints);
 	buf +=
 	    sprintf(buf, "n_retired_writes...... %u\n", dev->n_retired_writes);
 	buf +=
@@ -2486,6 +2556,12 @@ static char *yaffs_dump_dev_part1(char *buf, struct yaffs_dev *dev)
 	    sprintf(buf, "n_tags_ecc_unfixed.... %u\n",
 		    dev->n_tags_ecc_unfixed);
 	buf += sprintf(buf, "cache_hits............ %u\n", dev->cache_hits);
+	buf +=
+	    sprintf(buf, "tnode_cache_hits...... %u\n",
+		    dev->tnode_cache_hits);
+	buf +=
+	    sprintf(buf, "tnode_cache_misses.... %u\n",
+		    dev->tnode_cache_misses);
 	buf +=
 	    sprintf(buf, "n_deleted_files....... %u\n", dev->n_deleted_files);
 	buf +=
@@ -954,6 +954,230 @@ static int yaffs2_ybicmp(const void *a, const void *b)
 		return aseq - bseq;
 }
 
+/*
+ * Scan read ahead.
+ * The scan reads the tags of every chunk of a block before looking at
+ * any of them.  With scan_threads set, reader threads keep up to
+ * YAFFS_SCAN_AHEAD blocks of tags read ahead of the scan, so reading and
+ * ECC checking the tags overlaps with building the object tree.  The
+ * blocks are handed out in scan order, each slot holds one block.
+ */
+#define YAFFS_SCAN_AHEAD	8
+#define YAFFS_SCAN_MAX_THREADS	4
+
+struct yaffs_scan_slot {
+	int iter;		/* block_index entry held, -1 if free */
+	int ready;
+	struct yaffs_ext_tags *tags;
+};
+
+struct yaffs_scan_ahead {
+	struct yaffs_dev *dev;
+	struct yaffs_block_index *block_index;
+	int next_iter;		/* Next block_index entry to read, counts down */
+	int stop;
+	int n_slots;
+	int n_threads;
+	spinlock_t lock;
+	wait_queue_head_t wait;
+	struct mutex nand_lock;
+	struct yaffs_scan_slot slot[YAFFS_SCAN_AHEAD];
+	struct task_struct *thread[YAFFS_SCAN_MAX_THREADS];
+};
+
+static void yaffs2_scan_rd_block_tags(struct yaffs_dev *dev, int blk,
+				      struct yaffs_ext_tags *tags)
+{
+	int c;
+
+	for (c = dev->param.chunks_per_block - 1; c >= 0; c--)
+		yaffs_rd_chunk_tags_nand(dev,
+					 blk * dev->param.chunks_per_block + c,
+					 NULL, &tags[c]);
+}
+
+static int yaffs2_scan_claim(struct yaffs_scan_ahead *sa, int *iter)
+{
+	struct yaffs_scan_slot *slot;
+	int claimed = 0;
+
+	spin_lock(&sa->lock);
+	if (sa->stop || sa->next_iter < 0) {
+		*iter = -1;
+		claimed = 1;
+	} else {
+		slot = &sa->slot[sa->next_iter % sa->n_slots];
+		if (slot->iter < 0) {
+			slot->iter = sa->next_iter;
+			slot->ready = 0;
+			*iter = sa->next_iter--;
+			claimed = 1;
+		}
+	}
+	spin_unlock(&sa->lock);
+
+	return claimed;
+}
+
+static int yaffs2_scan_thread(void *data)
+{
+	struct yaffs_scan_ahead *sa = data;
+	struct yaffs_scan_slot *slot;
+	int iter;
+
+	for (;;) {
+		wait_event(sa->wait, yaffs2_scan_claim(sa, &iter));
+		if (iter < 0)
+			break;
+
+		slot = &sa->slot[iter % sa->n_slots];
+		yaffs2_scan_rd_block_tags(sa->dev, sa->block_index[iter].block,
+					  slot->tags);
+
+		spin_lock(&sa->lock);
+		slot->ready = 1;
+		spin_unlock(&sa->lock);
+		wake_up_all(&sa->wait);
+	}
+
+	/* Wait for the scan to collect us */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+static int yaffs2_scan_slot_ready(struct yaffs_scan_ahead *sa,
+				  struct yaffs_scan_slot *slot, int iter)
+{
+	int ready;
+
+	spin_lock(&sa->lock);
+	ready = (slot->iter == iter && slot->ready);
+	spin_unlock(&sa->lock);
+
+	return ready;
+}
+
+/* Get the tags of the block at block_index[iter], valid until put back */
+static struct yaffs_ext_tags *yaffs2_scan_get_tags(struct yaffs_scan_ahead *sa,
+						   int iter)
+{
+	struct yaffs_scan_slot *slot = &sa->slot[iter % sa->n_slots];
+
+	if (!sa->n_threads) {
+		yaffs2_scan_rd_block_tags(sa->dev, sa->block_index[iter].block,
+					  slot->tags);
+		return slot->tags;
+	}
+
+	wait_event(sa->wait, yaffs2_scan_slot_ready(sa, slot, iter));
+	return slot->tags;
+}
+
+static void yaffs2_scan_put_tags(struct yaffs_scan_ahead *sa, int iter)
+{
+	struct yaffs_scan_slot *slot = &sa->slot[iter % sa->n_slots];
+
+	if (!sa->n_threads)
+		return;
+
+	spin_lock(&sa->lock);
+	slot->iter = -1;
+	slot->ready = 0;
+	spin_unlock(&sa->lock);
+	wake_up_all(&sa->wait);
+}
+
+static void yaffs2_scan_stop(struct yaffs_scan_ahead *sa)
+{
+	int i;
+
+	spin_lock(&sa->lock);
+	sa->stop = 1;
+	spin_unlock(&sa->lock);
+	wake_up_all(&sa->wait);
+
+	for (i = 0; i < sa->n_threads; i++)
+		kthread_stop(sa->thread[i]);
+	sa->n_threads = 0;
+
+	sa->dev->nand_lock = NULL;
+
+	for (i = 0; i < sa->n_slots; i++)
+		kfree(sa->slot[i].tags);
+	kfree(sa);
+}
+
+static struct yaffs_scan_ahead *yaffs2_scan_start(struct yaffs_dev *dev,
+					struct yaffs_block_index *block_index,
+					int n_to_scan)
+{
+	struct yaffs_scan_ahead *sa;
+	int n_threads = dev->param.scan_threads;
+	int i;
+
+	/* Inband tags are read through the shared temporary buffers */
+	if (dev->param.inband_tags || n_to_scan < 2)
+		n_threads = 0;
+	if (n_threads > YAFFS_SCAN_MAX_THREADS)
+		n_threads = YAFFS_SCAN_MAX_THREADS;
+
+	sa = kzalloc(sizeof(*sa), GFP_NOFS);
+	if (!sa)
+		return NULL;
+
+	sa->dev = dev;
+	sa->block_index = block_index;
+	sa->next_iter = n_to_scan - 1;
+	sa->n_slots = n_threads ? YAFFS_SCAN_AHEAD : 1;
+	spin_lock_init(&sa->lock);
+	init_waitqueue_head(&sa->wait);
+	mutex_init(&sa->nand_lock);
+
+	for (i = 0; i < sa->n_slots; i++) {
+		sa->slot[i].iter = -1;
+		sa->slot[i].tags = kmalloc(dev->param.chunks_per_block *
+					   sizeof(struct yaffs_ext_tags),
+					   GFP_NOFS);
+		if (!sa->slot[i].tags) {
+			if (i == 0) {
+				kfree(sa);
+				return NULL;
+			}
+			/* Read ahead less */
+			sa->n_slots = i;
+			break;
+		}
+	}
+
+	if (n_threads)
+		dev->nand_lock = &sa->nand_lock;
+
+	for (i = 0; i < n_threads; i++) {
+		sa->thread[i] = kthread_run(yaffs2_scan_thread, sa,
+					    "yaffs-scan/%d", i);
+		if (IS_ERR(sa->thread[i]))
+			break;
+		sa->n_threads++;
+	}
+
+	if (!sa->n_threads) {
+		dev->nand_lock = NULL;
+		sa->next_iter = -1;
+	}
+
+	yaffs_trace(YAFFS_TRACE_SCAN,
+		"scan reading %d blocks ahead with %d threads",
+		sa->n_slots, sa->n_threads);
+
+	return sa;
+}
+
 int yaffs2_scan_backwards(struct yaffs_dev *dev)
 {
 	struct yaffs_ext_tags tags;
@@ -986,6 +1210,9 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 
 	struct yaffs_block_index *block_index = NULL;
 	int alt_block_index = 0;
+	struct yaffs_scan_ahead *sa;
+	struct yaffs_ext_tags *block_tags;
+	u64 scan_start = Y_TIME_US();
 
 	yaffs_trace(YAFFS_TRACE_SCAN,
 		"yaffs2_scan_backwards starts  intstartblk %d intendblk %d...",
@@ -1086,6 +1313,10 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 	end_iter = n_to_scan - 1;
 	yaffs_trace(YAFFS_TRACE_SCAN_DEBUG, "%d blocks to scan", n_to_scan);
 
+	sa = yaffs2_scan_start(dev, block_index, n_to_scan);
+	if (!sa)
+		alloc_failed = 1;
+
 	/* For each block.... backwards */
 	for (block_iter = end_iter; !alloc_failed && block_iter >= start_iter;
 	     block_iter--) {
@@ -1102,6 +1333,8 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 
 		deleted = 0;
 
+		block_tags = yaffs2_scan_get_tags(sa, block_iter);
+
 		/* For each chunk in each block that needs scanning.... */
 		found_chunks = 0;
 		for (c = dev->param.chunks_per_block - 1;
@@ -1114,8 +1347,7 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 
 			chunk = blk * dev->param.chunks_per_block + c;
 
-			result = yaffs_rd_chunk_tags_nand(dev, chunk, NULL,
-							  &tags);
+			tags = block_tags[c];
 
 			/* Let's have a good look at this chunk... */
 
@@ -1557,6 +1789,8 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 
 		}		/* End of scanning for each chunk */
 
+		yaffs2_scan_put_tags(sa, block_iter);
+
 		if (state == YAFFS_BLOCK_STATE_NEEDS_SCANNING) {
 			/* If we got this far while scanning, then the block is fully allocated. */
 			state = YAFFS_BLOCK_STATE_FULL;
@@ -1573,6 +1807,9 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 
 	}
 
+	if (sa)
+		yaffs2_scan_stop(sa);
+
 	yaffs_skip_rest_of_block(dev);
 
 	if (alt_block_index)
@@ -1592,7 +1829,9 @@ int yaffs2_scan_backwards(struct yaffs_dev *dev)
 	if (alloc_failed)
 		return YAFFS_FAIL;
 
-	yaffs_trace(YAFFS_TRACE_SCAN, "yaffs2_scan_backwards ends");
+	yaffs_trace(YAFFS_TRACE_SCAN | YAFFS_TRACE_MOUNT,
+		"yaffs2_scan_backwards ends, %d blocks in %u us",
+		n_to_scan, (u32)(Y_TIME_US() - scan_start));
 
 	return YAFFS_OK;
 }
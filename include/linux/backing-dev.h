@@ -42,6 +42,9 @@ enum bdi_stat_item {
 	BDI_WRITEBACK,
 	BDI_DIRTIED,
 	BDI_WRITTEN,
+	BDI_READAHEAD,		/* pages read ahead */
+	BDI_READAHEAD_HIT,	/* ... accessed afterwards */
+	BDI_READAHEAD_WASTE,	/* ... evicted or truncated unused */
 	NR_BDI_STAT_ITEMS
 };
 
@@ -80,6 +83,14 @@ struct backing_dev_info {
 	unsigned long write_bandwidth;	/* the estimated write bandwidth */
 	unsigned long avg_write_bandwidth; /* further smoothed write bw */
 
+	/*
+	 * Read completions sampled by the block layer, averages scaled by
+	 * 1 << BDI_READ_EWMA_SHIFT, see bdi_account_read().
+	 */
+	unsigned long read_latency;	/* us per small read */
+	unsigned long read_bytes;	/* bytes per large read */
+	unsigned long read_time;	/* us per large read */
+
 	/*
 	 * The base dirty throttle rate, re-calculated on every 200ms.
 	 * All the bdi tasks' dirty rate will be curbed under it.
@@ -118,6 +129,10 @@ int bdi_register(struct backing_dev_info *bdi, struct device *parent,
 int bdi_register_dev(struct backing_dev_info *bdi, dev_t dev);
 void bdi_unregister(struct backing_dev_info *bdi);
 int bdi_setup_and_register(struct backing_dev_info *, char *, unsigned int);
+void bdi_account_read(struct backing_dev_info *bdi, unsigned int bytes,
+		      unsigned long duration);
+unsigned long bdi_read_latency(struct backing_dev_info *bdi);
+unsigned long bdi_read_bandwidth(struct backing_dev_info *bdi);
 void bdi_start_writeback(struct backing_dev_info *bdi, long nr_pages,
 			enum wb_reason reason);
 void bdi_start_background_writeback(struct backing_dev_info *bdi);
@@ -144,6 +159,16 @@ static inline void __add_bdi_stat(struct backing_dev_info *bdi,
 	__percpu_counter_add(&bdi->bdi_stat[item], amount, BDI_STAT_BATCH);
 }
 
+static inline void add_bdi_stat(struct backing_dev_info *bdi,
+		enum bdi_stat_item item, s64 amount)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	__add_bdi_stat(bdi, item, amount);
+	local_irq_restore(flags);
+}
+
 static inline void __inc_bdi_stat(struct backing_dev_info *bdi,
 		enum bdi_stat_item item)
 {
@@ -1308,6 +1308,9 @@ struct block_device_operations {
 	int (*getgeo)(struct block_device *, struct hd_geometry *);
 	/* this callback is with swap_lock and sometimes page table lock held */
 	void (*swap_slot_free_notify) (struct block_device *, unsigned long);
+	/* synchronous swap page I/O, in process context, page locked */
+	int (*swap_rw_page) (struct block_device *, sector_t,
+			     struct page *, int rw);
 	struct module *owner;
 };
 
@@ -60,6 +60,7 @@ struct cma_alloc_request {
 
 #include <linux/rbtree.h>
 #include <linux/list.h>
+#include <linux/mutex.h>
 #if defined CONFIG_CMA_SYSFS
 #  include <linux/kobject.h>
 #endif
@@ -203,6 +204,27 @@ cma_info_about(struct cma_info *info, const const char *regions)
 
 struct cma_allocator;
 
+/**
+ * struct cma_lend_stats - how a lent region was taken back.
+ * @reclaims:		Chunks that had to be taken back from the page
+ *			allocator.
+ * @reclaim_pages:	Pages those chunks spanned.
+ * @reclaim_failed:	Chunks that could not be taken back, the pages
+ *			would not migrate.
+ * @reclaim_ns:		Time spent isolating and migrating, in total.
+ * @reclaim_max_ns:	Longest single take back.
+ * @alloc_failed:	Allocations from the region that failed, for lack
+ *			of space or of a successful take back.
+ */
+struct cma_lend_stats {
+	unsigned long reclaims;
+	unsigned long reclaim_pages;
+	unsigned long reclaim_failed;
+	u64 reclaim_ns;
+	u64 reclaim_max_ns;
+	unsigned long alloc_failed;
+};
+
 /**
  * struct cma_region - a region reserved for CMA allocations.
  * @name:	Unique name of the region.  Read only.
@@ -219,6 +241,11 @@ struct cma_allocator;
  *		different from @alloc->name.
  * @private_data:	Allocator's private data.
  * @users:	Number of chunks allocated in this region.
+ * @lock:	Serialises allocations and frees in this region, protects
+ *		@free_space, @users, @chunks, @lend_stats and the
+ *		allocator's private data.  Private.
+ * @chunks:	Chunks allocated in this region sorted by start address.
+ *		Private.
  * @list:	Entry in list of regions.  Private.
  * @used:	Whether region was already used, ie. there was at least
  *		one allocation request for.  Private.
@@ -228,6 +255,15 @@ struct cma_allocator;
  *		this region is converted from early to normal.  Early.
  *		Private.
  * @free_alloc_name:	Whether @alloc_name was kmalloced().  Private.
+ * @lend:	Whether the region is lent to the page allocator while its
+ *		space is free.  Set by platform code or by the "cma.lend"
+ *		command line argument.  Early.
+ * @nolend:	Never lend the region, eg. because it is handed to
+ *		a secure world.  Early.
+ * @lend_start_pfn:	First page frame of the lent part.  Read only.
+ * @lend_end_pfn:	One past the last page frame of the lent part,
+ *		equal to @lend_start_pfn if nothing was lent.  Read only.
+ * @lend_stats:	Statistics of the lent part.  Read only.
  *
  * Regions come in two types: an early region and normal region.  The
  * former can be reserved or not-reserved.  Fields marked as "early"
@@ -257,17 +293,27 @@ struct cma_region {
 	void *private_data;
 
 	unsigned users;
+	struct mutex lock;
+	struct rb_root chunks;
 	struct list_head list;
 
 #if defined CONFIG_CMA_SYSFS
 	struct kobject kobj;
 #endif
 
+#if defined CONFIG_DMA_CMA
+	unsigned long lend_start_pfn;
+	unsigned long lend_end_pfn;
+	struct cma_lend_stats lend_stats;
+#endif
+
 	unsigned used:1;
 	unsigned registered:1;
 	unsigned reserved:1;
 	unsigned copy_name:1;
 	unsigned free_alloc_name:1;
+	unsigned lend:1;
+	unsigned nolend:1;
 };
 
 
@@ -332,8 +378,8 @@ cma_alloc_from_region(struct cma_region *reg,
  * @size:	Size in bytes.
  * @free_space:	Free space in region in bytes.  Read only.
  * @reg:	Region this chunk belongs to.
- * @by_start:	A node in an red-black tree with all chunks sorted by
- *		start address.
+ * @by_start:	A node in an red-black tree with all chunks of the region
+ *		sorted by start address.
  *
  * The cma_allocator::alloc() operation need to set only the @start
  * and @size fields.  The rest is handled by the caller (ie. CMA
@@ -359,7 +405,8 @@ struct cma_chunk {
  *		two (thus non-zero) and callback does not need to check it.
  *		May also assume that it is the only call that uses given
  *		region (ie. access to the region is synchronised with
- *		a mutex).  This has to allocate the chunk object (it may be
+ *		the region's mutex), calls for different regions may run
+ *		concurrently.  This has to allocate the chunk object (it may be
  *		contained in a bigger structure with allocator-specific data.
  *		Required.
  * @free:	Frees allocated chunk.  May also assume that it is the only
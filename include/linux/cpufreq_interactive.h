@@ -0,0 +1,48 @@
+/*
+ * include/linux/cpufreq_interactive.h
+ *
+ * Boost interface of the interactive cpufreq governor.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#ifndef _LINUX_CPUFREQ_INTERACTIVE_H
+#define _LINUX_CPUFREQ_INTERACTIVE_H
+
+#include <linux/notifier.h>
+#include <linux/types.h>
+
+enum cpufreq_interactive_boost_reason {
+	INTERACTIVE_BOOST_INPUT,	/* touch or key event */
+	INTERACTIVE_BOOST_HISPEED,	/* one CPU's burst from the lowest speed */
+	INTERACTIVE_BOOST_USER,		/* "boostpulse" written from userspace */
+};
+
+/* Notifier events, called in atomic context */
+#define INTERACTIVE_BOOST_START		1
+
+struct cpufreq_interactive_boost {
+	enum cpufreq_interactive_boost_reason reason;
+	u64 start_us;			/* ktime of the request, in usecs */
+	unsigned long duration_us;	/* boost lasts at least this long */
+};
+
+#ifdef CONFIG_CPU_FREQ_GOV_INTERACTIVE
+/*
+ * Raise every CPU running the governor to hispeed_freq for
+ * boostpulse_duration and tell the boost listeners (bus, hotplug) so
+ * they can ramp at the same time. Safe to call from atomic context.
+ */
+void cpufreq_interactive_boost(enum cpufreq_interactive_boost_reason reason);
+int cpufreq_interactive_register_boost_notifier(struct notifier_block *nb);
+int cpufreq_interactive_unregister_boost_notifier(struct notifier_block *nb);
+#else
+static inline void
+cpufreq_interactive_boost(enum cpufreq_interactive_boost_reason reason)
+{
+}
+#endif
+
+#endif /* _LINUX_CPUFREQ_INTERACTIVE_H */
@@ -924,6 +924,13 @@ struct file_ra_state {
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
 	loff_t prev_pos;		/* Cache last read() position */
+
+	/* Strided reads, see try_stride_readahead() */
+	pgoff_t stride_prev;		/* start of the last random read */
+	pgoff_t stride_next;		/* first stride not read ahead yet */
+	unsigned long stride;		/* pages between random reads */
+	unsigned int stride_size;	/* pages read per stride */
+	unsigned int stride_hits;	/* times @stride repeated in a row */
 };
 
 /*
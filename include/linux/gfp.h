@@ -53,13 +53,7 @@ struct vm_area_struct;
 #define __GFP_HIGHMEM	((__force gfp_t)___GFP_HIGHMEM)
 #define __GFP_DMA32	((__force gfp_t)___GFP_DMA32)
 #define __GFP_MOVABLE	((__force gfp_t)___GFP_MOVABLE)  /* Page is movable */
-#ifndef CONFIG_DMA_CMA
 #define GFP_ZONEMASK	(__GFP_DMA|__GFP_HIGHMEM|__GFP_DMA32|__GFP_MOVABLE)
-#else
-#define __GFP_CMA	((__force gfp_t)___GFP_CMA)
-#define GFP_ZONEMASK	(__GFP_DMA|__GFP_HIGHMEM|__GFP_DMA32|__GFP_MOVABLE| \
-			__GFP_CMA)
-#endif
 /*
  * Action modifiers - doesn't change the zoning
  *
@@ -74,6 +68,10 @@ struct vm_area_struct;
  *
  * __GFP_MOVABLE: Flag that this page will be movable by the page migration
  * mechanism or reclaimed
+ *
+ * __GFP_CMA: Movable page that should be taken from the pageblocks a CMA
+ * region lends to the page allocator before any other.  Only for pages
+ * that are not pinned for long, so the region can be taken back quickly.
  */
 #define __GFP_WAIT	((__force gfp_t)___GFP_WAIT)	/* Can wait and reschedule? */
 #define __GFP_HIGH	((__force gfp_t)___GFP_HIGH)	/* Should access emergency pools? */
@@ -94,6 +92,11 @@ struct vm_area_struct;
 
 #define __GFP_NO_KSWAPD	((__force gfp_t)___GFP_NO_KSWAPD)
 #define __GFP_OTHER_NODE ((__force gfp_t)___GFP_OTHER_NODE) /* On behalf of other node */
+#ifdef CONFIG_DMA_CMA
+#define __GFP_CMA	((__force gfp_t)___GFP_CMA)	/* See above */
+#else
+#define __GFP_CMA	((__force gfp_t)0)
+#endif
 
 /*
  * This may seem redundant, but it's a way of annotating false positives vs.
@@ -131,11 +134,7 @@ struct vm_area_struct;
 #endif
 
 /* This mask makes up all the page movable related flags */
-#ifndef CONFIG_DMA_CMA
 #define GFP_MOVABLE_MASK (__GFP_RECLAIMABLE|__GFP_MOVABLE)
-#else
-#define GFP_MOVABLE_MASK (__GFP_RECLAIMABLE|__GFP_MOVABLE|__GFP_CMA)
-#endif
 
 /* Control page allocator reclaim behavior */
 #define GFP_RECLAIM_MASK (__GFP_WAIT|__GFP_HIGH|__GFP_IO|__GFP_FS|\
@@ -168,14 +167,8 @@ static inline int allocflags_to_migratetype(gfp_t gfp_flags)
 		return MIGRATE_UNMOVABLE;
 
 	/* Group based on mobility */
-#ifndef CONFIG_DMA_CMA
 	return (((gfp_flags & __GFP_MOVABLE) != 0) << 1) |
 		((gfp_flags & __GFP_RECLAIMABLE) != 0);
-#else
-	return (((gfp_flags & __GFP_MOVABLE) != 0) << 1) |
-		(((gfp_flags & __GFP_CMA) != 0) << 1) |
-		((gfp_flags & __GFP_RECLAIMABLE) != 0);
-#endif
 }
 
 #ifdef CONFIG_HIGHMEM
@@ -399,7 +392,13 @@ extern int alloc_contig_range(unsigned long start, unsigned long end,
 				unsigned migratetype);
 extern void free_contig_range(unsigned long pfn, unsigned nr_pages);
 /* CMA stuff */
-extern void init_cma_reserved_pageblock(struct page *page);
+extern int init_cma_reserved_pageblock(struct page *page);
+extern bool is_cma_pageblock(struct page *page);
+#else
+static inline bool is_cma_pageblock(struct page *page)
+{
+	return false;
+}
 #endif
 
 #endif /* __LINUX_GFP_H */
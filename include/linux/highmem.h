@@ -169,13 +169,15 @@ __alloc_zeroed_user_highpage(gfp_t movableflags,
  * @vaddr: The virtual address the page will be inserted into
  *
  * This function will allocate a page for a VMA that the caller knows will
- * be able to migrate in the future using move_pages() or reclaimed
+ * be able to migrate in the future using move_pages() or reclaimed.
+ * Anonymous memory is what a lent CMA region is best filled with.
  */
 static inline struct page *
 alloc_zeroed_user_highpage_movable(struct vm_area_struct *vma,
 					unsigned long vaddr)
 {
-	return __alloc_zeroed_user_highpage(__GFP_MOVABLE, vma, vaddr);
+	return __alloc_zeroed_user_highpage(__GFP_MOVABLE | __GFP_CMA,
+					    vma, vaddr);
 }
 
 static inline void clear_highpage(struct page *page)
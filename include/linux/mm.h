@@ -448,7 +448,7 @@ void put_page(struct page *page);
 void put_pages_list(struct list_head *pages);
 
 void split_page(struct page *page, unsigned int order);
-int split_free_page(struct page *page);
+int split_free_page(struct page *page, bool for_cma);
 
 /*
  * Compound pages have a destructor function.  Provide a
@@ -1492,6 +1492,15 @@ void page_cache_async_readahead(struct address_space *mapping,
 				unsigned long size);
 
 unsigned long max_sane_readahead(unsigned long nr);
+void __page_ra_used(struct page *page);
+
+/* The first access to a page brought in by readahead: a readahead hit */
+static inline void page_ra_used(struct page *page)
+{
+	if (unlikely(PageRaUnused(page)))
+		__page_ra_used(page);
+}
+
 unsigned long ra_submit(struct file_ra_state *ra,
 			struct address_space *mapping,
 			struct file *filp);
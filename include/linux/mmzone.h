@@ -40,8 +40,25 @@
 #define MIGRATE_MOVABLE       2
 #define MIGRATE_PCPTYPES      3 /* the number of types on the pcp lists */
 #define MIGRATE_RESERVE       3
+#ifdef CONFIG_DMA_CMA
+/*
+ * Pageblocks of a CMA region lent to the page allocator.  Only movable
+ * allocations are served from them and the pages never change type, so
+ * the region can be taken back by migrating them away.
+ */
+#define MIGRATE_CMA           4
+#define MIGRATE_ISOLATE       5 /* can't allocate from here */
+#define MIGRATE_TYPES         6
+#else
 #define MIGRATE_ISOLATE       4 /* can't allocate from here */
 #define MIGRATE_TYPES         5
+#endif
+
+#ifdef CONFIG_DMA_CMA
+#  define is_migrate_cma(migratetype) unlikely((migratetype) == MIGRATE_CMA)
+#else
+#  define is_migrate_cma(migratetype) false
+#endif
 
 #define for_each_migratetype_order(order, type) \
 	for (order = 0; order < MAX_ORDER; order++) \
@@ -116,6 +133,7 @@ enum zone_stat_item {
 	NUMA_OTHER,		/* allocation from other node */
 #endif
 	NR_ANON_TRANSPARENT_HUGEPAGES,
+	NR_FREE_CMA_PAGES,	/* free pages in lent CMA pageblocks */
 	NR_VM_ZONE_STAT_ITEMS };
 
 /*
@@ -184,10 +202,22 @@ enum zone_watermarks {
 #define low_wmark_pages(z) (z->watermark[WMARK_LOW])
 #define high_wmark_pages(z) (z->watermark[WMARK_HIGH])
 
+/*
+ * Orders 1 to PCP_MAX_ORDER (kernel stacks, skbs, page tables) are kept
+ * on per-cpu lists as well as order 0, so they bypass zone->lock too.
+ */
+#define PCP_MAX_ORDER		3
+
 struct per_cpu_pages {
-	int count;		/* number of pages in the list */
+	int count;		/* number of blocks in the list */
 	int high;		/* high watermark, emptying needed */
 	int batch;		/* chunk size for buddy add/remove */
+	int base_batch;		/* batch set up for the zone, floor of batch */
+	unsigned long refill;	/* jiffies of the last refill from the buddy */
+
+	/* Allocations served from the lists, and those that refilled them */
+	unsigned long hits;
+	unsigned long misses;
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[MIGRATE_PCPTYPES];
@@ -195,6 +225,7 @@ struct per_cpu_pages {
 
 struct per_cpu_pageset {
 	struct per_cpu_pages pcp;
+	struct per_cpu_pages high_pcp[PCP_MAX_ORDER];	/* orders 1.. */
 #ifdef CONFIG_NUMA
 	s8 expire;
 #endif
@@ -204,6 +235,12 @@ struct per_cpu_pageset {
 #endif
 };
 
+static inline struct per_cpu_pages *pageset_pcp(struct per_cpu_pageset *p,
+						unsigned int order)
+{
+	return order ? &p->high_pcp[order - 1] : &p->pcp;
+}
+
 #endif /* !__GENERATING_BOUNDS.H */
 
 enum zone_type {
@@ -651,6 +688,11 @@ typedef struct pglist_data {
 	struct task_struct *kswapd;	/* Protected by lock_memory_hotplug() */
 	int kswapd_max_order;
 	enum zone_type classzone_idx;
+#ifdef CONFIG_COMPACTION
+	wait_queue_head_t kcompactd_wait;
+	struct task_struct *kcompactd;	/* Protected by lock_memory_hotplug() */
+	int kcompactd_max_order;
+#endif
 } pg_data_t;
 
 #define node_present_pages(nid)	(NODE_DATA(nid)->node_present_pages)
@@ -98,6 +98,7 @@ enum pageflags {
 	PG_reclaim,		/* To be reclaimed asap */
 	PG_swapbacked,		/* Page is backed by RAM/swap */
 	PG_unevictable,		/* Page is "unevictable"  */
+	PG_ra_unused,		/* Read ahead, not accessed yet */
 #ifdef CONFIG_MMU
 	PG_mlocked,		/* Page is vma mlocked */
 #endif
@@ -244,6 +245,9 @@ PAGEFLAG(MappedToDisk, mappedtodisk)
 /* PG_readahead is only used for file reads; PG_reclaim is only for writes */
 PAGEFLAG(Reclaim, reclaim) TESTCLEARFLAG(Reclaim, reclaim)
 PAGEFLAG(Readahead, reclaim)		/* Reminder to do async read-ahead */
+/* Readahead hit and waste accounting, see page_ra_used() */
+PAGEFLAG(RaUnused, ra_unused) __SETPAGEFLAG(RaUnused, ra_unused)
+	TESTCLEARFLAG(RaUnused, ra_unused)
 
 #ifdef CONFIG_HIGHMEM
 /*
@@ -1982,6 +1982,25 @@ extern unsigned int sysctl_sched_min_granularity;
 extern unsigned int sysctl_sched_wakeup_granularity;
 extern unsigned int sysctl_sched_child_runs_first;
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+/* CPU utilization fed by the scheduler, see kernel/sched_fair.c */
+#define SCHED_UTIL_SCALE	1024
+
+struct notifier_block;
+
+struct sched_util_change {
+	int cpu;
+	unsigned long util;
+	unsigned long prev_util;
+};
+
+extern unsigned int sysctl_sched_util_notify_delta;
+
+extern unsigned long sched_cpu_util(int cpu);
+extern int sched_util_register_notifier(struct notifier_block *nb);
+extern int sched_util_unregister_notifier(struct notifier_block *nb);
+#endif
+
 enum sched_tunable_scaling {
 	SCHED_TUNABLESCALING_NONE,
 	SCHED_TUNABLESCALING_LOG,
@@ -0,0 +1,35 @@
+#ifndef _LINUX_TEST_TRIGGER_H
+#define _LINUX_TEST_TRIGGER_H
+
+#include <linux/module.h>
+#include <linux/mutex.h>
+
+struct dentry;
+
+/*
+ * A test run in the context of the task writing to /sys/kernel/debug/<file>,
+ * for tests that need the address space of a user task.  The runs are
+ * serialized and write() returns the error of ->run().
+ */
+struct test_trigger {
+	const char	*file;
+	int		(*run)(void);
+	struct module	*owner;
+
+	struct mutex	lock;		/* serializes the runs */
+	struct dentry	*dentry;
+};
+
+#define DEFINE_TEST_TRIGGER(name, file_name, run_fn)			\
+									\
+	struct test_trigger name = {					\
+		.file		= file_name,				\
+		.run		= run_fn,				\
+		.owner		= THIS_MODULE,				\
+		.lock		= __MUTEX_INITIALIZER(name.lock),	\
+	}
+
+extern int test_trigger_register(struct test_trigger *trigger);
+extern void test_trigger_unregister(struct test_trigger *trigger);
+
+#endif /* _LINUX_TEST_TRIGGER_H */
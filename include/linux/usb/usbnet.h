@@ -58,6 +58,34 @@ struct usbnet {
 	struct urb		*interrupt;
 	struct usb_anchor	deferred;
 	struct tasklet_struct	bh;
+	struct napi_struct	napi;
+	int			rx_poll_cpu;	/* cpu in usbnet_poll, or -1 */
+	struct sk_buff_head	rx_napi;	/* frames for GRO, poll only */
+
+	/* rx buffers recycled from completed urbs, refilled by keventd */
+	struct sk_buff_head	rx_pool;
+
+	/* tx aggregation, enabled when bind() sets tx_aggr_max_size */
+	spinlock_t		tx_aggr_lock;
+	struct sk_buff		*tx_aggr_skb;	/* frames waiting for an urb */
+	unsigned		tx_aggr_frames;
+	unsigned		tx_aggr_max_size;	/* bytes per urb */
+	unsigned		tx_aggr_max_frames;
+	unsigned		tx_aggr_align;	/* each frame starts aligned */
+	unsigned		tx_aggr_timeout_us;
+	struct hrtimer		tx_aggr_timer;
+
+	struct usbnet_stats {		/* reported by ethtool -S */
+		unsigned long	rx_pool_hits;
+		unsigned long	rx_pool_misses;
+		unsigned long	rx_recycled;
+		unsigned long	rx_alloc_errors;
+		unsigned long	tx_aggr_urbs;
+		unsigned long	tx_aggr_frames;
+		unsigned long	tx_aggr_max_depth;
+		unsigned long	tx_aggr_timeouts;
+		unsigned long	tx_aggr_alloc_errors;
+	} xstats;
 
 	struct work_struct	kevent;
 	unsigned long		flags;
@@ -70,6 +98,8 @@ struct usbnet {
 #		define EVENT_DEV_WAKING 6
 #		define EVENT_DEV_ASLEEP 7
 #		define EVENT_DEV_OPEN	8
+#		define EVENT_RX_NAPI	9
+#		define EVENT_RX_POOL	10
 };
 
 static inline struct usb_driver *driver_of(struct usb_interface *intf)
@@ -107,6 +137,7 @@ struct driver_info {
  */
 #define FLAG_MULTI_PACKET	0x2000
 #define FLAG_RX_ASSEMBLE	0x4000	/* rx packets may span >1 frames */
+#define FLAG_RX_COPY	0x8000		/* rx_fixup copies out every frame */
 
 	/* init device ... can sleep, or cause probe() failure */
 	int	(*bind)(struct usbnet *, struct usb_interface *);
@@ -201,6 +232,7 @@ struct skb_data {	/* skb->cb is one of these */
 	struct usbnet		*dev;
 	enum skb_state		state;
 	size_t			length;
+	unsigned		packets;	/* frames in a tx urb */
 };
 
 extern int usbnet_open(struct net_device *net);
@@ -229,5 +261,9 @@ extern u32 usbnet_get_msglevel(struct net_device *);
 extern void usbnet_set_msglevel(struct net_device *, u32);
 extern void usbnet_get_drvinfo(struct net_device *, struct ethtool_drvinfo *);
 extern int usbnet_nway_reset(struct net_device *net);
+extern int usbnet_get_sset_count(struct net_device *net, int sset);
+extern void usbnet_get_strings(struct net_device *net, u32 sset, u8 *data);
+extern void usbnet_get_ethtool_stats(struct net_device *net,
+				     struct ethtool_stats *stats, u64 *data);
 
 #endif /* __LINUX_USB_USBNET_H */
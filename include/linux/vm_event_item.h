@@ -39,6 +39,8 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 #ifdef CONFIG_COMPACTION
 		COMPACTBLOCKS, COMPACTPAGES, COMPACTPAGEFAILED,
 		COMPACTSTALL, COMPACTFAIL, COMPACTSUCCESS,
+		KCOMPACTD_WAKE, KCOMPACTD_PAGES,
+		KCOMPACTD_FAIL, KCOMPACTD_SUCCESS,
 #endif
 #ifdef CONFIG_HUGETLB_PAGE
 		HTLB_BUDDY_PGALLOC, HTLB_BUDDY_PGALLOC_FAIL,
@@ -57,6 +59,13 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_COLLAPSE_ALLOC,
 		THP_COLLAPSE_ALLOC_FAILED,
 		THP_SPLIT,
+#endif
+#ifdef CONFIG_HIGHMEM
+		KMAP_HIT,		/* kmap() of a page still mapped */
+		KMAP_MISS,		/* kmap() that took a new pkmap slot */
+		KMAP_WAIT,		/* kmap() slept for a free slot */
+		KMAP_FLUSH,		/* pkmap TLB flushes */
+		KMAP_FLUSH_PAGES,	/* pkmap slots unmapped by them */
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -0,0 +1,76 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cpufreq_interactive
+
+#if !defined(_TRACE_CPUFREQ_INTERACTIVE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_CPUFREQ_INTERACTIVE_H
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(cpufreq_interactive_boost,
+
+	TP_PROTO(const char *reason, unsigned long duration_us),
+
+	TP_ARGS(reason, duration_us),
+
+	TP_STRUCT__entry(
+		__string(reason, reason)
+		__field(unsigned long, duration_us)
+	),
+
+	TP_fast_assign(
+		__assign_str(reason, reason);
+		__entry->duration_us = duration_us;
+	),
+
+	TP_printk("reason=%s duration_us=%lu",
+		__get_str(reason),
+		__entry->duration_us)
+);
+
+/*
+ * Emitted once per resource (cpufreq, bus, cores) when it has reached
+ * its boosted level, latency_us is measured from the boost request.
+ */
+TRACE_EVENT(cpufreq_interactive_boost_ramp,
+
+	TP_PROTO(const char *stage, unsigned long latency_us),
+
+	TP_ARGS(stage, latency_us),
+
+	TP_STRUCT__entry(
+		__string(stage, stage)
+		__field(unsigned long, latency_us)
+	),
+
+	TP_fast_assign(
+		__assign_str(stage, stage);
+		__entry->latency_us = latency_us;
+	),
+
+	TP_printk("stage=%s latency_us=%lu",
+		__get_str(stage),
+		__entry->latency_us)
+);
+
+TRACE_EVENT(cpufreq_interactive_unboost,
+
+	TP_PROTO(unsigned long boosted_us),
+
+	TP_ARGS(boosted_us),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, boosted_us)
+	),
+
+	TP_fast_assign(
+		__entry->boosted_us = boosted_us;
+	),
+
+	TP_printk("boosted_us=%lu", __entry->boosted_us)
+);
+
+#endif /* _TRACE_CPUFREQ_INTERACTIVE_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
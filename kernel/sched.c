@@ -534,6 +534,15 @@ struct rq {
 	unsigned long calc_load_update;
 	long calc_load_active;
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+	/* decayed busy time of this CPU, see sched_fair.c */
+	u64 util_last_update;
+	u32 util_sum;
+	u32 util_period;
+	unsigned long util_avg;
+	unsigned long util_notified;
+#endif
+
 #ifdef CONFIG_SCHED_HRTICK
 #ifdef CONFIG_SMP
 	int hrtick_csd_pending;
@@ -4107,9 +4116,11 @@ void scheduler_tick(void)
 	raw_spin_lock(&rq->lock);
 	update_rq_clock(rq);
 	update_cpu_load_active(rq);
+	update_cpu_util(rq, curr != rq->idle);
 	curr->sched_class->task_tick(rq, curr, 0);
 	raw_spin_unlock(&rq->lock);
 
+	cpu_util_notify(rq, cpu);
 	perf_event_task_tick();
 
 #ifdef CONFIG_SMP
@@ -4310,6 +4321,9 @@ need_resched:
 	rq->skip_clock_update = 0;
 
 	if (likely(prev != next)) {
+		if ((prev == rq->idle) != (next == rq->idle))
+			update_cpu_util(rq, prev != rq->idle);
+
 		rq->nr_switches++;
 		rq->curr = next;
 #ifdef CONFIG_PREEMPT_COUNT_CPU
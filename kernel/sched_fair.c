@@ -4290,6 +4290,218 @@ static unsigned int get_rr_interval_fair(struct rq *rq, struct task_struct *task
 	return rr_interval;
 }
 
+#ifdef CONFIG_SCHED_CPU_UTIL
+/*
+ * Per-CPU utilization for cpufreq governors.
+ *
+ * Busy (non-idle) time is accumulated in 1024us periods and decayed
+ * geometrically with y^32 = 1/2, so a period 32ms ago counts half as
+ * much as the current one. The sum is kept next to the sum of all
+ * elapsed time, their ratio scaled to SCHED_UTIL_SCALE is the
+ * utilization. It is updated when the CPU enters or leaves idle and
+ * on every tick, so it never needs a timer of its own.
+ */
+
+/*
+ * Minimum change of the utilization, in SCHED_UTIL_SCALE units, that
+ * is reported to the notifiers from the tick.
+ */
+unsigned int sysctl_sched_util_notify_delta = SCHED_UTIL_SCALE / 8;
+
+static ATOMIC_NOTIFIER_HEAD(sched_util_notifier_list);
+
+#define UTIL_AVG_PERIOD		32
+#define UTIL_AVG_MAX		47742	/* maximum possible sum */
+#define UTIL_AVG_MAX_N		345	/* periods to reach UTIL_AVG_MAX */
+
+/* y^n * 2^32 for n = 0..31 */
+static const u32 util_avg_yN_inv[] = {
+	0xffffffff, 0xfa83b2da, 0xf5257d14, 0xefe4b99a, 0xeac0c6e6, 0xe5b906e6,
+	0xe0ccdeeb, 0xdbfbb796, 0xd744fcc9, 0xd2a81d91, 0xce248c14, 0xc9b9bd85,
+	0xc5672a10, 0xc12c4cc9, 0xbd08a39e, 0xb8fbaf46, 0xb504f333, 0xb123f581,
+	0xad583ee9, 0xa9a15ab4, 0xa5fed6a9, 0xa2704302, 0x9ef5325f, 0x9b8d39b9,
+	0x9837f050, 0x94f4efa8, 0x91c3d373, 0x8ea4398a, 0x8b95c1e3, 0x88980e80,
+	0x85aac367, 0x82cd8698,
+};
+
+/* 1024 * sum(y^k) for k = 1..n, n = 0..32 */
+static const u32 util_avg_yN_sum[] = {
+	    0, 1002, 1982, 2941, 3880, 4798, 5697, 6576, 7437, 8279, 9103,
+	 9909, 10698, 11470, 12226, 12966, 13690, 14398, 15091, 15769, 16433,
+	17082, 17718, 18340, 18949, 19545, 20128, 20698, 21256, 21802, 22336,
+	22859, 23371,
+};
+
+static u64 util_decay(u64 val, u64 n)
+{
+	unsigned int local_n;
+
+	if (!n)
+		return val;
+	else if (unlikely(n > UTIL_AVG_PERIOD * 63))
+		return 0;
+
+	local_n = n;
+	if (unlikely(local_n >= UTIL_AVG_PERIOD)) {
+		val >>= local_n / UTIL_AVG_PERIOD;
+		local_n %= UTIL_AVG_PERIOD;
+	}
+
+	return (val * util_avg_yN_inv[local_n]) >> 32;
+}
+
+/* Contribution of n full periods, 1024 * sum(y^k) for k = 1..n */
+static u32 util_contrib(u64 n)
+{
+	u32 contrib = 0;
+
+	if (likely(n <= UTIL_AVG_PERIOD))
+		return util_avg_yN_sum[n];
+	else if (unlikely(n >= UTIL_AVG_MAX_N))
+		return UTIL_AVG_MAX;
+
+	do {
+		contrib /= 2;
+		contrib += util_avg_yN_sum[UTIL_AVG_PERIOD];
+		n -= UTIL_AVG_PERIOD;
+	} while (n > UTIL_AVG_PERIOD);
+
+	contrib = util_decay(contrib, n);
+	return contrib + util_avg_yN_sum[n];
+}
+
+/*
+ * Fold the time since the last update into the sums, the CPU has been
+ * busy over all of it or idle over all of it.
+ */
+static void __update_util_sums(u64 now, u64 *last_update, u32 *sum,
+			       u32 *period, int busy)
+{
+	u64 delta, periods;
+	u32 delta_w;
+
+	delta = now - *last_update;
+	if ((s64)delta < 0) {
+		*last_update = now;
+		return;
+	}
+
+	/* work in ~1us units, the period is 1024us */
+	delta >>= 10;
+	if (!delta)
+		return;
+	*last_update += delta << 10;
+
+	delta_w = *period % 1024;
+	if (delta + delta_w >= 1024) {
+		delta_w = 1024 - delta_w;
+		if (busy)
+			*sum += delta_w;
+		*period += delta_w;
+		delta -= delta_w;
+
+		periods = delta / 1024;
+		delta %= 1024;
+
+		*sum = util_decay(*sum, periods + 1);
+		*period = util_decay(*period, periods + 1);
+
+		delta_w = util_contrib(periods);
+		if (busy)
+			*sum += delta_w;
+		*period += delta_w;
+	}
+
+	if (busy)
+		*sum += delta;
+	*period += delta;
+}
+
+static void update_cpu_util(struct rq *rq, int busy)
+{
+	__update_util_sums(rq->clock, &rq->util_last_update, &rq->util_sum,
+			   &rq->util_period, busy);
+	rq->util_avg = div_u64((u64)rq->util_sum * SCHED_UTIL_SCALE,
+			       rq->util_period + 1);
+}
+
+/*
+ * Called from the tick with the rq unlocked, so that a notifier may
+ * kick a timer or wake up a governor thread.
+ */
+static void cpu_util_notify(struct rq *rq, int cpu)
+{
+	unsigned long util = rq->util_avg;
+	unsigned long prev = rq->util_notified;
+	struct sched_util_change change;
+
+	if (abs((long)util - (long)prev) < sysctl_sched_util_notify_delta)
+		return;
+
+	rq->util_notified = util;
+
+	change.cpu = cpu;
+	change.util = util;
+	change.prev_util = prev;
+	atomic_notifier_call_chain(&sched_util_notifier_list, 0, &change);
+}
+
+/**
+ * sched_cpu_util - utilization of a CPU
+ * @cpu: the CPU in question
+ *
+ * Returns the decayed busy fraction of @cpu in SCHED_UTIL_SCALE units.
+ * A CPU sitting in idle with its tick stopped is decayed as idle up to
+ * now, on a copy of its sums, so reading it does not wake it up.  The
+ * copy is taken under the rq lock, the u64 would tear on 32-bit.
+ */
+unsigned long sched_cpu_util(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned long flags, util;
+	u64 last_update;
+	u32 sum, period;
+	int idle;
+
+	raw_spin_lock_irqsave(&rq->lock, flags);
+	last_update = rq->util_last_update;
+	sum = rq->util_sum;
+	period = rq->util_period;
+	util = rq->util_avg;
+	idle = rq->curr == rq->idle;
+	raw_spin_unlock_irqrestore(&rq->lock, flags);
+
+	if (idle) {
+		__update_util_sums(sched_clock_cpu(cpu), &last_update,
+				   &sum, &period, 0);
+		util = div_u64((u64)sum * SCHED_UTIL_SCALE, period + 1);
+	}
+
+	return util;
+}
+EXPORT_SYMBOL_GPL(sched_cpu_util);
+
+/*
+ * The notifiers get a struct sched_util_change each time the
+ * utilization of a busy CPU moved by sysctl_sched_util_notify_delta
+ * since the last report. They run from the tick, in hard irq context.
+ */
+int sched_util_register_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&sched_util_notifier_list, nb);
+}
+EXPORT_SYMBOL_GPL(sched_util_register_notifier);
+
+int sched_util_unregister_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&sched_util_notifier_list, nb);
+}
+EXPORT_SYMBOL_GPL(sched_util_unregister_notifier);
+#else
+static inline void update_cpu_util(struct rq *rq, int busy) { }
+static inline void cpu_util_notify(struct rq *rq, int cpu) { }
+#endif /* CONFIG_SCHED_CPU_UTIL */
+
 /*
  * All the scheduling class methods:
  */
@@ -0,0 +1,81 @@
+/*
+ * lib/test_trigger.c
+ *
+ * Debugfs files that run a test in the context of the writing task.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/test_trigger.h>
+
+static int test_trigger_open(struct inode *inode, struct file *filp)
+{
+	struct test_trigger *trigger = inode->i_private;
+
+	/* the test and its trigger live in the module */
+	if (!try_module_get(trigger->owner))
+		return -ENODEV;
+
+	filp->private_data = trigger;
+	return 0;
+}
+
+static int test_trigger_release(struct inode *inode, struct file *filp)
+{
+	struct test_trigger *trigger = filp->private_data;
+
+	module_put(trigger->owner);
+	return 0;
+}
+
+static ssize_t test_trigger_write(struct file *filp, const char __user *ubuf,
+				  size_t count, loff_t *ppos)
+{
+	struct test_trigger *trigger = filp->private_data;
+	int err;
+
+	mutex_lock(&trigger->lock);
+	err = trigger->run();
+	mutex_unlock(&trigger->lock);
+
+	return err ? err : count;
+}
+
+static const struct file_operations test_trigger_fops = {
+	.open		= test_trigger_open,
+	.release	= test_trigger_release,
+	.write		= test_trigger_write,
+	.llseek		= noop_llseek,
+};
+
+/**
+ * test_trigger_register - create the debugfs file of a test
+ * @trigger: the test, defined with DEFINE_TEST_TRIGGER()
+ *
+ * Returns 0 on success, -ENOMEM if the file could not be created.
+ */
+int test_trigger_register(struct test_trigger *trigger)
+{
+	trigger->dentry = debugfs_create_file(trigger->file, S_IWUSR, NULL,
+					      trigger, &test_trigger_fops);
+	return trigger->dentry ? 0 : -ENOMEM;
+}
+EXPORT_SYMBOL_GPL(test_trigger_register);
+
+/**
+ * test_trigger_unregister - remove the debugfs file of a test
+ * @trigger: the test
+ */
+void test_trigger_unregister(struct test_trigger *trigger)
+{
+	debugfs_remove(trigger->dentry);
+	trigger->dentry = NULL;
+}
+EXPORT_SYMBOL_GPL(test_trigger_unregister);
@@ -27,6 +27,12 @@
 #include <linux/personality.h>
 #include <linux/bitops.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/percpu.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/shmem_fs.h>
 #include <linux/ashmem.h>
 
@@ -37,11 +43,12 @@
 /*
  * ashmem_area - anonymous shared memory area
  * Lifecycle: From our parent file's open() until its release()
- * Locking: Protected by `ashmem_mutex'
+ * Locking: Protected by its own `lock'
  * Big Note: Mappings do NOT pin this structure; it dies on close()
  */
 struct ashmem_area {
 	char name[ASHMEM_FULL_NAME_LEN];/* optional name for /proc/pid/maps */
+	struct mutex lock;		/* protects the area and its ranges */
 	struct list_head unpinned_list;	/* list of all ashmem areas */
 	struct file *file;		/* the shmem-based backing file */
 	size_t size;			/* size of the mapping, in bytes */
@@ -51,7 +58,7 @@ struct ashmem_area {
 /*
  * ashmem_range - represents an interval of unpinned (evictable) pages
  * Lifecycle: From unpin to pin
- * Locking: Protected by `ashmem_mutex'
+ * Locking: Protected by the area's `lock', `lru' also by `ashmem_lru_lock'
  */
 struct ashmem_range {
 	struct list_head lru;		/* entry in LRU list */
@@ -62,18 +69,44 @@ struct ashmem_range {
 	unsigned int purged;		/* ASHMEM_NOT or ASHMEM_WAS_PURGED */
 };
 
-/* LRU list of unpinned pages, protected by ashmem_mutex */
+/* LRU list of unpinned pages, protected by ashmem_lru_lock */
 static LIST_HEAD(ashmem_lru_list);
 
-/* Count of pages on our LRU list, protected by ashmem_mutex */
+/* Count of pages on our LRU list, protected by ashmem_lru_lock */
 static unsigned long lru_count;
 
 /*
- * ashmem_mutex - protects the list of and each individual ashmem_area
+ * ashmem_lru_lock - protects the LRU list and lru_count, never held for
+ * longer than a list operation.  Pin, unpin and mmap of one area only
+ * serialize on that area's lock, and the shrinker holds just the lock of
+ * the area it is purging while it truncates.
  *
- * Lock Ordering: ashmex_mutex -> i_mutex -> i_alloc_sem
+ * Lock Ordering: asma->lock -> ashmem_lru_lock
+ *		  asma->lock -> i_mutex -> i_alloc_sem
  */
-static DEFINE_MUTEX(ashmem_mutex);
+static DEFINE_SPINLOCK(ashmem_lru_lock);
+
+/*
+ * Per-cpu so that pinning never bounces a shared line, summed in
+ * /sys/kernel/debug/ashmem.  Latencies run from the ioctl to its return,
+ * waiting for the area's lock included.
+ */
+struct ashmem_stats {
+	unsigned long pins;
+	unsigned long unpins;
+	u64 pin_ns;
+	u64 pin_max_ns;
+	u64 unpin_ns;
+	u64 unpin_max_ns;
+	unsigned long purges;		/* vmtruncate_range() calls */
+	unsigned long ranges_purged;
+	u64 bytes_purged;
+	unsigned long busy;		/* areas skipped by the shrinker */
+};
+
+static DEFINE_PER_CPU(struct ashmem_stats, ashmem_stats);
+
+static struct dentry *ashmem_debugfs;
 
 static struct kmem_cache *ashmem_area_cachep __read_mostly;
 static struct kmem_cache *ashmem_range_cachep __read_mostly;
@@ -102,6 +135,7 @@ static struct kmem_cache *ashmem_range_cachep __read_mostly;
 
 #define PROT_MASK		(PROT_EXEC | PROT_READ | PROT_WRITE)
 
+/* Caller must hold ashmem_lru_lock */
 static inline void lru_add(struct ashmem_range *range)
 {
 	list_add_tail(&range->lru, &ashmem_lru_list);
@@ -123,7 +157,7 @@ static inline void lru_del(struct ashmem_range *range)
  * 'start' - starting page, inclusive
  * 'end' - ending page, inclusive
  *
- * Caller must hold ashmem_mutex.
+ * Caller must hold the area's lock.
  */
 static int range_alloc(struct ashmem_area *asma,
 		       struct ashmem_range *prev_range, unsigned int purged,
@@ -142,8 +176,11 @@ static int range_alloc(struct ashmem_area *asma,
 
 	list_add_tail(&range->unpinned, &prev_range->unpinned);
 
-	if (range_on_lru(range))
+	if (range_on_lru(range)) {
+		spin_lock(&ashmem_lru_lock);
 		lru_add(range);
+		spin_unlock(&ashmem_lru_lock);
+	}
 
 	return 0;
 }
@@ -151,15 +188,18 @@ static int range_alloc(struct ashmem_area *asma,
 static void range_del(struct ashmem_range *range)
 {
 	list_del(&range->unpinned);
-	if (range_on_lru(range))
+	if (range_on_lru(range)) {
+		spin_lock(&ashmem_lru_lock);
 		lru_del(range);
+		spin_unlock(&ashmem_lru_lock);
+	}
 	kmem_cache_free(ashmem_range_cachep, range);
 }
 
 /*
  * range_shrink - shrinks a range
  *
- * Caller must hold ashmem_mutex.
+ * Caller must hold the area's lock.
  */
 static inline void range_shrink(struct ashmem_range *range,
 				size_t start, size_t end)
@@ -169,8 +209,11 @@ static inline void range_shrink(struct ashmem_range *range,
 	range->pgstart = start;
 	range->pgend = end;
 
-	if (range_on_lru(range))
+	if (range_on_lru(range)) {
+		spin_lock(&ashmem_lru_lock);
 		lru_count -= pre - range_size(range);
+		spin_unlock(&ashmem_lru_lock);
+	}
 }
 
 static int ashmem_open(struct inode *inode, struct file *file)
@@ -186,6 +229,7 @@ static int ashmem_open(struct inode *inode, struct file *file)
 	if (unlikely(!asma))
 		return -ENOMEM;
 
+	mutex_init(&asma->lock);
 	INIT_LIST_HEAD(&asma->unpinned_list);
 	memcpy(asma->name, ASHMEM_NAME_PREFIX, ASHMEM_NAME_PREFIX_LEN);
 	asma->prot_mask = PROT_MASK;
@@ -199,10 +243,11 @@ static int ashmem_release(struct inode *ignored, struct file *file)
 	struct ashmem_area *asma = file->private_data;
 	struct ashmem_range *range, *next;
 
-	mutex_lock(&ashmem_mutex);
+	/* waits for a shrinker purging this area */
+	mutex_lock(&asma->lock);
 	list_for_each_entry_safe(range, next, &asma->unpinned_list, unpinned)
 		range_del(range);
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 
 	if (asma->file)
 		fput(asma->file);
@@ -217,7 +262,7 @@ static ssize_t ashmem_read(struct file *file, char __user *buf,
 	struct ashmem_area *asma = file->private_data;
 	int ret = 0;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	/* If size is not set, or set to 0, always return EOF. */
 	if (asma->size == 0) {
@@ -238,7 +283,7 @@ static ssize_t ashmem_read(struct file *file, char __user *buf,
 	asma->file->f_pos = *pos;
 
 out:
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 	return ret;
 }
 
@@ -247,7 +292,7 @@ static loff_t ashmem_llseek(struct file *file, loff_t offset, int origin)
 	struct ashmem_area *asma = file->private_data;
 	int ret;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	if (asma->size == 0) {
 		ret = -EINVAL;
@@ -268,7 +313,7 @@ static loff_t ashmem_llseek(struct file *file, loff_t offset, int origin)
 	file->f_pos = asma->file->f_pos;
 
 out:
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 	return ret;
 }
 
@@ -285,7 +330,7 @@ static int ashmem_mmap(struct file *file, struct vm_area_struct *vma)
 	struct ashmem_area *asma = file->private_data;
 	int ret = 0;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	/* user needs to SET_SIZE before mapping */
 	if (unlikely(!asma->size)) {
@@ -328,7 +373,7 @@ static int ashmem_mmap(struct file *file, struct vm_area_struct *vma)
 	vma->vm_flags |= VM_CAN_NONLINEAR;
 
 out:
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 	return ret;
 }
 
@@ -345,33 +390,100 @@ out:
  *
  * We approximate LRU via least-recently-unpinned, jettisoning unpinned partial
  * chunks of ashmem regions LRU-wise one-at-a-time until we hit 'nr_to_scan'
- * pages freed.
+ * pages freed.  Unpinned ranges of the same area that abut the chosen one
+ * go along with it in a single truncate.
+ *
+ * Only the lock of the area being purged is held across the truncate; an
+ * area whose lock is taken, by a pin or by an allocation from within it
+ * that got us here, is skipped rather than waited for.
  */
 static int ashmem_shrink(struct shrinker *s, struct shrink_control *sc)
 {
-	struct ashmem_range *range, *next;
+	struct ashmem_range *range, *first, *last;
+	struct ashmem_area *asma;
+	long nr_to_scan = sc->nr_to_scan;
+	unsigned long busy, ranges;
+	struct ashmem_stats *stats;
+	size_t pgstart, pgend;
 
 	/* We might recurse into filesystem code, so bail out if necessary */
-	if (sc->nr_to_scan && !(sc->gfp_mask & __GFP_FS))
+	if (nr_to_scan && !(sc->gfp_mask & __GFP_FS))
 		return -1;
-	if (!sc->nr_to_scan)
+	if (!nr_to_scan)
 		return lru_count;
 
-	mutex_lock(&ashmem_mutex);
-	list_for_each_entry_safe(range, next, &ashmem_lru_list, lru) {
-		struct inode *inode = range->asma->file->f_dentry->d_inode;
-		loff_t start = range->pgstart * PAGE_SIZE;
-		loff_t end = (range->pgend + 1) * PAGE_SIZE - 1;
-
-		vmtruncate_range(inode, start, end);
-		range->purged = ASHMEM_WAS_PURGED;
-		lru_del(range);
+	while (nr_to_scan > 0) {
+		asma = NULL;
+		busy = 0;
 
-		sc->nr_to_scan -= range_size(range);
-		if (sc->nr_to_scan <= 0)
+		spin_lock(&ashmem_lru_lock);
+		list_for_each_entry(range, &ashmem_lru_list, lru) {
+			/*
+			 * The range is on the LRU, so its area has not been
+			 * released yet, and cannot be while we hold its lock.
+			 */
+			if (mutex_trylock(&range->asma->lock)) {
+				asma = range->asma;
+				break;
+			}
+			busy++;
+		}
+		if (!asma) {
+			spin_unlock(&ashmem_lru_lock);
+			stats = &get_cpu_var(ashmem_stats);
+			stats->busy += busy;
+			put_cpu_var(ashmem_stats);
 			break;
+		}
+
+		/* unpinned_list is sorted by descending page */
+		first = last = range;
+		while (first->unpinned.prev != &asma->unpinned_list) {
+			range = list_entry(first->unpinned.prev,
+					   struct ashmem_range, unpinned);
+			if (!range_on_lru(range) ||
+			    range->pgstart != first->pgend + 1)
+				break;
+			first = range;
+		}
+		while (last->unpinned.next != &asma->unpinned_list) {
+			range = list_entry(last->unpinned.next,
+					   struct ashmem_range, unpinned);
+			if (!range_on_lru(range) ||
+			    range->pgend + 1 != last->pgstart)
+				break;
+			last = range;
+		}
+
+		ranges = 0;
+		range = first;
+		for (;;) {
+			range->purged = ASHMEM_WAS_PURGED;
+			lru_del(range);
+			ranges++;
+			if (range == last)
+				break;
+			range = list_entry(range->unpinned.next,
+					   struct ashmem_range, unpinned);
+		}
+		spin_unlock(&ashmem_lru_lock);
+
+		pgstart = last->pgstart;
+		pgend = first->pgend;
+		vmtruncate_range(asma->file->f_dentry->d_inode,
+				 (loff_t)pgstart * PAGE_SIZE,
+				 (loff_t)(pgend + 1) * PAGE_SIZE - 1);
+		mutex_unlock(&asma->lock);
+
+		nr_to_scan -= pgend - pgstart + 1;
+
+		stats = &get_cpu_var(ashmem_stats);
+		stats->purges++;
+		stats->ranges_purged += ranges;
+		stats->bytes_purged += (u64)(pgend - pgstart + 1) * PAGE_SIZE;
+		stats->busy += busy;
+		put_cpu_var(ashmem_stats);
 	}
-	mutex_unlock(&ashmem_mutex);
 
 	return lru_count;
 }
@@ -385,7 +497,7 @@ static int set_prot_mask(struct ashmem_area *asma, unsigned long prot)
 {
 	int ret = 0;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	/* the user can only remove, not add, protection bits */
 	if (unlikely((asma->prot_mask & prot) != prot)) {
@@ -400,7 +512,7 @@ static int set_prot_mask(struct ashmem_area *asma, unsigned long prot)
 	asma->prot_mask = prot;
 
 out:
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 	return ret;
 }
 
@@ -408,7 +520,7 @@ static int set_name(struct ashmem_area *asma, void __user *name)
 {
 	int ret = 0;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	/* cannot change an existing mapping's name */
 	if (unlikely(asma->file)) {
@@ -422,7 +534,7 @@ static int set_name(struct ashmem_area *asma, void __user *name)
 	asma->name[ASHMEM_FULL_NAME_LEN-1] = '\0';
 
 out:
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 
 	return ret;
 }
@@ -431,7 +543,7 @@ static int get_name(struct ashmem_area *asma, void __user *name)
 {
 	int ret = 0;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 	if (asma->name[ASHMEM_NAME_PREFIX_LEN] != '\0') {
 		size_t len;
 
@@ -448,7 +560,7 @@ static int get_name(struct ashmem_area *asma, void __user *name)
 					  sizeof(ASHMEM_NAME_DEF))))
 			ret = -EFAULT;
 	}
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
 
 	return ret;
 }
@@ -457,7 +569,7 @@ static int get_name(struct ashmem_area *asma, void __user *name)
  * ashmem_pin - pin the given ashmem region, returning whether it was
  * previously purged (ASHMEM_WAS_PURGED) or not (ASHMEM_NOT_PURGED).
  *
- * Caller must hold ashmem_mutex.
+ * Caller must hold the area's lock.
  */
 static int ashmem_pin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 {
@@ -523,7 +635,7 @@ static int ashmem_pin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 /*
  * ashmem_unpin - unpin the given range of pages. Returns zero on success.
  *
- * Caller must hold ashmem_mutex.
+ * Caller must hold the area's lock.
  */
 static int ashmem_unpin(struct ashmem_area *asma, size_t pgstart, size_t pgend)
 {
@@ -558,7 +670,7 @@ restart:
  * ashmem_get_pin_status - Returns ASHMEM_IS_UNPINNED if _any_ pages in the
  * given interval are unpinned and ASHMEM_IS_PINNED otherwise.
  *
- * Caller must hold ashmem_mutex.
+ * Caller must hold the area's lock.
  */
 static int ashmem_get_pin_status(struct ashmem_area *asma, size_t pgstart,
 				 size_t pgend)
@@ -578,9 +690,29 @@ static int ashmem_get_pin_status(struct ashmem_area *asma, size_t pgstart,
 	return ret;
 }
 
+static void ashmem_account(unsigned long cmd, ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	struct ashmem_stats *stats = &get_cpu_var(ashmem_stats);
+
+	if (cmd == ASHMEM_PIN) {
+		stats->pins++;
+		stats->pin_ns += ns;
+		if (ns > stats->pin_max_ns)
+			stats->pin_max_ns = ns;
+	} else if (cmd == ASHMEM_UNPIN) {
+		stats->unpins++;
+		stats->unpin_ns += ns;
+		if (ns > stats->unpin_max_ns)
+			stats->unpin_max_ns = ns;
+	}
+	put_cpu_var(ashmem_stats);
+}
+
 static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
 			    void __user *p)
 {
+	ktime_t start = ktime_get();
 	struct ashmem_pin pin;
 	size_t pgstart, pgend;
 	int ret = -EINVAL;
@@ -607,7 +739,7 @@ static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
 	pgstart = pin.offset / PAGE_SIZE;
 	pgend = pgstart + (pin.len / PAGE_SIZE) - 1;
 
-	mutex_lock(&ashmem_mutex);
+	mutex_lock(&asma->lock);
 
 	switch (cmd) {
 	case ASHMEM_PIN:
@@ -621,7 +753,9 @@ static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
 		break;
 	}
 
-	mutex_unlock(&ashmem_mutex);
+	mutex_unlock(&asma->lock);
+
+	ashmem_account(cmd, start);
 
 	return ret;
 }
@@ -640,10 +774,12 @@ static long ashmem_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		break;
 	case ASHMEM_SET_SIZE:
 		ret = -EINVAL;
+		mutex_lock(&asma->lock);
 		if (!asma->file) {
 			ret = 0;
 			asma->size = (size_t) arg;
 		}
+		mutex_unlock(&asma->lock);
 		break;
 	case ASHMEM_GET_SIZE:
 		ret = asma->size;
@@ -676,6 +812,55 @@ static long ashmem_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	return ret;
 }
 
+static int ashmem_stats_show(struct seq_file *m, void *v)
+{
+	struct ashmem_stats sum = { 0 };
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct ashmem_stats *stats = &per_cpu(ashmem_stats, cpu);
+
+		sum.pins += stats->pins;
+		sum.unpins += stats->unpins;
+		sum.pin_ns += stats->pin_ns;
+		sum.pin_max_ns = max(sum.pin_max_ns, stats->pin_max_ns);
+		sum.unpin_ns += stats->unpin_ns;
+		sum.unpin_max_ns = max(sum.unpin_max_ns, stats->unpin_max_ns);
+		sum.purges += stats->purges;
+		sum.ranges_purged += stats->ranges_purged;
+		sum.bytes_purged += stats->bytes_purged;
+		sum.busy += stats->busy;
+	}
+
+	seq_printf(m, "lru_pages %lu\n", lru_count);
+	seq_printf(m, "pins %lu\n", sum.pins);
+	seq_printf(m, "pin_avg_ns %llu\n",
+		   sum.pins ? div64_u64(sum.pin_ns, sum.pins) : 0);
+	seq_printf(m, "pin_max_ns %llu\n", sum.pin_max_ns);
+	seq_printf(m, "unpins %lu\n", sum.unpins);
+	seq_printf(m, "unpin_avg_ns %llu\n",
+		   sum.unpins ? div64_u64(sum.unpin_ns, sum.unpins) : 0);
+	seq_printf(m, "unpin_max_ns %llu\n", sum.unpin_max_ns);
+	seq_printf(m, "purges %lu\n", sum.purges);
+	seq_printf(m, "ranges_purged %lu\n", sum.ranges_purged);
+	seq_printf(m, "bytes_purged %llu\n", sum.bytes_purged);
+	seq_printf(m, "shrink_busy %lu\n", sum.busy);
+
+	return 0;
+}
+
+static int ashmem_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ashmem_stats_show, NULL);
+}
+
+static const struct file_operations ashmem_stats_fops = {
+	.open		= ashmem_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static struct file_operations ashmem_fops = {
 	.owner = THIS_MODULE,
 	.open = ashmem_open,
@@ -721,6 +906,9 @@ static int __init ashmem_init(void)
 
 	register_shrinker(&ashmem_shrinker);
 
+	ashmem_debugfs = debugfs_create_file("ashmem", S_IRUGO, NULL, NULL,
+					     &ashmem_stats_fops);
+
 	printk(KERN_INFO "ashmem: initialized\n");
 
 	return 0;
@@ -730,6 +918,7 @@ static void __exit ashmem_exit(void)
 {
 	int ret;
 
+	debugfs_remove(ashmem_debugfs);
 	unregister_shrinker(&ashmem_shrinker);
 
 	ret = misc_deregister(&ashmem_misc);
@@ -10,6 +10,7 @@
 #include <linux/module.h>
 #include <linux/writeback.h>
 #include <linux/device.h>
+#include <linux/math64.h>
 #include <trace/events/writeback.h>
 
 static atomic_long_t bdi_seq = ATOMIC_LONG_INIT(0);
@@ -100,6 +101,11 @@ static int bdi_debug_stats_show(struct seq_file *m, void *v)
 		   "BdiDirtied:         %10lu kB\n"
 		   "BdiWritten:         %10lu kB\n"
 		   "BdiWriteBandwidth:  %10lu kBps\n"
+		   "BdiReadLatency:     %10lu us\n"
+		   "BdiReadBandwidth:   %10lu kBps\n"
+		   "BdiReadahead:       %10lu kB\n"
+		   "BdiReadaheadHit:    %10lu kB\n"
+		   "BdiReadaheadWaste:  %10lu kB\n"
 		   "b_dirty:            %10lu\n"
 		   "b_io:               %10lu\n"
 		   "b_more_io:          %10lu\n"
@@ -113,6 +119,11 @@ static int bdi_debug_stats_show(struct seq_file *m, void *v)
 		   (unsigned long) K(bdi_stat(bdi, BDI_DIRTIED)),
 		   (unsigned long) K(bdi_stat(bdi, BDI_WRITTEN)),
 		   (unsigned long) K(bdi->write_bandwidth),
+		   bdi_read_latency(bdi),
+		   K(bdi_read_bandwidth(bdi)),
+		   (unsigned long) K(bdi_stat(bdi, BDI_READAHEAD)),
+		   (unsigned long) K(bdi_stat(bdi, BDI_READAHEAD_HIT)),
+		   (unsigned long) K(bdi_stat(bdi, BDI_READAHEAD_WASTE)),
 		   nr_dirty,
 		   nr_io,
 		   nr_more_io,
@@ -692,6 +703,10 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->write_bandwidth = INIT_BW;
 	bdi->avg_write_bandwidth = INIT_BW;
 
+	bdi->read_latency = 0;
+	bdi->read_bytes = 0;
+	bdi->read_time = 0;
+
 	err = prop_local_init_percpu(&bdi->completions);
 
 	if (err) {
@@ -704,6 +719,58 @@ err:
 }
 EXPORT_SYMBOL(bdi_init);
 
+#define BDI_READ_EWMA_SHIFT	4
+#define BDI_READ_SMALL		(16 << 10)
+#define BDI_READ_LARGE		(64 << 10)
+
+static inline void bdi_read_ewma(unsigned long *avg, unsigned long sample)
+{
+	*avg += sample - (*avg >> BDI_READ_EWMA_SHIFT);
+}
+
+/**
+ * bdi_account_read - sample a read request completed on @bdi
+ * @bdi: the backing device
+ * @bytes: size of the request
+ * @duration: jiffies from its allocation to its completion
+ *
+ * Small reads estimate the per-request latency of the device, large ones
+ * its transfer rate.  A duration in jiffies is coarse next to an eMMC
+ * read, but requests start and end at random phases of the tick, so the
+ * averages still converge on the true means.  Completions may race on
+ * another cpu; a lost sample does not matter.
+ */
+void bdi_account_read(struct backing_dev_info *bdi, unsigned int bytes,
+		      unsigned long duration)
+{
+	unsigned long us = jiffies_to_usecs(duration);
+
+	if (bytes <= BDI_READ_SMALL) {
+		bdi_read_ewma(&bdi->read_latency, us);
+	} else if (bytes >= BDI_READ_LARGE) {
+		bdi_read_ewma(&bdi->read_bytes, bytes);
+		bdi_read_ewma(&bdi->read_time, us);
+	}
+}
+
+/* Average latency of a small read, in us, 0 until sampled */
+unsigned long bdi_read_latency(struct backing_dev_info *bdi)
+{
+	return ACCESS_ONCE(bdi->read_latency) >> BDI_READ_EWMA_SHIFT;
+}
+
+/* Transfer rate of large reads, in pages per second, 0 until sampled */
+unsigned long bdi_read_bandwidth(struct backing_dev_info *bdi)
+{
+	unsigned long bytes = ACCESS_ONCE(bdi->read_bytes);
+	unsigned long time = ACCESS_ONCE(bdi->read_time);
+
+	if (!time)
+		return 0;
+
+	return div64_u64(((u64)bytes * USEC_PER_SEC) >> PAGE_SHIFT, time);
+}
+
 void bdi_destroy(struct backing_dev_info *bdi)
 {
 	int i;
@@ -0,0 +1,165 @@
+/*
+ * Contiguous Memory Allocator framework: Bitmap allocator
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License or (at your optional) any later version of the license.
+ */
+
+/*
+ * One bit per granule of the region, allocations are rounded up to
+ * whole granules and placed at the lowest free address that satisfies
+ * their alignment.  Suits regions whose buffers are all of a few fixed
+ * sizes (camera, codec frames): allocating and freeing never allocate
+ * memory for holes, and free space does not fragment in less than a
+ * granule.
+ */
+
+#define pr_fmt(fmt) "cma: bitmap: " fmt
+
+#ifdef CONFIG_CMA_DEBUG
+#  define DEBUG
+#endif
+
+#include <linux/errno.h>       /* Error numbers */
+#include <linux/slab.h>        /* kmalloc() */
+#include <linux/bitmap.h>      /* bitmap_set(), bitmap_clear() */
+#include <linux/bitops.h>      /* find_next_bit() */
+#include <linux/moduleparam.h> /* module_param() */
+
+#include <linux/cma.h>         /* CMA structures */
+
+
+/* Granule is PAGE_SIZE << order, "cma_bitmap.order" on command line */
+static unsigned int order;
+module_param(order, uint, 0444);
+MODULE_PARM_DESC(order, "Granule of the regions, in log2 of pages");
+
+
+/************************* Data Types *************************/
+
+struct cma_bm_private {
+	unsigned long *bitmap;
+	unsigned long nbits;
+	unsigned int shift;	/* log2 of the granule in bytes */
+};
+
+
+/************************* Device API *************************/
+
+int cma_bm_init(struct cma_region *reg)
+{
+	struct cma_bm_private *prv;
+	unsigned int shift = PAGE_SHIFT + order;
+
+	/* A granule must divide the start of the region */
+	if (reg->start && __ffs(reg->start) < shift)
+		shift = __ffs(reg->start);
+
+	prv = kzalloc(sizeof *prv, GFP_KERNEL);
+	if (unlikely(!prv))
+		return -ENOMEM;
+
+	prv->shift = shift;
+	prv->nbits = reg->size >> shift;
+	prv->bitmap = kzalloc(BITS_TO_LONGS(prv->nbits) * sizeof(long),
+			      GFP_KERNEL);
+	if (unlikely(!prv->bitmap)) {
+		kfree(prv);
+		return -ENOMEM;
+	}
+
+	pr_debug("%s: %lu granules of %lu bytes\n", reg->name ?: "(private)",
+		 prv->nbits, 1UL << shift);
+
+	reg->private_data = prv;
+	return 0;
+}
+
+void cma_bm_cleanup(struct cma_region *reg)
+{
+	struct cma_bm_private *prv = reg->private_data;
+
+	WARN_ON(find_first_bit(prv->bitmap, prv->nbits) < prv->nbits);
+
+	kfree(prv->bitmap);
+	kfree(prv);
+}
+
+/*
+ * First run of @nr clear bits whose index plus @off is a multiple of
+ * @mask + 1.  Returns an index past the bitmap if there is none.
+ */
+static unsigned long __cma_bm_find(struct cma_bm_private *prv,
+				   unsigned long nr, unsigned long mask,
+				   unsigned long off)
+{
+	unsigned long index, end, i, start = 0;
+
+	for (;;) {
+		index = find_next_zero_bit(prv->bitmap, prv->nbits, start);
+		index = ((index + off + mask) & ~mask) - off;
+
+		end = index + nr;
+		if (end > prv->nbits)
+			return prv->nbits;
+
+		i = find_next_bit(prv->bitmap, end, index);
+		if (i >= end)
+			return index;
+		start = i + 1;
+	}
+}
+
+struct cma_chunk *cma_bm_alloc(struct cma_region *reg,
+			       size_t size, dma_addr_t alignment)
+{
+	struct cma_bm_private *prv = reg->private_data;
+	unsigned long nr, mask, index;
+	struct cma_chunk *chunk;
+
+	alignment = max_t(dma_addr_t, alignment, 1UL << prv->shift);
+	nr = (size + (1UL << prv->shift) - 1) >> prv->shift;
+	mask = (alignment >> prv->shift) - 1;
+
+	index = __cma_bm_find(prv, nr, mask, (reg->start >> prv->shift) & mask);
+	if (index >= prv->nbits)
+		return NULL;
+
+	chunk = kmalloc(sizeof *chunk, GFP_KERNEL);
+	if (unlikely(!chunk))
+		return NULL;
+
+	bitmap_set(prv->bitmap, index, nr);
+
+	chunk->start = reg->start + ((dma_addr_t)index << prv->shift);
+	chunk->size  = nr << prv->shift;
+	chunk->reg   = reg;
+
+	return chunk;
+}
+
+void cma_bm_free(struct cma_chunk *chunk)
+{
+	struct cma_bm_private *prv = chunk->reg->private_data;
+	unsigned long index = (chunk->start - chunk->reg->start) >> prv->shift;
+
+	bitmap_clear(prv->bitmap, index, chunk->size >> prv->shift);
+	kfree(chunk);
+}
+
+
+/************************* Register *************************/
+static int cma_bm_module_init(void)
+{
+	static struct cma_allocator alloc = {
+		.name    = "bitmap",
+		.init    = cma_bm_init,
+		.cleanup = cma_bm_cleanup,
+		.alloc   = cma_bm_alloc,
+		.free    = cma_bm_free,
+	};
+	return cma_allocator_register(&alloc);
+}
+module_init(cma_bm_module_init);
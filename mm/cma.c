@@ -33,13 +33,28 @@
 #include <linux/mutex.h>       /* mutex */
 #include <linux/slab.h>        /* kmalloc() */
 #include <linux/string.h>      /* str*() */
+#include <linux/gfp.h>         /* alloc_contig_range() */
+#include <linux/ktime.h>       /* ktime_get() */
+#include <linux/pfn.h>         /* PFN_UP(), PFN_DOWN() */
+#include <linux/debugfs.h>     /* debugfs_create_file() */
+#include <linux/seq_file.h>    /* seq_printf() */
+#include <linux/math64.h>      /* div_u64() */
+#include <linux/swap.h>        /* lru_add_drain_all() */
+#include <linux/workqueue.h>   /* alloc_workqueue() */
 
 #include <linux/cma.h>
 #include <linux/vmalloc.h>
 
+#if defined CONFIG_DMA_CMA && defined CONFIG_ARM
+#  include <asm/cacheflush.h>  /* dmac_flush_range() */
+#  include <asm/outercache.h>  /* outer_flush_range() */
+#endif
+
 /*
  * Protects cma_regions, cma_allocators, cma_map, cma_map_length,
- * cma_kobj, cma_sysfs_regions and cma_chunks_by_start.
+ * cma_kobj, cma_sysfs_regions and attaching allocators to regions.
+ * Allocations and frees only hold it to look the regions up and then
+ * run under the lock of the region, which nests inside cma_mutex.
  */
 static DEFINE_MUTEX(cma_mutex);
 
@@ -307,6 +322,13 @@ int __must_check cma_region_register(struct cma_region *reg)
 	reg->private_data = NULL;
 	reg->registered = 0;
 	reg->free_space = reg->size;
+	reg->chunks = RB_ROOT;
+	mutex_init(&reg->lock);
+#ifdef CONFIG_DMA_CMA
+	reg->lend_start_pfn = 0;
+	reg->lend_end_pfn = 0;
+	memset(&reg->lend_stats, 0, sizeof reg->lend_stats);
+#endif
 
 	/* Copy name and alloc_name */
 	name = reg->name;
@@ -437,13 +459,15 @@ int cma_allocator_register(struct cma_allocator *alloc)
 	cma_foreach_region(reg) {
 		if (reg->alloc)
 			continue;
-		if (reg->alloc_name
-		  ? alloc->name && !strcmp(alloc->name, reg->alloc_name)
-		  : (!reg->used && first))
+		if (!(reg->alloc_name
+		      ? alloc->name && !strcmp(alloc->name, reg->alloc_name)
+		      : (!reg->used && first)))
 			continue;
 
+		mutex_lock(&reg->lock);
 		reg->alloc = alloc;
 		__cma_region_attach_alloc(reg);
+		mutex_unlock(&reg->lock);
 	}
 
 	mutex_unlock(&cma_mutex);
@@ -582,6 +606,324 @@ void __init cma_early_regions_reserve(int (*reserve)(struct cma_region *reg))
 }
 
 
+/************************* Lending *************************/
+
+#ifdef CONFIG_DMA_CMA
+
+/*
+ * lend-attr ::= [ REG-NAME [ ',' lend-attr ] ] | '*'
+ *
+ * Regions whose space is given to the page allocator while it is not
+ * allocated, see Documentation/contiguous-memory.txt for details.
+ */
+static const char *cma_lend __initdata;
+
+#define __cma_lend_stat_inc(reg, item)	(++(reg)->lend_stats.item)
+
+/*
+ * Lent parts, and the slices chunks are taken back in, are made of
+ * whole MAX_ORDER blocks: the buddy allocator never merges pages across
+ * their edges and alloc_contig_range() isolates each slice on its own.
+ */
+#define CMA_LEND_ALIGN	max_t(unsigned long, MAX_ORDER_NR_PAGES, \
+			      pageblock_nr_pages)
+
+/* Takes back the slices of large chunks on several cpus at once */
+static struct workqueue_struct *cma_reclaim_wq;
+
+static int __init cma_lend_param(char *param)
+{
+	pr_debug("param: lend: %s\n", param);
+	cma_lend = param;
+	return 0;
+}
+early_param("cma.lend", cma_lend_param);
+
+static bool __init cma_lend_named(const char *name)
+{
+	const char *s = cma_lend;
+	size_t n;
+
+	if (!s || !name)
+		return false;
+	if (!strcmp(s, "*"))
+		return true;
+
+	n = strlen(name);
+	while (*s) {
+		if (!strncmp(s, name, n) && (s[n] == ',' || !s[n]))
+			return true;
+		s = strchr(s, ',');
+		if (!s)
+			break;
+		++s;
+	}
+
+	return false;
+}
+
+/*
+ * Gives the pageblocks fully inside the region to the page allocator
+ * as MIGRATE_CMA.  The lent part is aligned to MAX_ORDER pages too, so
+ * the buddy allocator never merges its pages with those outside.
+ */
+static void __init __cma_region_lend(struct cma_region *reg)
+{
+	const unsigned long align = CMA_LEND_ALIGN;
+	unsigned long start, end, pfn;
+	struct zone *zone;
+
+	if (!reg->lend && !cma_lend_named(reg->name))
+		return;
+
+	if (reg->nolend) {
+		pr_warn("%s: region may not be lent\n",
+			reg->name ?: "(private)");
+		return;
+	}
+
+	start = ALIGN(PFN_UP(reg->start), align);
+	end = round_down(PFN_DOWN(reg->start + reg->size), align);
+	if (start >= end) {
+		pr_warn("%s: region too small to be lent\n",
+			reg->name ?: "(private)");
+		return;
+	}
+
+	/*
+	 * Chunks taken back are flushed through the linear mapping and
+	 * alloc_contig_range() works on a single zone.
+	 */
+	zone = page_zone(pfn_to_page(start));
+	for (pfn = start; pfn < end; pfn += pageblock_nr_pages) {
+		if (!pfn_valid(pfn) || page_zone(pfn_to_page(pfn)) != zone ||
+		    PageHighMem(pfn_to_page(pfn))) {
+			pr_warn("%s: region not in a single lowmem zone, not lent\n",
+				reg->name ?: "(private)");
+			return;
+		}
+	}
+
+	for (pfn = start; pfn < end; pfn += pageblock_nr_pages)
+		if (init_cma_reserved_pageblock(pfn_to_page(pfn)) < 0)
+			break;
+
+	if (pfn == start) {
+		pr_warn("%s: too many lent regions\n",
+			reg->name ?: "(private)");
+		return;
+	}
+
+	reg->lend = 1;
+	reg->lend_start_pfn = start;
+	reg->lend_end_pfn = pfn;
+
+	/* Without it chunks are taken back on the allocating cpu alone */
+	if (!cma_reclaim_wq)
+		cma_reclaim_wq = alloc_workqueue("cma_reclaim", WQ_UNBOUND, 0);
+
+	pr_info("%s: lent %luKiB to the page allocator\n",
+		reg->name ?: "(private)",
+		(pfn - start) << (PAGE_SHIFT - 10));
+}
+
+/* Makes sure no dirty line of the page allocator users overwrites a chunk */
+static void __cma_lend_flush(unsigned long start, unsigned long end)
+{
+#ifdef CONFIG_ARM
+	dmac_flush_range(pfn_to_kaddr(start), pfn_to_kaddr(end));
+	outer_flush_range(PFN_PHYS(start), PFN_PHYS(end));
+#endif
+}
+
+struct cma_reclaim_work {
+	struct work_struct work;
+	unsigned long start, end;
+	int ret;
+};
+
+static void cma_reclaim_work_fn(struct work_struct *work)
+{
+	struct cma_reclaim_work *w =
+		container_of(work, struct cma_reclaim_work, work);
+
+	w->ret = alloc_contig_range(w->start, w->end, MIGRATE_CMA);
+}
+
+/*
+ * Takes [start, end) back in MAX_ORDER aligned slices, one per online
+ * cpu, the first one in the caller's context.  Each slice is isolated
+ * and migrated independently, on failure those taken back are lent
+ * again.
+ */
+static int __cma_reclaim_range(unsigned long start, unsigned long end)
+{
+	unsigned long base = round_down(start, CMA_LEND_ALIGN), slice;
+	struct cma_reclaim_work *works;
+	unsigned int i, nr;
+	int ret = 0;
+
+	/*
+	 * Pages still in the per-cpu LRU pagevecs cannot be isolated,
+	 * put them on the LRU once for all slices
+	 */
+	lru_add_drain_all();
+
+	slice = ALIGN(DIV_ROUND_UP(end - base, num_online_cpus()),
+		      CMA_LEND_ALIGN);
+	nr = DIV_ROUND_UP(end - base, slice);
+	if (nr < 2 || !cma_reclaim_wq)
+		return alloc_contig_range(start, end, MIGRATE_CMA);
+
+	works = kcalloc(nr, sizeof *works, GFP_KERNEL);
+	if (!works)
+		return alloc_contig_range(start, end, MIGRATE_CMA);
+
+	for (i = 0; i < nr; ++i) {
+		works[i].start = max(start, base + i * slice);
+		works[i].end = min(end, base + (i + 1) * slice);
+		INIT_WORK(&works[i].work, cma_reclaim_work_fn);
+		if (i)
+			queue_work(cma_reclaim_wq, &works[i].work);
+	}
+
+	cma_reclaim_work_fn(&works[0].work);
+
+	for (i = 0; i < nr; ++i) {
+		if (i)
+			flush_work(&works[i].work);
+		if (works[i].ret && !ret)
+			ret = works[i].ret;
+	}
+
+	if (ret)
+		for (i = 0; i < nr; ++i)
+			if (!works[i].ret)
+				free_contig_range(works[i].start,
+						  works[i].end - works[i].start);
+
+	kfree(works);
+	return ret;
+}
+
+/*
+ * Takes the lent part of a new chunk back from the page allocator,
+ * migrating whatever it has put there.  Call with the region's lock
+ * held.
+ */
+static int __cma_chunk_reclaim(struct cma_chunk *chunk)
+{
+	struct cma_region *reg = chunk->reg;
+	struct cma_lend_stats *stats = &reg->lend_stats;
+	unsigned long start, end;
+	ktime_t t;
+	u64 ns;
+	int ret;
+
+	start = max(PFN_DOWN(chunk->start), reg->lend_start_pfn);
+	end = min(PFN_DOWN(chunk->start + chunk->size), reg->lend_end_pfn);
+	if (start >= end)
+		return 0;
+
+	t = ktime_get();
+	ret = __cma_reclaim_range(start, end);
+	ns = ktime_to_ns(ktime_sub(ktime_get(), t));
+
+	stats->reclaim_ns += ns;
+	if (ns > stats->reclaim_max_ns)
+		stats->reclaim_max_ns = ns;
+
+	if (ret) {
+		++stats->reclaim_failed;
+		pr_debug("%s: unable to take back %p@%p: %d\n",
+			 reg->name ?: "(private)", (void *)chunk->size,
+			 (void *)chunk->start, ret);
+		return ret;
+	}
+
+	++stats->reclaims;
+	stats->reclaim_pages += end - start;
+	__cma_lend_flush(start, end);
+
+	return 0;
+}
+
+/* Lends the lent part of a freed chunk again, with the region's lock held */
+static void __cma_chunk_lend(struct cma_chunk *chunk)
+{
+	struct cma_region *reg = chunk->reg;
+	unsigned long start, end;
+
+	start = max(PFN_DOWN(chunk->start), reg->lend_start_pfn);
+	end = min(PFN_DOWN(chunk->start + chunk->size), reg->lend_end_pfn);
+	if (start < end)
+		free_contig_range(start, end - start);
+}
+
+#ifdef CONFIG_DEBUG_FS
+
+static int cma_lend_stats_show(struct seq_file *s, void *unused)
+{
+	struct cma_region *reg;
+
+	seq_printf(s, "%-16s %8s %8s %8s %8s %10s %10s %8s\n",
+		   "region", "lent_kB", "reclaims", "pages", "failed",
+		   "time_us", "max_us", "nomem");
+
+	mutex_lock(&cma_mutex);
+	cma_foreach_region(reg) {
+		struct cma_lend_stats *stats = &reg->lend_stats;
+
+		mutex_lock(&reg->lock);
+		seq_printf(s, "%-16s %8lu %8lu %8lu %8lu %10llu %10llu %8lu\n",
+			   reg->name ?: "(private)",
+			   (reg->lend_end_pfn - reg->lend_start_pfn) <<
+				(PAGE_SHIFT - 10),
+			   stats->reclaims, stats->reclaim_pages,
+			   stats->reclaim_failed,
+			   div_u64(stats->reclaim_ns, NSEC_PER_USEC),
+			   div_u64(stats->reclaim_max_ns, NSEC_PER_USEC),
+			   stats->alloc_failed);
+		mutex_unlock(&reg->lock);
+	}
+	mutex_unlock(&cma_mutex);
+
+	return 0;
+}
+
+static int cma_lend_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_lend_stats_show, NULL);
+}
+
+static const struct file_operations cma_lend_stats_fops = {
+	.open		= cma_lend_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init cma_lend_debugfs_init(void)
+{
+	debugfs_create_file("cma_lend", S_IRUGO, NULL, NULL,
+			    &cma_lend_stats_fops);
+	return 0;
+}
+late_initcall(cma_lend_debugfs_init);
+
+#endif
+
+#else
+
+#define __cma_lend_stat_inc(reg, item)	do { } while (0)
+
+static inline void __cma_region_lend(struct cma_region *reg) { }
+static inline int __cma_chunk_reclaim(struct cma_chunk *chunk) { return 0; }
+static inline void __cma_chunk_lend(struct cma_chunk *chunk) { }
+
+#endif
+
+
 static int __init cma_init(void)
 {
 	struct cma_region *reg, *n;
@@ -607,8 +949,8 @@ static int __init cma_init(void)
 		 * cma_early_region_register() it's caller's
 		 * responsibility to do something about it.
 		 */
-		if (reg->reserved && cma_region_register(reg) < 0)
-			/* ignore error */;
+		if (reg->reserved && cma_region_register(reg) >= 0)
+			__cma_region_lend(reg);
 	}
 
 	INIT_LIST_HEAD(&cma_early_regions);
@@ -898,7 +1240,9 @@ cma_sysfs_region_store(struct kobject *kobj, struct attribute *attr,
 	int ret;
 
 	mutex_lock(&cma_mutex);
+	mutex_lock(&reg->lock);
 	ret = rattr->store(reg, buf);
+	mutex_unlock(&reg->lock);
 	mutex_unlock(&cma_mutex);
 
 	return ret < 0 ? ret : count;
@@ -950,15 +1294,13 @@ static void __cma_sysfs_region_add(struct cma_region *reg)
 
 /************************* Chunks *************************/
 
-/* All chunks sorted by start address. */
-static struct rb_root cma_chunks_by_start;
-
-static struct cma_chunk *__must_check __cma_chunk_find(dma_addr_t addr)
+static struct cma_chunk *__must_check
+__cma_chunk_find(struct cma_region *reg, dma_addr_t addr)
 {
 	struct cma_chunk *chunk;
 	struct rb_node *n;
 
-	for (n = cma_chunks_by_start.rb_node; n; ) {
+	for (n = reg->chunks.rb_node; n; ) {
 		chunk = rb_entry(n, struct cma_chunk, by_start);
 		if (addr < chunk->start)
 			n = n->rb_left;
@@ -976,7 +1318,7 @@ static int __must_check __cma_chunk_insert(struct cma_chunk *chunk)
 	struct rb_node **new, *parent = NULL;
 	typeof(chunk->start) addr = chunk->start;
 
-	for (new = &cma_chunks_by_start.rb_node; *new; ) {
+	for (new = &chunk->reg->chunks.rb_node; *new; ) {
 		struct cma_chunk *c =
 			container_of(*new, struct cma_chunk, by_start);
 
@@ -999,14 +1341,16 @@ static int __must_check __cma_chunk_insert(struct cma_chunk *chunk)
 	}
 
 	rb_link_node(&chunk->by_start, parent, new);
-	rb_insert_color(&chunk->by_start, &cma_chunks_by_start);
+	rb_insert_color(&chunk->by_start, &chunk->reg->chunks);
 
 	return 0;
 }
 
 static void __cma_chunk_free(struct cma_chunk *chunk)
 {
-	rb_erase(&chunk->by_start, &cma_chunks_by_start);
+	rb_erase(&chunk->by_start, &chunk->reg->chunks);
+
+	__cma_chunk_lend(chunk);
 
 	chunk->reg->free_space += chunk->size;
 	--chunk->reg->users;
@@ -1020,41 +1364,68 @@ static void __cma_chunk_free(struct cma_chunk *chunk)
 static const char *__must_check
 __cma_where_from(const struct device *dev, const char *type);
 
+/* Most regions a single allocation request may be served from */
+#define CMA_FROM_MAX	16
+
 
 /* Allocate. */
 
+/*
+ * Makes sure the region has an allocator attached.  Call with
+ * cma_mutex held.
+ */
+static int __cma_region_prepare(struct cma_region *reg)
+{
+	if (!reg->alloc && !reg->used) {
+		mutex_lock(&reg->lock);
+		__cma_region_attach_alloc(reg);
+		mutex_unlock(&reg->lock);
+	}
+
+	return reg->alloc ? 0 : -ENOMEM;
+}
+
+/* Call with the region's lock held. */
 static dma_addr_t __must_check
 __cma_alloc_from_region(struct cma_region *reg,
 			size_t size, dma_addr_t alignment)
 {
 	struct cma_chunk *chunk;
+	int ret;
 
 	pr_debug("allocate %p/%p from %s\n",
-		 (void *)size, (void *)alignment,
-		 reg ? reg->name ?: "(private)" : "(null)");
+		 (void *)size, (void *)alignment, reg->name ?: "(private)");
 
-	if (!reg || reg->free_space < size)
+	if (reg->free_space < size) {
+		__cma_lend_stat_inc(reg, alloc_failed);
 		return -ENOMEM;
-
-	if (!reg->alloc) {
-		if (!reg->used)
-			__cma_region_attach_alloc(reg);
-		if (!reg->alloc)
-			return -ENOMEM;
 	}
 
+	/* The allocator may have been detached since it was looked up */
+	if (!reg->alloc)
+		return -ENOMEM;
+
 	chunk = reg->alloc->alloc(reg, size, alignment);
-	if (!chunk)
+	if (!chunk) {
+		__cma_lend_stat_inc(reg, alloc_failed);
 		return -ENOMEM;
+	}
+
+	chunk->reg = reg;
+	ret = __cma_chunk_reclaim(chunk);
+	if (ret) {
+		__cma_lend_stat_inc(reg, alloc_failed);
+		reg->alloc->free(chunk);
+		return ret;
+	}
 
 	if (unlikely(__cma_chunk_insert(chunk) < 0)) {
 		/* We should *never* be here. */
-		chunk->reg->alloc->free(chunk);
-		kfree(chunk);
+		__cma_chunk_lend(chunk);
+		reg->alloc->free(chunk);
 		return -EADDRINUSE;
 	}
 
-	chunk->reg = reg;
 	++reg->users;
 	reg->free_space -= chunk->size;
 	pr_debug("allocated at %p\n", (void *)chunk->start);
@@ -1066,6 +1437,7 @@ cma_alloc_from_region(struct cma_region *reg,
 		      size_t size, dma_addr_t alignment)
 {
 	dma_addr_t addr;
+	int ret;
 
 	pr_debug("allocate %p/%p from %s\n",
 		 (void *)size, (void *)alignment,
@@ -1075,13 +1447,15 @@ cma_alloc_from_region(struct cma_region *reg,
 		return -EINVAL;
 
 	mutex_lock(&cma_mutex);
-
-	addr = reg->registered ?
-		__cma_alloc_from_region(reg, PAGE_ALIGN(size),
-					max(alignment, (dma_addr_t)PAGE_SIZE)) :
-		-EINVAL;
-
+	ret = reg->registered ? __cma_region_prepare(reg) : -EINVAL;
 	mutex_unlock(&cma_mutex);
+	if (ret)
+		return ret;
+
+	mutex_lock(&reg->lock);
+	addr = __cma_alloc_from_region(reg, PAGE_ALIGN(size),
+				       max(alignment, (dma_addr_t)PAGE_SIZE));
+	mutex_unlock(&reg->lock);
 
 	return addr;
 }
@@ -1091,7 +1465,8 @@ dma_addr_t __must_check
 __cma_alloc(const struct device *dev, const char *type,
 	    dma_addr_t size, dma_addr_t alignment)
 {
-	struct cma_region *reg;
+	struct cma_region *regs[CMA_FROM_MAX], *reg;
+	unsigned int i, n = 0;
 	const char *from;
 	dma_addr_t addr;
 
@@ -1109,31 +1484,40 @@ __cma_alloc(const struct device *dev, const char *type,
 	if (!IS_ALIGNED(size, alignment))
 		size = ALIGN(size, alignment);
 
+	/*
+	 * Only the look up is done under cma_mutex, so allocations
+	 * from different regions, and the page migration they may
+	 * involve, run in parallel.
+	 */
 	mutex_lock(&cma_mutex);
 
 	from = __cma_where_from(dev, type);
 	if (unlikely(IS_ERR(from))) {
-		addr = PTR_ERR(from);
-		goto done;
+		mutex_unlock(&cma_mutex);
+		return PTR_ERR(from);
 	}
 
 	pr_debug("allocate %p/%p from one of %s\n",
 		 (void *)size, (void *)alignment, from);
 
-	while (*from && *from != ';') {
+	while (*from && *from != ';' && n < CMA_FROM_MAX) {
 		reg = __cma_region_find(&from);
-		addr = __cma_alloc_from_region(reg, size, alignment);
-		if (!IS_ERR_VALUE(addr))
-			goto done;
+		if (reg && !__cma_region_prepare(reg))
+			regs[n++] = reg;
 	}
 
-	pr_debug("not enough memory\n");
-	addr = -ENOMEM;
-
-done:
 	mutex_unlock(&cma_mutex);
 
-	return addr;
+	for (i = 0; i < n; ++i) {
+		mutex_lock(&regs[i]->lock);
+		addr = __cma_alloc_from_region(regs[i], size, alignment);
+		mutex_unlock(&regs[i]->lock);
+		if (!IS_ERR_VALUE(addr))
+			return addr;
+	}
+
+	pr_debug("not enough memory\n");
+	return -ENOMEM;
 }
 EXPORT_SYMBOL_GPL(__cma_alloc);
 
@@ -1220,29 +1604,41 @@ EXPORT_SYMBOL_GPL(__cma_info);
 
 
 /* Freeing. */
-int cma_free(dma_addr_t addr)
+
+/* Call with cma_mutex held. */
+static struct cma_region *__must_check __cma_region_find_addr(dma_addr_t addr)
 {
-	struct cma_chunk *c;
-	int ret;
+	struct cma_region *reg;
 
-	mutex_lock(&cma_mutex);
+	cma_foreach_region(reg)
+		if (addr >= reg->start && addr - reg->start < reg->size)
+			return reg;
 
-	c = __cma_chunk_find(addr);
+	return NULL;
+}
 
-	if (c) {
-		__cma_chunk_free(c);
-		ret = 0;
-	} else {
-		ret = -ENOENT;
-	}
+int cma_free(dma_addr_t addr)
+{
+	struct cma_region *reg;
+	struct cma_chunk *c = NULL;
 
+	mutex_lock(&cma_mutex);
+	reg = __cma_region_find_addr(addr);
 	mutex_unlock(&cma_mutex);
 
+	if (reg) {
+		mutex_lock(&reg->lock);
+		c = __cma_chunk_find(reg, addr);
+		if (c)
+			__cma_chunk_free(c);
+		mutex_unlock(&reg->lock);
+	}
+
 	if (c)
 		pr_debug("free(%p): freed\n", (void *)addr);
 	else
 		pr_err("free(%p): not found\n", (void *)addr);
-	return ret;
+	return c ? 0 : -ENOENT;
 }
 EXPORT_SYMBOL_GPL(cma_free);
 
@@ -0,0 +1,183 @@
+/* linux/mm/cma_test.c
+ *
+ * Latency of CMA allocations while the memory of lent regions is in
+ * use, as at camera start-up.  Before every allocation the writing task
+ * faults in pressure_mb of anonymous memory, which the page allocator
+ * places in lent regions first, so the allocation has to migrate it.
+ *
+ * The test runs in the context of the task writing to
+ * /sys/kernel/debug/cma_test, the anonymous memory is mapped in it.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/errno.h>
+#include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/test_trigger.h>
+#include <linux/uaccess.h>
+#include <linux/cma.h>
+
+#include <asm/sizes.h>
+
+static char *regions;
+module_param(regions, charp, S_IRUGO);
+MODULE_PARM_DESC(regions, "Comma separated regions to allocate from");
+
+static unsigned int size = SZ_8M;
+module_param(size, uint, S_IRUGO);
+MODULE_PARM_DESC(size, "Bytes per allocation");
+
+static unsigned int count = 100;
+module_param(count, uint, S_IRUGO);
+MODULE_PARM_DESC(count, "Allocations timed");
+
+static unsigned int pressure_mb = 64;
+module_param(pressure_mb, uint, S_IRUGO);
+MODULE_PARM_DESC(pressure_mb, "Megabytes of anonymous memory faulted in "
+		 "before each allocation");
+
+static int cma_test_cmp(const void *a, const void *b)
+{
+	const u64 *x = a, *y = b;
+
+	return *x < *y ? -1 : *x > *y;
+}
+
+/* The nearest rank percentile of n sorted latencies, in us */
+static u64 cma_test_pct(const u64 *ns, unsigned int n, unsigned int pct)
+{
+	return div_u64(ns[DIV_ROUND_UP(n * pct, 100) - 1], NSEC_PER_USEC);
+}
+
+static void cma_test_report(const char *what, u64 *ns, unsigned int n)
+{
+	sort(ns, n, sizeof *ns, cma_test_cmp, NULL);
+
+	printk(KERN_INFO "%s: %u %llu %llu %llu %llu %llu\n", what, n,
+	       div_u64(ns[0], NSEC_PER_USEC), cma_test_pct(ns, n, 50),
+	       cma_test_pct(ns, n, 90), cma_test_pct(ns, n, 99),
+	       div_u64(ns[n - 1], NSEC_PER_USEC));
+}
+
+/* Maps and dirties pressure_mb of anonymous memory */
+static unsigned long cma_test_pressure(void)
+{
+	unsigned long len = (unsigned long)pressure_mb << 20, addr;
+
+	down_write(&current->mm->mmap_sem);
+	addr = do_mmap(NULL, 0, len, PROT_READ | PROT_WRITE,
+		       MAP_PRIVATE | MAP_ANONYMOUS, 0);
+	up_write(&current->mm->mmap_sem);
+	if (IS_ERR_VALUE(addr))
+		return addr;
+
+	if (clear_user((void __user *)addr, len)) {
+		down_write(&current->mm->mmap_sem);
+		do_munmap(current->mm, addr, len);
+		up_write(&current->mm->mmap_sem);
+		return -EFAULT;
+	}
+
+	return addr;
+}
+
+static void cma_test_release(unsigned long addr)
+{
+	down_write(&current->mm->mmap_sem);
+	do_munmap(current->mm, addr, (unsigned long)pressure_mb << 20);
+	up_write(&current->mm->mmap_sem);
+}
+
+static int cma_test_run(void)
+{
+	unsigned int i, done = 0, failed = 0;
+	unsigned long addr = 0;
+	u64 *alloc_ns, *free_ns;
+	dma_addr_t chunk;
+	ktime_t start;
+	int err = 0;
+
+	if (!regions || !size || !count)
+		return -EINVAL;
+
+	alloc_ns = kmalloc(count * sizeof *alloc_ns, GFP_KERNEL);
+	free_ns = kmalloc(count * sizeof *free_ns, GFP_KERNEL);
+	if (!alloc_ns || !free_ns) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++) {
+		/* fresh pages, so they land in the lent regions again */
+		if (pressure_mb) {
+			addr = cma_test_pressure();
+			if (IS_ERR_VALUE(addr)) {
+				err = addr;
+				break;
+			}
+		}
+
+		start = ktime_get();
+		chunk = cma_alloc_from(regions, size, 0);
+		alloc_ns[done] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		if (!IS_ERR_VALUE(chunk)) {
+			start = ktime_get();
+			cma_free(chunk);
+			free_ns[done] = ktime_to_ns(ktime_sub(ktime_get(),
+							      start));
+			done++;
+		} else {
+			failed++;
+		}
+
+		if (pressure_mb)
+			cma_test_release(addr);
+
+		if (fatal_signal_pending(current)) {
+			err = -EINTR;
+			break;
+		}
+	}
+	if (err || !done)
+		goto out;
+
+	printk(KERN_INFO "## cma test (us, %s, %uKB, pressure %uMB, "
+	       "%u failed): n min p50 p90 p99 max\n", regions, size / SZ_1K,
+	       pressure_mb, failed);
+	cma_test_report("alloc", alloc_ns, done);
+	cma_test_report("free", free_ns, done);
+out:
+	kfree(free_ns);
+	kfree(alloc_ns);
+
+	return err ? err : done ? 0 : -ENOMEM;
+}
+
+static DEFINE_TEST_TRIGGER(cma_test_trigger, "cma_test", cma_test_run);
+
+static int __init cma_test_init(void)
+{
+	return test_trigger_register(&cma_test_trigger);
+}
+module_init(cma_test_init);
+
+static void __exit cma_test_exit(void)
+{
+	test_trigger_unregister(&cma_test_trigger);
+}
+module_exit(cma_test_exit);
+MODULE_LICENSE("GPL");
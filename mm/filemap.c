@@ -129,6 +129,9 @@ void __delete_from_page_cache(struct page *page)
 	else
 		cleancache_flush_page(mapping, page);
 
+	if (PageRaUnused(page) && TestClearPageRaUnused(page))
+		__inc_bdi_stat(mapping->backing_dev_info, BDI_READAHEAD_WASTE);
+
 	radix_tree_delete(&mapping->page_tree, page->index);
 	page->mapping = NULL;
 	mapping->nrpages--;
@@ -1689,6 +1692,7 @@ retry_find:
 		return VM_FAULT_SIGBUS;
 	}
 
+	page_ra_used(page);
 	vmf->page = page;
 	return ret | VM_FAULT_LOCKED;
 
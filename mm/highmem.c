@@ -68,6 +68,8 @@ unsigned int nr_free_highpages (void)
 }
 
 static int pkmap_count[LAST_PKMAP];
+/* kmap()ed again since the last flush, spared by the next one */
+static DECLARE_BITMAP(pkmap_referenced, LAST_PKMAP);
 static unsigned int last_pkmap_nr;
 static  __cacheline_aligned_in_smp DEFINE_SPINLOCK(kmap_lock);
 
@@ -94,13 +96,31 @@ static DECLARE_WAIT_QUEUE_HEAD(pkmap_map_wait);
 		do { spin_unlock(&kmap_lock); (void)(flags); } while (0)
 #endif
 
-static void flush_all_zero_pkmaps(void)
+/*
+ * Unused mappings that were kmap()ed again since the previous flush get
+ * a second chance, so pages mapped over and over (file data, zram pages)
+ * keep their address across a wrap of last_pkmap_nr instead of being
+ * remapped and flushed every round.  Unless that would leave fewer than
+ * PKMAP_MIN_FREE slots for map_new_virtual(), then all of them go.
+ */
+#define PKMAP_MIN_FREE		(LAST_PKMAP / 8)
+
+static void flush_all_zero_pkmaps(bool force)
 {
-	int i;
-	int need_flush = 0;
+	int i, lo = LAST_PKMAP, hi = -1;
+	int unused = 0;
 
 	flush_cache_kmaps();
 
+	if (!force) {
+		for (i = 0; i < LAST_PKMAP; i++)
+			if (pkmap_count[i] == 1 &&
+			    !test_bit(i, pkmap_referenced))
+				unused++;
+		force = unused < PKMAP_MIN_FREE;
+	}
+
+	unused = 0;
 	for (i = 0; i < LAST_PKMAP; i++) {
 		struct page *page;
 
@@ -112,6 +132,8 @@ static void flush_all_zero_pkmaps(void)
 		 */
 		if (pkmap_count[i] != 1)
 			continue;
+		if (__test_and_clear_bit(i, pkmap_referenced) && !force)
+			continue;
 		pkmap_count[i] = 0;
 
 		/* sanity check */
@@ -129,10 +151,18 @@ static void flush_all_zero_pkmaps(void)
 			  &pkmap_page_table[i]);
 
 		set_page_address(page, NULL);
-		need_flush = 1;
+		if (i < lo)
+			lo = i;
+		hi = i;
+		unused++;
 	}
-	if (need_flush)
-		flush_tlb_kernel_range(PKMAP_ADDR(0), PKMAP_ADDR(LAST_PKMAP));
+	if (hi < 0)
+		return;
+
+	/* just the span unmapped, the range is flushed page by page */
+	flush_tlb_kernel_range(PKMAP_ADDR(lo), PKMAP_ADDR(hi + 1));
+	count_vm_event(KMAP_FLUSH);
+	count_vm_events(KMAP_FLUSH_PAGES, unused);
 }
 
 /**
@@ -141,7 +171,7 @@ static void flush_all_zero_pkmaps(void)
 void kmap_flush_unused(void)
 {
 	lock_kmap();
-	flush_all_zero_pkmaps();
+	flush_all_zero_pkmaps(true);
 	unlock_kmap();
 }
 
@@ -156,7 +186,7 @@ start:
 	for (;;) {
 		last_pkmap_nr = (last_pkmap_nr + 1) & LAST_PKMAP_MASK;
 		if (!last_pkmap_nr) {
-			flush_all_zero_pkmaps();
+			flush_all_zero_pkmaps(false);
 			count = LAST_PKMAP;
 		}
 		if (!pkmap_count[last_pkmap_nr])
@@ -170,6 +200,7 @@ start:
 		{
 			DECLARE_WAITQUEUE(wait, current);
 
+			count_vm_event(KMAP_WAIT);
 			__set_current_state(TASK_UNINTERRUPTIBLE);
 			add_wait_queue(&pkmap_map_wait, &wait);
 			unlock_kmap();
@@ -213,8 +244,13 @@ void *kmap_high(struct page *page)
 	 */
 	lock_kmap();
 	vaddr = (unsigned long)page_address(page);
-	if (!vaddr)
+	if (!vaddr) {
 		vaddr = map_new_virtual(page);
+		count_vm_event(KMAP_MISS);
+	} else {
+		__set_bit(PKMAP_NR(vaddr), pkmap_referenced);
+		count_vm_event(KMAP_HIT);
+	}
 	pkmap_count[PKMAP_NR(vaddr)]++;
 	BUG_ON(pkmap_count[PKMAP_NR(vaddr)] < 2);
 	unlock_kmap();
@@ -243,6 +279,7 @@ void *kmap_high_get(struct page *page)
 	if (vaddr) {
 		BUG_ON(pkmap_count[PKMAP_NR(vaddr)] < 1);
 		pkmap_count[PKMAP_NR(vaddr)]++;
+		__set_bit(PKMAP_NR(vaddr), pkmap_referenced);
 	}
 	unlock_kmap_any(flags);
 	return (void*) vaddr;
@@ -36,6 +36,8 @@
 #include <linux/hash.h>
 #include <linux/freezer.h>
 #include <linux/oom.h>
+#include <linux/workqueue.h>
+#include <linux/math64.h>
 
 #include <asm/tlbflush.h>
 #include "internal.h"
@@ -78,6 +80,11 @@
  *    take 10 attempts to find a page in the unstable tree, once it is found,
  *    it is secured in the stable tree.  (When we scan a new page, we first
  *    compare it against the stable tree, and then against the unstable tree.)
+ *
+ * The unstable tree is sorted by checksum first, and by contents only among
+ * pages of equal checksum: most steps down it compare two numbers instead of
+ * two pages.  It is split by checksum into partitions with a mutex each, so
+ * that the pages ksmd gathers can be merged by several threads at once.
  */
 
 /**
@@ -152,9 +159,20 @@ struct rmap_item {
 #define UNSTABLE_FLAG	0x100	/* is a node of the unstable tree */
 #define STABLE_FLAG	0x200	/* is listed from the stable tree */
 
-/* The stable and unstable tree heads */
+/* The stable tree head */
 static struct rb_root root_stable_tree = RB_ROOT;
-static struct rb_root root_unstable_tree = RB_ROOT;
+
+/* The unstable tree, partitioned by the low bits of the checksum */
+#define UNSTABLE_PARTS_SHIFT	5
+#define UNSTABLE_PARTS		(1 << UNSTABLE_PARTS_SHIFT)
+
+struct unstable_part {
+	struct rb_root root;
+	struct mutex lock;
+	unsigned long pages_unshared;	/* rmap_items flagged in this part */
+} ____cacheline_aligned_in_smp;
+
+static struct unstable_part unstable_parts[UNSTABLE_PARTS];
 
 #define MM_SLOTS_HASH_SHIFT 10
 #define MM_SLOTS_HASH_HEADS (1 << MM_SLOTS_HASH_SHIFT)
@@ -177,12 +195,25 @@ static unsigned long ksm_pages_shared;
 /* The number of page slots additionally sharing those nodes */
 static unsigned long ksm_pages_sharing;
 
-/* The number of nodes in the unstable tree */
-static unsigned long ksm_pages_unshared;
-
 /* The number of rmap_items in use: to calculate pages_volatile */
 static unsigned long ksm_rmap_items;
 
+/* The number of pages merged since boot, and ksmd's CPU time for them */
+static unsigned long ksm_pages_merged;
+static u64 ksm_scan_cpu_ns;
+
+/* Duration of the last full scan; start of the current one */
+static unsigned long ksm_full_scan_jiffies;
+static unsigned long ksm_scan_start;
+static unsigned long ksm_scan_merged;
+
+/*
+ * Time from setting ksmd running to the end of the first full scan which
+ * merged less than 1% of pages_sharing: 0 until that happened.
+ */
+static unsigned long ksm_converge_start;
+static unsigned long ksm_converge_jiffies;
+
 /* Number of pages ksmd should scan in one batch */
 static unsigned int ksm_thread_pages_to_scan = 128;
 
@@ -198,6 +229,36 @@ static DECLARE_WAIT_QUEUE_HEAD(ksm_thread_wait);
 static DEFINE_MUTEX(ksm_thread_mutex);
 static DEFINE_SPINLOCK(ksm_mmlist_lock);
 
+/* Serializes the stable tree and its counters between the scan threads */
+static DEFINE_MUTEX(ksm_stable_mutex);
+
+/* Threads merging the pages ksmd gathers, ksmd itself included */
+#define KSM_SCAN_THREADS_MAX	32
+static unsigned int ksm_scan_threads = 1;
+
+/*
+ * Pages gathered by ksmd under ksm_thread_mutex, with a reference held,
+ * then merged in slices: the first by ksmd, the others on ksm_scan_wq.
+ */
+#define KSM_SCAN_BATCH		256
+
+struct scan_item {
+	struct page *page;
+	struct rmap_item *rmap_item;
+};
+
+struct scan_work {
+	struct work_struct work;
+	unsigned int start;
+	unsigned int end;
+	u64 cpu_ns;
+};
+
+static struct scan_item ksm_scan_batch[KSM_SCAN_BATCH];
+static unsigned int ksm_scan_nr;
+static struct scan_work ksm_scan_works[KSM_SCAN_THREADS_MAX];
+static struct workqueue_struct *ksm_scan_wq;
+
 #define KSM_KMEM_CACHE(__struct, __flags) kmem_cache_create("ksm_"#__struct,\
 		sizeof(struct __struct), __alignof__(struct __struct),\
 		(__flags), NULL)
@@ -480,7 +541,7 @@ static void remove_node_from_stable_tree(struct stable_node *stable_node)
  * a page to put something that might look like our key in page->mapping.
  *
  * include/linux/pagemap.h page_cache_get_speculative() is a good reference,
- * but this is different - made simpler by ksm_thread_mutex being held, but
+ * but this is different - made simpler by ksm_stable_mutex being held, but
  * interesting for assuming that no other use of the struct page could ever
  * put our expected_mapping into page->mapping (or a field of the union which
  * coincides with page->mapping).  The RCU calls are not for KSM at all, but
@@ -516,6 +577,35 @@ stale:
 	return NULL;
 }
 
+static inline struct unstable_part *unstable_part(u32 checksum)
+{
+	return &unstable_parts[checksum & (UNSTABLE_PARTS - 1)];
+}
+
+/*
+ * Take rmap_item out of its unstable tree partition: called with the
+ * partition's lock held, the one for the checksum it was inserted with.
+ */
+static void unstable_tree_erase(struct unstable_part *part,
+				struct rmap_item *rmap_item)
+{
+	unsigned char age;
+	/*
+	 * Usually ksmd can and must skip the rb_erase, because
+	 * the unstable tree was already reset to RB_ROOT.
+	 * But be careful when an mm is exiting: do the rb_erase
+	 * if this rmap_item was inserted by this scan, rather
+	 * than left over from before.
+	 */
+	age = (unsigned char)(ksm_scan.seqnr - rmap_item->address);
+	BUG_ON(age > 1);
+	if (!age)
+		rb_erase(&rmap_item->node, &part->root);
+
+	part->pages_unshared--;
+	rmap_item->address &= PAGE_MASK;
+}
+
 /*
  * Removing rmap_item from stable or unstable tree.
  * This function will clean the information from the stable/unstable tree.
@@ -526,10 +616,15 @@ static void remove_rmap_item_from_tree(struct rmap_item *rmap_item)
 		struct stable_node *stable_node;
 		struct page *page;
 
+		mutex_lock(&ksm_stable_mutex);
+		/* another thread may have found its stable node stale */
+		if (!(rmap_item->address & STABLE_FLAG))
+			goto unlock;
+
 		stable_node = rmap_item->head;
 		page = get_ksm_page(stable_node);
 		if (!page)
-			goto out;
+			goto unlock;
 
 		lock_page(page);
 		hlist_del(&rmap_item->hlist);
@@ -543,25 +638,17 @@ static void remove_rmap_item_from_tree(struct rmap_item *rmap_item)
 
 		put_anon_vma(rmap_item->anon_vma);
 		rmap_item->address &= PAGE_MASK;
+unlock:
+		mutex_unlock(&ksm_stable_mutex);
 
 	} else if (rmap_item->address & UNSTABLE_FLAG) {
-		unsigned char age;
-		/*
-		 * Usually ksmd can and must skip the rb_erase, because
-		 * root_unstable_tree was already reset to RB_ROOT.
-		 * But be careful when an mm is exiting: do the rb_erase
-		 * if this rmap_item was inserted by this scan, rather
-		 * than left over from before.
-		 */
-		age = (unsigned char)(ksm_scan.seqnr - rmap_item->address);
-		BUG_ON(age > 1);
-		if (!age)
-			rb_erase(&rmap_item->node, &root_unstable_tree);
+		struct unstable_part *part;
 
-		ksm_pages_unshared--;
-		rmap_item->address &= PAGE_MASK;
+		part = unstable_part(rmap_item->oldchecksum);
+		mutex_lock(&part->lock);
+		unstable_tree_erase(part, rmap_item);
+		mutex_unlock(&part->lock);
 	}
-out:
 	cond_resched();		/* we're called from many long loops */
 }
 
@@ -669,11 +756,25 @@ error:
 }
 #endif /* CONFIG_SYSFS */
 
+/*
+ * The checksum hashes CHECKSUM_BLOCKS blocks spread evenly over the page,
+ * a quarter of it: that still catches most pages being written to, and
+ * is all the unstable tree needs as a key, since equal pages always have
+ * equal checksums.
+ */
+#define CHECKSUM_BLOCKS		16
+#define CHECKSUM_BLOCK_WORDS	16	/* 64 bytes */
+#define CHECKSUM_STRIDE		(PAGE_SIZE / 4 / CHECKSUM_BLOCKS)
+
 static u32 calc_checksum(struct page *page)
 {
-	u32 checksum;
-	void *addr = kmap_atomic(page, KM_USER0);
-	checksum = jhash2(addr, PAGE_SIZE / 4, 17);
+	u32 checksum = 17;
+	u32 *addr = kmap_atomic(page, KM_USER0);
+	int i;
+
+	for (i = 0; i < CHECKSUM_BLOCKS; i++)
+		checksum = jhash2(addr + i * CHECKSUM_STRIDE,
+				  CHECKSUM_BLOCK_WORDS, checksum);
 	kunmap_atomic(addr, KM_USER0);
 	return checksum;
 }
@@ -981,7 +1082,7 @@ static struct page *try_to_merge_two_pages(struct rmap_item *rmap_item,
  * with identical content to the page that we are scanning right now.
  *
  * This function returns the stable tree node of identical content if found,
- * NULL otherwise.
+ * NULL otherwise.  Called with ksm_stable_mutex held.
  */
 static struct page *stable_tree_search(struct page *page)
 {
@@ -1024,7 +1125,7 @@ static struct page *stable_tree_search(struct page *page)
  * into the stable tree.
  *
  * This function returns the stable tree node just allocated on success,
- * NULL otherwise.
+ * NULL otherwise.  Called with ksm_stable_mutex held.
  */
 static struct stable_node *stable_tree_insert(struct page *kpage)
 {
@@ -1087,16 +1188,19 @@ static struct stable_node *stable_tree_insert(struct page *kpage)
  * to the currently scanned page, NULL otherwise.
  *
  * This function does both searching and inserting, because they share
- * the same walking algorithm in an rbtree.
+ * the same walking algorithm in an rbtree.  It is called with the lock
+ * of the partition for rmap_item->oldchecksum held.
  */
 static
-struct rmap_item *unstable_tree_search_insert(struct rmap_item *rmap_item,
+struct rmap_item *unstable_tree_search_insert(struct unstable_part *part,
+					      struct rmap_item *rmap_item,
 					      struct page *page,
 					      struct page **tree_pagep)
 
 {
-	struct rb_node **new = &root_unstable_tree.rb_node;
+	struct rb_node **new = &part->root.rb_node;
 	struct rb_node *parent = NULL;
+	u32 checksum = rmap_item->oldchecksum;
 
 	while (*new) {
 		struct rmap_item *tree_rmap_item;
@@ -1105,6 +1209,17 @@ struct rmap_item *unstable_tree_search_insert(struct rmap_item *rmap_item,
 
 		cond_resched();
 		tree_rmap_item = rb_entry(*new, struct rmap_item, node);
+
+		/* Only pages of equal checksum need to be looked at */
+		parent = *new;
+		if (checksum < tree_rmap_item->oldchecksum) {
+			new = &parent->rb_left;
+			continue;
+		} else if (checksum > tree_rmap_item->oldchecksum) {
+			new = &parent->rb_right;
+			continue;
+		}
+
 		tree_page = get_mergeable_page(tree_rmap_item);
 		if (IS_ERR_OR_NULL(tree_page))
 			return NULL;
@@ -1119,7 +1234,6 @@ struct rmap_item *unstable_tree_search_insert(struct rmap_item *rmap_item,
 
 		ret = memcmp_pages(page, tree_page);
 
-		parent = *new;
 		if (ret < 0) {
 			put_page(tree_page);
 			new = &parent->rb_left;
@@ -1135,16 +1249,16 @@ struct rmap_item *unstable_tree_search_insert(struct rmap_item *rmap_item,
 	rmap_item->address |= UNSTABLE_FLAG;
 	rmap_item->address |= (ksm_scan.seqnr & SEQNR_MASK);
 	rb_link_node(&rmap_item->node, parent, new);
-	rb_insert_color(&rmap_item->node, &root_unstable_tree);
+	rb_insert_color(&rmap_item->node, &part->root);
 
-	ksm_pages_unshared++;
+	part->pages_unshared++;
 	return NULL;
 }
 
 /*
  * stable_tree_append - add another rmap_item to the linked list of
  * rmap_items hanging off a given node of the stable tree, all sharing
- * the same ksm page.
+ * the same ksm page.  Called with ksm_stable_mutex and the page lock held.
  */
 static void stable_tree_append(struct rmap_item *rmap_item,
 			       struct stable_node *stable_node)
@@ -1153,9 +1267,10 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 	rmap_item->address |= STABLE_FLAG;
 	hlist_add_head(&rmap_item->hlist, &stable_node->hlist);
 
-	if (rmap_item->hlist.next)
+	if (rmap_item->hlist.next) {
 		ksm_pages_sharing++;
-	else
+		ksm_pages_merged++;
+	} else
 		ksm_pages_shared++;
 }
 
@@ -1167,9 +1282,14 @@ static void stable_tree_append(struct rmap_item *rmap_item,
  *
  * @page: the page that we are searching identical page to.
  * @rmap_item: the reverse mapping into the virtual address of this page
+ *
+ * Runs in the scan threads concurrently, for different rmap_items: the
+ * trees are only touched under ksm_stable_mutex or the partition's lock,
+ * the merging itself under the mmap_sem and page locks only.
  */
 static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 {
+	struct unstable_part *part;
 	struct rmap_item *tree_rmap_item;
 	struct page *tree_page = NULL;
 	struct stable_node *stable_node;
@@ -1180,17 +1300,22 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 	remove_rmap_item_from_tree(rmap_item);
 
 	/* We first start with searching the page inside the stable tree */
+	mutex_lock(&ksm_stable_mutex);
 	kpage = stable_tree_search(page);
+	mutex_unlock(&ksm_stable_mutex);
 	if (kpage) {
 		err = try_to_merge_with_ksm_page(rmap_item, page, kpage);
 		if (!err) {
 			/*
 			 * The page was successfully merged:
 			 * add its rmap_item to the stable tree.
+			 * Our reference keeps kpage on its stable node.
 			 */
+			mutex_lock(&ksm_stable_mutex);
 			lock_page(kpage);
 			stable_tree_append(rmap_item, page_stable_node(kpage));
 			unlock_page(kpage);
+			mutex_unlock(&ksm_stable_mutex);
 		}
 		put_page(kpage);
 		return;
@@ -1208,20 +1333,30 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 		return;
 	}
 
-	tree_rmap_item =
-		unstable_tree_search_insert(rmap_item, page, &tree_page);
+	/*
+	 * The rmap_item we find is taken out of the unstable tree before
+	 * the partition is unlocked, so no other thread can try to merge
+	 * with it too; if our merge fails, it waits for the next scan.
+	 */
+	part = unstable_part(checksum);
+	mutex_lock(&part->lock);
+	tree_rmap_item = unstable_tree_search_insert(part, rmap_item, page,
+						     &tree_page);
+	if (tree_rmap_item)
+		unstable_tree_erase(part, tree_rmap_item);
+	mutex_unlock(&part->lock);
+
 	if (tree_rmap_item) {
 		kpage = try_to_merge_two_pages(rmap_item, page,
 						tree_rmap_item, tree_page);
 		put_page(tree_page);
 		/*
-		 * As soon as we merge this page, we want to remove the
-		 * rmap_item of the page we have merged with from the unstable
-		 * tree, and insert it instead as new node in the stable tree.
+		 * As soon as we merge this page, insert the rmap_item
+		 * of the page we have merged with as new node in the
+		 * stable tree.
 		 */
 		if (kpage) {
-			remove_rmap_item_from_tree(tree_rmap_item);
-
+			mutex_lock(&ksm_stable_mutex);
 			lock_page(kpage);
 			stable_node = stable_tree_insert(kpage);
 			if (stable_node) {
@@ -1229,6 +1364,7 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 				stable_tree_append(rmap_item, stable_node);
 			}
 			unlock_page(kpage);
+			mutex_unlock(&ksm_stable_mutex);
 
 			/*
 			 * If we fail to insert the page into the stable tree,
@@ -1244,6 +1380,62 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 	}
 }
 
+static void ksm_merge_slice(unsigned int start, unsigned int end)
+{
+	unsigned int i;
+
+	for (i = start; i < end; i++) {
+		struct scan_item *item = &ksm_scan_batch[i];
+
+		cmp_and_merge_page(item->page, item->rmap_item);
+		put_page(item->page);
+	}
+}
+
+static void ksm_merge_work(struct work_struct *work)
+{
+	struct scan_work *sw = container_of(work, struct scan_work, work);
+	u64 start = task_sched_runtime(current);
+
+	ksm_merge_slice(sw->start, sw->end);
+	sw->cpu_ns = task_sched_runtime(current) - start;
+}
+
+/*
+ * Merge the pages gathered in ksm_scan_batch, split over up to
+ * ksm_scan_threads threads.  Called by ksmd holding ksm_thread_mutex,
+ * which keeps the rmap_items in place, but no mmap_sem: merging takes it.
+ */
+static void ksm_merge_batch(void)
+{
+	unsigned int nr = ksm_scan_nr, threads, per, i;
+
+	if (!nr)
+		return;
+
+	threads = 1;
+	if (ksm_scan_wq)
+		threads = min3(ksm_scan_threads, num_online_cpus(), nr);
+	per = DIV_ROUND_UP(nr, threads);
+	threads = DIV_ROUND_UP(nr, per);
+
+	for (i = 1; i < threads; i++) {
+		struct scan_work *sw = &ksm_scan_works[i];
+
+		sw->start = i * per;
+		sw->end = min(nr, sw->start + per);
+		queue_work(ksm_scan_wq, &sw->work);
+	}
+
+	ksm_merge_slice(0, per);
+
+	for (i = 1; i < threads; i++) {
+		flush_work(&ksm_scan_works[i].work);
+		ksm_scan_cpu_ns += ksm_scan_works[i].cpu_ns;
+	}
+	ksm_scan_nr = 0;
+}
+
 static struct rmap_item *get_next_rmap_item(struct mm_slot *mm_slot,
 					    struct rmap_item **rmap_list,
 					    unsigned long addr)
@@ -1278,6 +1470,7 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 	struct mm_slot *slot;
 	struct vm_area_struct *vma;
 	struct rmap_item *rmap_item;
+	int i;
 
 	if (list_empty(&ksm_mm_head.mm_list))
 		return NULL;
@@ -1296,7 +1489,11 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 		 */
 		lru_add_drain_all();
 
-		root_unstable_tree = RB_ROOT;
+		for (i = 0; i < UNSTABLE_PARTS; i++)
+			unstable_parts[i].root = RB_ROOT;
+
+		ksm_scan_start = jiffies;
+		ksm_scan_merged = ksm_pages_merged;
 
 		spin_lock(&ksm_mmlist_lock);
 		slot = list_entry(slot->mm_list.next, struct mm_slot, mm_list);
@@ -1358,6 +1555,18 @@ next_mm:
 		}
 	}
 
+	/*
+	 * Merge the pages gathered from this mm before any of its rmap_items
+	 * can be freed below; not under mmap_sem, which the merging takes.
+	 * There are none unless we found some pages, so ksm_scan.address is
+	 * only 0 after dropping mmap_sem here if the mm is exiting.
+	 */
+	if (ksm_scan_nr) {
+		up_read(&mm->mmap_sem);
+		ksm_merge_batch();
+		down_read(&mm->mmap_sem);
+	}
+
 	if (ksm_test_exit(mm)) {
 		ksm_scan.address = 0;
 		ksm_scan.rmap_list = &slot->rmap_list;
@@ -1400,6 +1609,11 @@ next_mm:
 		goto next_mm;
 
 	ksm_scan.seqnr++;
+
+	ksm_full_scan_jiffies = jiffies - ksm_scan_start;
+	if (!ksm_converge_jiffies &&
+	    (ksm_pages_merged - ksm_scan_merged) * 100 <= ksm_pages_sharing)
+		ksm_converge_jiffies = max(jiffies - ksm_converge_start, 1UL);
 	return NULL;
 }
 
@@ -1416,11 +1630,17 @@ static void ksm_do_scan(unsigned int scan_npages)
 		cond_resched();
 		rmap_item = scan_get_next_rmap_item(&page);
 		if (!rmap_item)
-			return;
-		if (!PageKsm(page) || !in_stable_tree(rmap_item))
-			cmp_and_merge_page(page, rmap_item);
-		put_page(page);
+			break;
+		if (PageKsm(page) && in_stable_tree(rmap_item)) {
+			put_page(page);
+			continue;
+		}
+		ksm_scan_batch[ksm_scan_nr].page = page;
+		ksm_scan_batch[ksm_scan_nr].rmap_item = rmap_item;
+		if (++ksm_scan_nr == KSM_SCAN_BATCH)
+			ksm_merge_batch();
 	}
+	ksm_merge_batch();
 }
 
 static int ksmd_should_run(void)
@@ -1435,8 +1655,12 @@ static int ksm_scan_thread(void *nothing)
 
 	while (!kthread_should_stop()) {
 		mutex_lock(&ksm_thread_mutex);
-		if (ksmd_should_run())
+		if (ksmd_should_run()) {
+			u64 start = task_sched_runtime(current);
+
 			ksm_do_scan(ksm_thread_pages_to_scan);
+			ksm_scan_cpu_ns += task_sched_runtime(current) - start;
+		}
 		mutex_unlock(&ksm_thread_mutex);
 
 		try_to_freeze();
@@ -1900,6 +2124,10 @@ static ssize_t run_store(struct kobject *kobj, struct kobj_attribute *attr,
 	mutex_lock(&ksm_thread_mutex);
 	if (ksm_run != flags) {
 		ksm_run = flags;
+		if (flags & KSM_RUN_MERGE) {
+			ksm_converge_start = jiffies;
+			ksm_converge_jiffies = 0;
+		}
 		if (flags & KSM_RUN_UNMERGE) {
 			int oom_score_adj;
 
@@ -1935,10 +2163,20 @@ static ssize_t pages_sharing_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(pages_sharing);
 
+static unsigned long ksm_pages_unshared(void)
+{
+	unsigned long pages = 0;
+	int i;
+
+	for (i = 0; i < UNSTABLE_PARTS; i++)
+		pages += unstable_parts[i].pages_unshared;
+	return pages;
+}
+
 static ssize_t pages_unshared_show(struct kobject *kobj,
 				   struct kobj_attribute *attr, char *buf)
 {
-	return sprintf(buf, "%lu\n", ksm_pages_unshared);
+	return sprintf(buf, "%lu\n", ksm_pages_unshared());
 }
 KSM_ATTR_RO(pages_unshared);
 
@@ -1948,7 +2186,7 @@ static ssize_t pages_volatile_show(struct kobject *kobj,
 	long ksm_pages_volatile;
 
 	ksm_pages_volatile = ksm_rmap_items - ksm_pages_shared
-				- ksm_pages_sharing - ksm_pages_unshared;
+				- ksm_pages_sharing - ksm_pages_unshared();
 	/*
 	 * It was not worth any locking to calculate that statistic,
 	 * but it might therefore sometimes be negative: conceal that.
@@ -1966,6 +2204,79 @@ static ssize_t full_scans_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(full_scans);
 
+static ssize_t scan_threads_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_scan_threads);
+}
+
+static ssize_t scan_threads_store(struct kobject *kobj,
+				  struct kobj_attribute *attr,
+				  const char *buf, size_t count)
+{
+	unsigned long threads;
+	int err;
+
+	err = strict_strtoul(buf, 10, &threads);
+	if (err || !threads || threads > KSM_SCAN_THREADS_MAX)
+		return -EINVAL;
+
+	ksm_scan_threads = threads;
+
+	return count;
+}
+KSM_ATTR(scan_threads);
+
+static ssize_t full_scan_millisecs_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", jiffies_to_msecs(ksm_full_scan_jiffies));
+}
+KSM_ATTR_RO(full_scan_millisecs);
+
+static ssize_t converge_millisecs_show(struct kobject *kobj,
+				       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", jiffies_to_msecs(ksm_converge_jiffies));
+}
+KSM_ATTR_RO(converge_millisecs);
+
+static ssize_t pages_merged_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_pages_merged);
+}
+KSM_ATTR_RO(pages_merged);
+
+static ssize_t scan_cpu_millisecs_show(struct kobject *kobj,
+				       struct kobj_attribute *attr, char *buf)
+{
+	u64 ns;
+
+	mutex_lock(&ksm_thread_mutex);
+	ns = ksm_scan_cpu_ns;
+	mutex_unlock(&ksm_thread_mutex);
+
+	return sprintf(buf, "%llu\n", div_u64(ns, NSEC_PER_MSEC));
+}
+KSM_ATTR_RO(scan_cpu_millisecs);
+
+static ssize_t merge_cpu_usecs_show(struct kobject *kobj,
+				    struct kobj_attribute *attr, char *buf)
+{
+	unsigned long merged;
+	u64 ns;
+
+	mutex_lock(&ksm_thread_mutex);
+	ns = ksm_scan_cpu_ns;
+	merged = ksm_pages_merged;
+	mutex_unlock(&ksm_thread_mutex);
+
+	ns = merged ? div_u64(ns, merged) : 0;
+	return sprintf(buf, "%llu\n", div_u64(ns, NSEC_PER_USEC));
+}
+KSM_ATTR_RO(merge_cpu_usecs);
+
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
@@ -1975,6 +2286,12 @@ static struct attribute *ksm_attrs[] = {
 	&pages_unshared_attr.attr,
 	&pages_volatile_attr.attr,
 	&full_scans_attr.attr,
+	&scan_threads_attr.attr,
+	&full_scan_millisecs_attr.attr,
+	&converge_millisecs_attr.attr,
+	&pages_merged_attr.attr,
+	&scan_cpu_millisecs_attr.attr,
+	&merge_cpu_usecs_attr.attr,
 	NULL,
 };
 
@@ -1987,12 +2304,24 @@ static struct attribute_group ksm_attr_group = {
 static int __init ksm_init(void)
 {
 	struct task_struct *ksm_thread;
-	int err;
+	int i, err;
 
 	err = ksm_slab_init();
 	if (err)
 		goto out;
 
+	for (i = 0; i < UNSTABLE_PARTS; i++)
+		mutex_init(&unstable_parts[i].lock);
+	for (i = 0; i < KSM_SCAN_THREADS_MAX; i++)
+		INIT_WORK(&ksm_scan_works[i].work, ksm_merge_work);
+
+	/* Without it ksmd merges all the pages itself */
+	ksm_scan_wq = alloc_workqueue("ksm_scan", WQ_UNBOUND,
+				      KSM_SCAN_THREADS_MAX);
+	if (!ksm_scan_wq)
+		printk(KERN_WARNING "ksm: no scan threads, ksmd only\n");
+	ksm_converge_start = jiffies;
+
 	ksm_thread = kthread_run(ksm_scan_thread, NULL, "ksmd");
 	if (IS_ERR(ksm_thread)) {
 		printk(KERN_ERR "ksm: creating kthread failed\n");
@@ -2022,6 +2351,8 @@ static int __init ksm_init(void)
 	return 0;
 
 out_free:
+	if (ksm_scan_wq)
+		destroy_workqueue(ksm_scan_wq);
 	ksm_slab_free();
 out:
 	return err;
@@ -1269,7 +1269,7 @@ static struct page *new_page(struct page *p, unsigned long private, int **x)
  */
 static int get_any_page(struct page *p, unsigned long pfn, int flags)
 {
-	int ret;
+	int ret, mt;
 
 	if (flags & MF_COUNT_INCREASED)
 		return 1;
@@ -1282,8 +1282,11 @@ static int get_any_page(struct page *p, unsigned long pfn, int flags)
 
 	/*
 	 * Isolate the page, so that it doesn't get reallocated if it
-	 * was free.
+	 * was free.  A lent CMA pageblock goes back to MIGRATE_CMA after.
 	 */
+	mt = get_pageblock_migratetype(p);
+	if (!is_migrate_cma(mt))
+		mt = MIGRATE_MOVABLE;
 	set_migratetype_isolate(p);
 	/*
 	 * When the target page is a free hugepage, just remove it
@@ -1307,7 +1310,7 @@ static int get_any_page(struct page *p, unsigned long pfn, int flags)
 		/* Not a free page */
 		ret = 1;
 	}
-	unset_migratetype_isolate(p);
+	unset_migratetype_isolate(p, mt);
 	unlock_memory_hotplug();
 	return ret;
 }
@@ -16,19 +16,21 @@
 #include <linux/pagemap.h>
 #include <linux/swap.h>
 #include <linux/bio.h>
+#include <linux/blkdev.h>
 #include <linux/swapops.h>
 #include <linux/writeback.h>
 #include <asm/pgtable.h>
 
-static struct bio *get_swap_bio(gfp_t gfp_flags,
-				struct page *page, bio_end_io_t end_io)
+static struct bio *get_swap_bio(gfp_t gfp_flags, struct block_device *bdev,
+				sector_t sector, struct page *page,
+				bio_end_io_t end_io)
 {
 	struct bio *bio;
 
 	bio = bio_alloc(gfp_flags, 1);
 	if (bio) {
-		bio->bi_sector = map_swap_page(page, &bio->bi_bdev);
-		bio->bi_sector <<= PAGE_SHIFT - 9;
+		bio->bi_bdev = bdev;
+		bio->bi_sector = sector;
 		bio->bi_io_vec[0].bv_page = page;
 		bio->bi_io_vec[0].bv_len = PAGE_SIZE;
 		bio->bi_io_vec[0].bv_offset = 0;
@@ -66,6 +68,55 @@ static void end_swap_bio_write(struct bio *bio, int err)
 	bio_put(bio);
 }
 
+/*
+ * Devices that keep swap in memory (zram) do the page synchronously
+ * through ->swap_rw_page(), without the bio and request overhead.  The
+ * page is clean or uptodate when we return, so reclaim can free it in
+ * the same pass instead of waiting for it to come round the LRU again.
+ */
+static inline int swap_rw_page(struct block_device *bdev, sector_t sector,
+			       struct page *page, int rw)
+{
+	return bdev->bd_disk->fops->swap_rw_page(bdev,
+			sector + get_start_sect(bdev), page, rw);
+}
+
+static void swap_write_sync(struct block_device *bdev, sector_t sector,
+			    struct page *page)
+{
+	count_vm_event(PSWPOUT);
+	set_page_writeback(page);
+	unlock_page(page);
+
+	if (swap_rw_page(bdev, sector, page, WRITE)) {
+		/* as end_swap_bio_write() */
+		SetPageError(page);
+		set_page_dirty(page);
+		printk(KERN_ALERT "Write-error on swap-device (%u:%u:%Lu)\n",
+				imajor(bdev->bd_inode), iminor(bdev->bd_inode),
+				(unsigned long long)sector);
+		ClearPageReclaim(page);
+	}
+	end_page_writeback(page);
+}
+
+static void swap_read_sync(struct block_device *bdev, sector_t sector,
+			   struct page *page)
+{
+	count_vm_event(PSWPIN);
+
+	if (swap_rw_page(bdev, sector, page, READ)) {
+		SetPageError(page);
+		ClearPageUptodate(page);
+		printk(KERN_ALERT "Read-error on swap-device (%u:%u:%Lu)\n",
+				imajor(bdev->bd_inode), iminor(bdev->bd_inode),
+				(unsigned long long)sector);
+	} else {
+		SetPageUptodate(page);
+	}
+	unlock_page(page);
+}
+
 void end_swap_bio_read(struct bio *bio, int err)
 {
 	const int uptodate = test_bit(BIO_UPTODATE, &bio->bi_flags);
@@ -91,14 +142,21 @@ void end_swap_bio_read(struct bio *bio, int err)
  */
 int swap_writepage(struct page *page, struct writeback_control *wbc)
 {
+	struct block_device *bdev;
 	struct bio *bio;
+	sector_t sector;
 	int ret = 0, rw = WRITE;
 
 	if (try_to_free_swap(page)) {
 		unlock_page(page);
 		goto out;
 	}
-	bio = get_swap_bio(GFP_NOIO, page, end_swap_bio_write);
+	sector = map_swap_page(page, &bdev) << (PAGE_SHIFT - 9);
+	if (bdev->bd_disk->fops->swap_rw_page) {
+		swap_write_sync(bdev, sector, page);
+		goto out;
+	}
+	bio = get_swap_bio(GFP_NOIO, bdev, sector, page, end_swap_bio_write);
 	if (bio == NULL) {
 		set_page_dirty(page);
 		unlock_page(page);
@@ -117,12 +175,19 @@ out:
 
 int swap_readpage(struct page *page)
 {
+	struct block_device *bdev;
 	struct bio *bio;
+	sector_t sector;
 	int ret = 0;
 
 	VM_BUG_ON(!PageLocked(page));
 	VM_BUG_ON(PageUptodate(page));
-	bio = get_swap_bio(GFP_KERNEL, page, end_swap_bio_read);
+	sector = map_swap_page(page, &bdev) << (PAGE_SHIFT - 9);
+	if (bdev->bd_disk->fops->swap_rw_page) {
+		swap_read_sync(bdev, sector, page);
+		goto out;
+	}
+	bio = get_swap_bio(GFP_KERNEL, bdev, sector, page, end_swap_bio_read);
 	if (bio == NULL) {
 		unlock_page(page);
 		ret = -ENOMEM;
@@ -17,6 +17,7 @@
 #include <linux/task_io_accounting_ops.h>
 #include <linux/pagevec.h>
 #include <linux/pagemap.h>
+#include <linux/math64.h>
 
 /*
  * Initialise a struct file's readahead state.  Assumes that the caller has
@@ -184,11 +185,14 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 		if (!page)
 			break;
 		page->index = page_offset;
+		__SetPageRaUnused(page);
 		list_add(&page->lru, &page_pool);
 		if (page_idx == nr_to_read - lookahead_size)
 			SetPageReadahead(page);
 		ret++;
 	}
+	if (ret)
+		add_bdi_stat(mapping->backing_dev_info, BDI_READAHEAD, ret);
 
 	/*
 	 * Now start the IO.  We ignore I/O errors - if the page is not
@@ -245,6 +249,19 @@ unsigned long max_sane_readahead(unsigned long nr)
 		+ node_page_state(numa_node_id(), NR_FREE_PAGES)) / 2);
 }
 
+/*
+ * Called on the first access to a page read ahead, through page_ra_used().
+ * Pages evicted or truncated before that are counted as waste in
+ * __delete_from_page_cache().
+ */
+void __page_ra_used(struct page *page)
+{
+	struct address_space *mapping = page_mapping(page);
+
+	if (TestClearPageRaUnused(page) && mapping)
+		inc_bdi_stat(mapping->backing_dev_info, BDI_READAHEAD_HIT);
+}
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
@@ -389,6 +406,97 @@ static int try_context_readahead(struct address_space *mapping,
 	return 1;
 }
 
+/*
+ * Strided reads: records of about the same size at a fixed distance, as a
+ * database walking a table or a demuxer skipping the other tracks of a
+ * file.  Random reads at the same distance from the previous one
+ * RA_STRIDE_HITS times in a row arm the detector.  From then on the next
+ * strides are read ahead, up to a window's worth, with the middle one
+ * marked so that its use brings in the following ones asynchronously.
+ *
+ * The detector only looks at reads that none of the sequential and
+ * context checks claimed, so sequential streams interleaved on the same
+ * file do not reset it.
+ */
+#define RA_STRIDE_HITS		2
+#define RA_STRIDE_CHUNKS	16
+
+static bool ra_stride_update(struct file_ra_state *ra, pgoff_t offset,
+			     unsigned long req_size)
+{
+	if (offset > ra->stride_prev &&
+	    offset - ra->stride_prev == ra->stride) {
+		ra->stride_hits++;
+		ra->stride_size = max_t(unsigned int, ra->stride_size,
+					req_size);
+	} else {
+		ra->stride = offset > ra->stride_prev ?
+			offset - ra->stride_prev : 0;
+		ra->stride_size = req_size;
+		ra->stride_hits = 0;
+	}
+	ra->stride_prev = offset;
+
+	/* adjacent records are a sequential read, not a strided one */
+	if (ra->stride_hits < RA_STRIDE_HITS || ra->stride <= ra->stride_size)
+		return false;
+
+	ra->stride_next = offset + ra->stride;
+	return true;
+}
+
+/* Is @offset the marked page of a stride read ahead? */
+static bool ra_stride_marker(struct file_ra_state *ra, pgoff_t offset)
+{
+	return ra->stride_hits >= RA_STRIDE_HITS &&
+	       ra->stride > ra->stride_size &&
+	       offset < ra->stride_next &&
+	       (ra->stride_next - offset) % ra->stride == 0;
+}
+
+static unsigned long stride_readahead(struct address_space *mapping,
+				      struct file_ra_state *ra,
+				      struct file *filp, unsigned long max)
+{
+	unsigned long i, chunks, ret = 0;
+	pgoff_t index = ra->stride_next;
+
+	chunks = min_t(unsigned long, max / ra->stride_size, RA_STRIDE_CHUNKS);
+	for (i = 0; i < chunks; i++) {
+		ret += __do_page_cache_readahead(mapping, filp, index,
+				ra->stride_size,
+				i == chunks / 2 ? ra->stride_size : 0);
+		index += ra->stride;
+	}
+	ra->stride_next = index;
+
+	return ret;
+}
+
+/*
+ * Largest window worth reading ahead on @bdi.  A request should move
+ * enough data that the latency of the device is small next to its
+ * transfer time: RA_LATENCY_RATIO latencies' worth at the bandwidth the
+ * block layer measured.  Kept within half and twice @ra_pages, and
+ * @ra_pages itself until the device has been sampled.
+ */
+#define RA_LATENCY_RATIO	4
+
+static unsigned long ra_max_pages(struct backing_dev_info *bdi,
+				  unsigned long ra_pages)
+{
+	unsigned long latency = bdi_read_latency(bdi);
+	unsigned long bw = bdi_read_bandwidth(bdi);
+	unsigned long pages;
+
+	if (!latency || !bw)
+		return ra_pages;
+
+	pages = div_u64((u64)bw * latency * RA_LATENCY_RATIO, USEC_PER_SEC);
+
+	return clamp(pages, ra_pages / 2, ra_pages * 2);
+}
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -398,7 +506,17 @@ ondemand_readahead(struct address_space *mapping,
 		   bool hit_readahead_marker, pgoff_t offset,
 		   unsigned long req_size)
 {
-	unsigned long max = max_sane_readahead(ra->ra_pages);
+	unsigned long max;
+	unsigned long ret;
+
+	max = ra_max_pages(mapping->backing_dev_info, ra->ra_pages);
+	max = max_sane_readahead(max);
+
+	/*
+	 * Marked page of a strided readahead, read the next strides
+	 */
+	if (hit_readahead_marker && ra_stride_marker(ra, offset))
+		return stride_readahead(mapping, ra, filp, max);
 
 	/*
 	 * start of file
@@ -463,9 +581,14 @@ ondemand_readahead(struct address_space *mapping,
 
 	/*
 	 * standalone, small random read
-	 * Read as is, and do not pollute the readahead state.
+	 * Read as is, and do not pollute the readahead state, except for
+	 * the strides.
 	 */
-	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
+	ret = __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
+	if (ra_stride_update(ra, offset, req_size))
+		ret += stride_readahead(mapping, ra, filp, max);
+
+	return ret;
 
 initial_readahead:
 	ra->start = offset;
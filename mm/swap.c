@@ -360,6 +360,7 @@ void activate_page(struct page *page)
  */
 void mark_page_accessed(struct page *page)
 {
+	page_ra_used(page);
 	if (!PageActive(page) && !PageUnevictable(page) &&
 			PageReferenced(page) && PageLRU(page)) {
 		activate_page(page);
@@ -180,6 +180,39 @@ static int wait_for_discard(void *word)
 #define SWAPFILE_CLUSTER	256
 #define LATENCY_LIMIT		256
 
+/*
+ * First free cluster aligned to SWAPFILE_CLUSTER within [start, end],
+ * or si->max.  On flash a cluster then covers whole erase
+ * blocks, rather than straddling two of them, when it is written out
+ * in sequence.  Called without swap_lock, like the unaligned search.
+ */
+static unsigned long scan_aligned_cluster(struct swap_info_struct *si,
+					  unsigned long start,
+					  unsigned long end)
+{
+	unsigned long offset, i;
+	int latency_ration = LATENCY_LIMIT;
+
+	offset = ALIGN(start, SWAPFILE_CLUSTER);
+	for (; offset + SWAPFILE_CLUSTER - 1 <= end;
+	     offset += SWAPFILE_CLUSTER) {
+		/* used slots tend to be at the start of a cluster */
+		for (i = 0; i < SWAPFILE_CLUSTER; i++)
+			if (si->swap_map[offset + i])
+				break;
+		if (i == SWAPFILE_CLUSTER)
+			return offset;
+
+		latency_ration -= i + 1;
+		if (unlikely(latency_ration < 0)) {
+			cond_resched();
+			latency_ration = LATENCY_LIMIT;
+		}
+	}
+
+	return si->max;
+}
+
 static unsigned long scan_swap_map(struct swap_info_struct *si,
 				   unsigned char usage)
 {
@@ -198,13 +231,16 @@ static unsigned long scan_swap_map(struct swap_info_struct *si,
 	 * overall disk seek times between swap pages.  -- sct
 	 * But we do now try to find an empty cluster.  -Andrea
 	 * And we let swap pages go all over an SSD partition.  Hugh
+	 * Flash gets clusters aligned to SWAPFILE_CLUSTER, and devices
+	 * without seeks nor erase blocks (zram) plain first-free.
 	 */
 
 	si->flags += SWP_SCANNING;
 	scan_base = offset = si->cluster_next;
 
 	if (unlikely(!si->cluster_nr--)) {
-		if (si->pages - si->inuse_pages < SWAPFILE_CLUSTER) {
+		if (si->pages - si->inuse_pages < SWAPFILE_CLUSTER ||
+		    (si->flags & SWP_SYNCIO)) {
 			si->cluster_nr = SWAPFILE_CLUSTER - 1;
 			goto checks;
 		}
@@ -231,8 +267,25 @@ static unsigned long scan_swap_map(struct swap_info_struct *si,
 		 * Flash Translation Layer only remaps within limited zones,
 		 * we don't want to wear out the first zone too quickly.
 		 */
-		if (!(si->flags & SWP_SOLIDSTATE))
+		if (!(si->flags & SWP_SOLIDSTATE)) {
 			scan_base = offset = si->lowest_bit;
+		} else {
+			offset = scan_aligned_cluster(si, scan_base,
+						      si->highest_bit);
+			if (offset >= si->max)
+				offset = scan_aligned_cluster(si,
+						si->lowest_bit, scan_base);
+			if (offset < si->max) {
+				spin_lock(&swap_lock);
+				last_in_cluster = offset + SWAPFILE_CLUSTER - 1;
+				si->cluster_next = offset;
+				si->cluster_nr = SWAPFILE_CLUSTER - 1;
+				found_free_cluster = 1;
+				goto checks;
+			}
+			/* fragmented: the unaligned search may still succeed */
+			offset = scan_base;
+		}
 		last_in_cluster = offset + SWAPFILE_CLUSTER - 1;
 
 		/* Locate the first empty (unaligned) cluster */
@@ -2112,6 +2165,8 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 			p->flags |= SWP_SOLIDSTATE;
 			p->cluster_next = 1 + (random32() % p->highest_bit);
 		}
+		if (p->bdev->bd_disk->fops->swap_rw_page)
+			p->flags |= SWP_SYNCIO;
 		if (discard_swap(p) == 0 && (swap_flags & SWAP_FLAG_DISCARD))
 			p->flags |= SWP_DISCARDABLE;
 	}
@@ -2124,11 +2179,12 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 	enable_swap_info(p, prio, swap_map);
 
 	printk(KERN_INFO "Adding %uk swap on %s.  "
-			"Priority:%d extents:%d across:%lluk %s%s\n",
+			"Priority:%d extents:%d across:%lluk %s%s%s\n",
 		p->pages<<(PAGE_SHIFT-10), name, p->prio,
 		nr_extents, (unsigned long long)span<<(PAGE_SHIFT-10),
 		(p->flags & SWP_SOLIDSTATE) ? "SS" : "",
-		(p->flags & SWP_DISCARDABLE) ? "D" : "");
+		(p->flags & SWP_DISCARDABLE) ? "D" : "",
+		(p->flags & SWP_SYNCIO) ? "Y" : "");
 
 	mutex_unlock(&swapon_mutex);
 	atomic_inc(&proc_poll_event);
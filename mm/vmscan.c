@@ -775,9 +775,17 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 	unsigned long nr_congested = 0;
 	unsigned long nr_reclaimed = 0;
 	unsigned long nr_writeback = 0;
+	struct blk_plug plug;
 
 	cond_resched();
 
+	/*
+	 * Hold back the pageout() bios of the pass: anonymous pages of a
+	 * pass get consecutive slots of the swap cluster, and their writes
+	 * go out merged into a few requests instead of one per page.
+	 */
+	blk_start_plug(&plug);
+
 	while (!list_empty(page_list)) {
 		enum page_references references;
 		struct address_space *mapping;
@@ -1021,6 +1029,8 @@ keep_lumpy:
 	if (nr_dirty && nr_dirty == nr_congested && scanning_global_lru(sc))
 		zone_set_flag(zone, ZONE_CONGESTED);
 
+	blk_finish_plug(&plug);
+
 	free_page_list(&free_pages);
 
 	list_splice(&ret_pages, page_list);
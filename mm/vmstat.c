@@ -613,6 +613,9 @@ static char * const migratetype_names[MIGRATE_TYPES] = {
 	"Reclaimable",
 	"Movable",
 	"Reserve",
+#ifdef CONFIG_DMA_CMA
+	"CMA",
+#endif
 	"Isolate",
 };
 
@@ -719,6 +722,7 @@ const char * const vmstat_text[] = {
 	"numa_other",
 #endif
 	"nr_anon_transparent_hugepages",
+	"nr_free_cma",
 	"nr_dirty_threshold",
 	"nr_dirty_background_threshold",
 
@@ -764,6 +768,10 @@ const char * const vmstat_text[] = {
 	"compact_stall",
 	"compact_fail",
 	"compact_success",
+	"compact_daemon_wake",
+	"compact_daemon_pages_moved",
+	"compact_daemon_fail",
+	"compact_daemon_success",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -787,6 +795,14 @@ const char * const vmstat_text[] = {
 	"thp_split",
 #endif
 
+#ifdef CONFIG_HIGHMEM
+	"kmap_hit",
+	"kmap_miss",
+	"kmap_wait",
+	"kmap_flush",
+	"kmap_flush_pages",
+#endif
+
 #endif /* CONFIG_VM_EVENTS_COUNTERS */
 };
 #endif /* CONFIG_PROC_FS || CONFIG_SYSFS */
@@ -967,6 +983,7 @@ static const struct file_operations pagetypeinfo_file_ops = {
 static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 							struct zone *zone)
 {
+	unsigned int order;
 	int i;
 	seq_printf(m, "Node %d, zone %8s", pgdat->node_id, zone->name);
 	seq_printf(m,
@@ -1010,6 +1027,17 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 			   pageset->pcp.count,
 			   pageset->pcp.high,
 			   pageset->pcp.batch);
+		for (order = 0; order <= PCP_MAX_ORDER; order++) {
+			struct per_cpu_pages *pcp = pageset_pcp(pageset, order);
+			u64 total = (u64)pcp->hits + pcp->misses;
+
+			seq_printf(m,
+				   "\n              order %u: count %i high %i "
+				   "batch %i hits %lu misses %lu (%llu%%)",
+				   order, pcp->count, pcp->high, pcp->batch,
+				   pcp->hits, pcp->misses, total ?
+				   div64_u64((u64)pcp->hits * 100, total) : 0);
+		}
 #ifdef CONFIG_SMP
 		seq_printf(m, "\n  vm stats threshold: %d",
 				pageset->stat_threshold);